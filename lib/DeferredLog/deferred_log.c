@@ -0,0 +1,355 @@
+/**
+ * @file deferred_log.c
+ * @brief Implementation of the deferred log ring.
+ *
+ * Writers claim an entry by incrementing `write_index`, so several tasks can
+ * log at once without a lock, and publish it with a sequence lock: the
+ * sequence of the slot is odd while the entry is written, and even once it
+ * holds the entry of a given index. Readers copy an entry and check the
+ * sequence again afterwards, so an entry overwritten in the meantime is
+ * detected rather than printed garbled.
+ *
+ * The entries hold pointers into the firmware image, so they are kept in
+ * ordinary RAM and do not survive a reset.
+ */
+
+#include "deferred_log.h"
+#include "metrics.h"
+#include "utils.h"
+
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define DEFERRED_LOG_LINE_SIZE 160  ///< Size of a formatted message, in bytes, longer messages are truncated.
+
+_Static_assert((DEFERRED_LOG_CAPACITY & (DEFERRED_LOG_CAPACITY - 1)) == 0, "The ring capacity must be a power of two");
+
+/**
+ * @brief Log entry, as stored by the writer.
+ */
+typedef struct deferred_log_record_s {
+    uint32_t timestamp_ms;                 ///< Time of the entry, as `esp_log_timestamp()`.
+    const char *tag;                       ///< Tag of the entry.
+    const char *format;                    ///< printf-style format string of the entry.
+    uint32_t args[DEFERRED_LOG_MAX_ARGS];  ///< Arguments of the entry, as raw 32-bit words.
+    esp_log_level_t level;                 ///< Level of the entry.
+} deferred_log_record_st;
+
+/**
+ * @brief Slot of the ring, guarded by a sequence lock.
+ *
+ * The sequence is `2 * index + 1` while the entry of `index` is written, and
+ * `2 * index + 2` once it is complete.
+ */
+typedef struct deferred_log_slot_s {
+    atomic_uint sequence;           ///< Update counter, odd during an update.
+    deferred_log_record_st record;  ///< Entry held by the slot.
+} deferred_log_slot_st;
+
+static const char *TAG                      = "Log Task";  ///< Tag for logging.
+static const uint32_t LOG_FLUSH_INTERVAL_MS = 100;         ///< Interval between two flushes of the ring, in milliseconds.
+
+static deferred_log_slot_st slots[DEFERRED_LOG_CAPACITY] = {0};  ///< Ring of entries.
+static atomic_uint write_index                           = 0;    ///< Index of the next entry to write.
+static uint32_t read_index                               = 0;    ///< Index of the next entry to print, owned by the log task.
+
+/**
+ * @brief Count the arguments a format string consumes.
+ *
+ * Every conversion but `%%` takes one argument, and so does every `*` width
+ * or precision.
+ *
+ * @param[in] format printf-style format string.
+ *
+ * @return Number of arguments, at most `DEFERRED_LOG_MAX_ARGS`.
+ */
+static size_t deferred_log_count_args(const char *format) {
+    size_t count = 0;
+
+    while ((*format != '\0') && (count < DEFERRED_LOG_MAX_ARGS)) {
+        if (*format++ != '%') {
+            continue;
+        }
+        if (*format == '%') {
+            format++;
+            continue;
+        }
+        while ((*format != '\0') && (strchr("diouxXcspn", *format) == NULL)) {
+            if (*format == '*') {
+                count++;
+            }
+            format++;
+        }
+        if (*format != '\0') {
+            format++;
+            count++;
+        }
+    }
+
+    return (count < DEFERRED_LOG_MAX_ARGS) ? count : DEFERRED_LOG_MAX_ARGS;
+}
+
+/**
+ * @brief Store a log entry in the ring.
+ *
+ * Safe to call from any task, never blocks. Use the `DEFERRED_LOG*` macros.
+ *
+ * @param[in] level  Level of the entry.
+ * @param[in] tag    Tag of the entry, must outlive it.
+ * @param[in] format printf-style format string literal.
+ */
+void deferred_log_write(esp_log_level_t level, const char *tag, const char *format, ...) {
+    unsigned index             = atomic_fetch_add_explicit(&write_index, 1, memory_order_relaxed);
+    deferred_log_slot_st *slot = &slots[index & (DEFERRED_LOG_CAPACITY - 1)];
+    size_t arg_count           = deferred_log_count_args(format);
+    va_list args;
+
+    atomic_store_explicit(&slot->sequence, (2 * index) + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    slot->record.timestamp_ms = esp_log_timestamp();
+    slot->record.tag          = tag;
+    slot->record.format       = format;
+    slot->record.level        = level;
+
+    va_start(args, format);
+    for (size_t i = 0; i < DEFERRED_LOG_MAX_ARGS; i++) {
+        slot->record.args[i] = (i < arg_count) ? va_arg(args, uint32_t) : 0;
+    }
+    va_end(args);
+
+    atomic_store_explicit(&slot->sequence, (2 * index) + 2, memory_order_release);
+}
+
+/**
+ * @brief Copy the entry of an index out of the ring.
+ *
+ * @param[in]  index          Index of the entry.
+ * @param[out] record         Copy of the entry.
+ * @param[out] is_overwritten Set when the entry was overwritten by a newer one.
+ *
+ * @return true if the entry was copied, false if it is still being written or
+ *         was overwritten.
+ */
+static bool deferred_log_read(uint32_t index, deferred_log_record_st *record, bool *is_overwritten) {
+    const deferred_log_slot_st *slot = &slots[index & (DEFERRED_LOG_CAPACITY - 1)];
+    uint32_t expected                = (2 * index) + 2;
+
+    uint32_t before = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    *record         = slot->record;
+    atomic_thread_fence(memory_order_acquire);
+    uint32_t after = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+
+    *is_overwritten = ((int32_t)(after - expected) > 0);
+
+    return (before == expected) && (after == expected);
+}
+
+/**
+ * @brief Format the message of an entry.
+ *
+ * The arguments are passed back as 32-bit words, which matches how the
+ * 32-bit integer and pointer arguments were passed to the writer.
+ *
+ * @param[in]  record Entry to format.
+ * @param[out] line   Buffer receiving the message, NUL-terminated.
+ * @param[in]  size   Size of the buffer, in bytes.
+ */
+static void deferred_log_format(const deferred_log_record_st *record, char *line, size_t size) {
+    snprintf(line, size, record->format, record->args[0], record->args[1], record->args[2], record->args[3]);
+}
+
+/**
+ * @brief Get the letter of a log level, as printed by ESP_LOG.
+ *
+ * @param[in] level Log level.
+ *
+ * @return Letter of the level.
+ */
+static char deferred_log_level_letter(esp_log_level_t level) {
+    switch (level) {
+        case ESP_LOG_ERROR:
+            return 'E';
+        case ESP_LOG_WARN:
+            return 'W';
+        case ESP_LOG_INFO:
+            return 'I';
+        case ESP_LOG_DEBUG:
+            return 'D';
+        default:
+            return 'V';
+    }
+}
+
+/**
+ * @brief Print every complete entry not printed yet.
+ *
+ * Stops at the first entry still being written, so the entries are printed
+ * in order. Entries overwritten before they could be printed are counted.
+ */
+static void deferred_log_flush(void) {
+    char line[DEFERRED_LOG_LINE_SIZE];
+    deferred_log_record_st record;
+    bool is_overwritten = false;
+
+    uint32_t written = atomic_load_explicit(&write_index, memory_order_relaxed);
+    if ((written - read_index) > DEFERRED_LOG_CAPACITY) {
+        metrics_counter_add(METRICS_COUNTER_LOG_OVERRUNS, (written - read_index) - DEFERRED_LOG_CAPACITY);
+        read_index = written - DEFERRED_LOG_CAPACITY;
+    }
+
+    while (read_index != written) {
+        if (!deferred_log_read(read_index, &record, &is_overwritten)) {
+            if (!is_overwritten) {
+                break;
+            }
+            metrics_counter_add(METRICS_COUNTER_LOG_OVERRUNS, 1);
+            read_index++;
+            continue;
+        }
+
+        deferred_log_format(&record, line, sizeof(line));
+        esp_log_write(record.level, record.tag, "%c (%lu) %s: %s\n", deferred_log_level_letter(record.level),
+                      (unsigned long)record.timestamp_ms, record.tag, line);
+        read_index++;
+    }
+}
+
+/**
+ * @brief Append a JSON string to a document.
+ *
+ * Quotes and backslashes are escaped, control characters are replaced by
+ * spaces.
+ *
+ * @param[out]    buffer Buffer holding the document.
+ * @param[in]     size   Size of the buffer, in bytes.
+ * @param[in,out] length Length of the document, in bytes.
+ * @param[in]     text   Text of the string.
+ *
+ * @return true if the string fits in the buffer.
+ */
+static bool deferred_log_append_string(char *buffer, size_t size, size_t *length, const char *text) {
+    size_t position = *length;
+
+    if (position >= size - 1) {
+        return false;
+    }
+    buffer[position++] = '"';
+
+    for (; *text != '\0'; text++) {
+        bool is_escaped = (*text == '"') || (*text == '\\');
+        if (position + (is_escaped ? 2 : 1) >= size) {
+            return false;
+        }
+        if (is_escaped) {
+            buffer[position++] = '\\';
+        }
+        buffer[position++] = ((unsigned char)*text < 0x20) ? ' ' : *text;
+    }
+
+    if (position >= size - 1) {
+        return false;
+    }
+    buffer[position++] = '"';
+    buffer[position]   = '\0';
+    *length            = position;
+
+    return true;
+}
+
+/**
+ * @brief Format the last entries of the ring as a JSON document, newest first.
+ *
+ * Entries that do not fit in the buffer are left out, oldest first.
+ *
+ * @param[out] buffer Buffer receiving the document, NUL-terminated.
+ * @param[in]  size   Size of the buffer, in bytes.
+ * @param[in]  count  Largest number of entries to format.
+ * @param[out] length Length of the document, in bytes.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid parameters or
+ *         ESP_ERR_NO_MEM if not even an empty document fits in the buffer.
+ */
+esp_err_t deferred_log_format_json(char *buffer, size_t size, size_t count, size_t *length) {
+    static const char *CLOSING = "]}";  ///< End of the document, room is kept for it.
+
+    if ((buffer == NULL) || (size <= strlen(CLOSING)) || (length == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    char line[DEFERRED_LOG_LINE_SIZE];
+    deferred_log_record_st record;
+    bool is_overwritten = false;
+    size_t body_size    = size - strlen(CLOSING);
+    size_t entry_count  = 0;
+
+    *length = 0;
+    if (!format_append(buffer, body_size, length, "{\"logs\": [")) {
+        buffer[0] = '\0';
+        *length   = 0;
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint32_t index = atomic_load_explicit(&write_index, memory_order_relaxed);
+    if (count > DEFERRED_LOG_CAPACITY) {
+        count = DEFERRED_LOG_CAPACITY;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        index--;
+        if (!deferred_log_read(index, &record, &is_overwritten)) {
+            continue;
+        }
+
+        size_t entry_start = *length;
+        deferred_log_format(&record, line, sizeof(line));
+
+        bool is_fitting = format_append(buffer, body_size, length, "%s{\"time_ms\": %lu, \"level\": \"%c\", \"tag\": ",
+                                              (entry_count > 0) ? ", " : "", (unsigned long)record.timestamp_ms,
+                                              deferred_log_level_letter(record.level));
+        is_fitting = is_fitting && deferred_log_append_string(buffer, body_size, length, record.tag);
+        is_fitting = is_fitting && format_append(buffer, body_size, length, ", \"message\": ");
+        is_fitting = is_fitting && deferred_log_append_string(buffer, body_size, length, line);
+        is_fitting = is_fitting && format_append(buffer, body_size, length, "}");
+
+        if (!is_fitting) {
+            *length = entry_start;
+            break;
+        }
+        entry_count++;
+    }
+
+    format_append(buffer, size, length, "%s", CLOSING);
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Main execution function of the log task.
+ *
+ * Formats and writes the entries of the ring every `LOG_FLUSH_INTERVAL_MS`.
+ * Runs at a low priority, so formatting never delays the sensor and network
+ * tasks.
+ *
+ * @param[in] pvParameters Pointer to the firmware event group handle, unused.
+ */
+void deferred_log_task_execute(void *pvParameters) {
+    (void)pvParameters;
+
+    ESP_LOGI(TAG, "Starting log task execution...");
+
+    metrics_register_task();
+
+    TickType_t last_wake_time = xTaskGetTickCount();
+
+    while (1) {
+        deferred_log_flush();
+        xTaskDelayUntil(&last_wake_time, pdMS_TO_TICKS(LOG_FLUSH_INTERVAL_MS));
+    }
+}
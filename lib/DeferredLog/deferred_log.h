@@ -0,0 +1,97 @@
+#ifndef DEFERRED_LOG_H
+#define DEFERRED_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+
+/**
+ * @file deferred_log.h
+ * @brief Deferred logging for the hot paths, formatted by a low-priority task.
+ *
+ * `DEFERRED_LOGE()` and its siblings do not format anything: they store the
+ * pointers to the tag and the format string, the arguments and a timestamp
+ * in a lock-free RAM ring, which costs a few hundred nanoseconds and never
+ * blocks, from any task and either core. The log task formats the entries
+ * later and writes them with `esp_log_write()`, where the usual level
+ * filtering applies. The ring keeps the last `DEFERRED_LOG_CAPACITY`
+ * entries; an entry overwritten before it was printed is lost for the
+ * console, and counted in `METRICS_COUNTER_LOG_OVERRUNS`.
+ *
+ * Since the arguments are copied as raw 32-bit words, the format string must
+ * be a literal and take at most `DEFERRED_LOG_MAX_ARGS` 32-bit integer or
+ * pointer arguments; 64-bit and floating point conversions are not
+ * supported. A `%s` argument must outlive the entry, like a string literal
+ * or the name returned by `esp_err_to_name()`.
+ *
+ * The last entries can be dumped on demand with `deferred_log_format_json()`,
+ * newest first:
+ *
+ *   {"logs": [{"time_ms": 81234, "level": "W", "tag": "MQTT Task", "message": "..."}, ...]}
+ */
+
+#define DEFERRED_LOG_CAPACITY 64  ///< Number of entries the ring keeps, a power of two.
+#define DEFERRED_LOG_MAX_ARGS 4   ///< Largest number of arguments of an entry.
+
+/** @brief Log an error without blocking. */
+#define DEFERRED_LOGE(tag, format, ...) deferred_log_write(ESP_LOG_ERROR, tag, format, ##__VA_ARGS__)
+/** @brief Log a warning without blocking. */
+#define DEFERRED_LOGW(tag, format, ...) deferred_log_write(ESP_LOG_WARN, tag, format, ##__VA_ARGS__)
+/** @brief Log an information message without blocking. */
+#define DEFERRED_LOGI(tag, format, ...) deferred_log_write(ESP_LOG_INFO, tag, format, ##__VA_ARGS__)
+
+/**
+ * @brief Non-blocking counterpart of `ESP_ERROR_CHECK_WITHOUT_ABORT()`.
+ *
+ * Evaluates the expression and logs a deferred error if it is not ESP_OK.
+ *
+ * @return Value of the expression.
+ */
+#define DEFERRED_ERROR_CHECK_WITHOUT_ABORT(tag, x) ({                                 \
+        esp_err_t deferred_err_rc_ = (x);                                           \
+        if (deferred_err_rc_ != ESP_OK) {                                           \
+            DEFERRED_LOGE(tag, "%s failed: %s", #x, esp_err_to_name(deferred_err_rc_)); \
+        }                                                                           \
+        deferred_err_rc_;                                                           \
+    })
+
+/**
+ * @brief Store a log entry in the ring.
+ *
+ * Safe to call from any task, never blocks. Use the `DEFERRED_LOG*` macros.
+ *
+ * @param[in] level  Level of the entry.
+ * @param[in] tag    Tag of the entry, must outlive it.
+ * @param[in] format printf-style format string literal.
+ */
+void deferred_log_write(esp_log_level_t level, const char *tag, const char *format, ...) __attribute__((format(printf, 3, 4)));
+
+/**
+ * @brief Format the last entries of the ring as a JSON document, newest first.
+ *
+ * Entries that do not fit in the buffer are left out, oldest first.
+ *
+ * @param[out] buffer Buffer receiving the document, NUL-terminated.
+ * @param[in]  size   Size of the buffer, in bytes.
+ * @param[in]  count  Largest number of entries to format.
+ * @param[out] length Length of the document, in bytes.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid parameters or
+ *         ESP_ERR_NO_MEM if not even an empty document fits in the buffer.
+ */
+esp_err_t deferred_log_format_json(char *buffer, size_t size, size_t count, size_t *length);
+
+/**
+ * @brief Main execution function of the log task.
+ *
+ * Formats and writes the entries of the ring every `LOG_FLUSH_INTERVAL_MS`.
+ * Runs at a low priority, so formatting never delays the sensor and network
+ * tasks.
+ *
+ * @param[in] pvParameters Pointer to the firmware event group handle, unused.
+ */
+void deferred_log_task_execute(void *pvParameters);
+
+#endif /* DEFERRED_LOG_H */
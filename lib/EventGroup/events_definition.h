@@ -11,10 +11,18 @@
  * - WIFI_CONNECTED_STA: Indicates that the device has successfully connected to a network in station (STA) mode.
  * - WIFI_CONNECTED_AP: Indicates that the device has successfully established a network in access point (AP) mode.
  * - TIME_SYNCED: Indicates that the system time has been successfully synchronized with an external time source.
+ * - SENSOR_DATA_READY: Indicates that new samples were pushed to the sensor data ring.
+ * - MQTT_CONNECTED: Indicates that the MQTT client holds an active session with the broker.
+ * - LIVE_DATA_READY: Indicates that a sweep updated the latest reading of at least one sensor.
+ * - NETWORK_STATUS_CHANGED: Indicates that the station connection status reported by the network task changed.
  *
  */
 #define WIFI_CONNECTED_STA BIT0
 #define WIFI_CONNECTED_AP BIT1
 #define TIME_SYNCED BIT2
+#define SENSOR_DATA_READY BIT3
+#define MQTT_CONNECTED BIT4
+#define LIVE_DATA_READY BIT5
+#define NETWORK_STATUS_CHANGED BIT6
 
 #endif /* EVENTS_DEFINITION_H */
\ No newline at end of file
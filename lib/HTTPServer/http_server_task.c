@@ -1,10 +1,21 @@
 #include "esp_log.h"
+#include "esp_netif.h"
+#include "lwip/sockets.h"
 
 #include "events_definition.h"
 #include "http_server_task.h"
+#include "logs_endpoint.h"
+#include "metrics.h"
+#include "metrics_endpoint.h"
 #include "network_task.h"
+#include "status_endpoint.h"
+#include "telemetry_ws.h"
+#include "web_assets.h"
+
+#include <string.h>
 
 static const char* TAG            = "HTTP Server Task"; /**< Logging tag for HTTPServerProcess class. */
+static const uint32_t POLL_MS     = 1000;               /**< Longest sleep while serving, expires the long-polled requests. */
 static httpd_config_t config      = HTTPD_DEFAULT_CONFIG();
 static httpd_handle_t http_server = NULL;
 static bool is_server_connected   = false;
@@ -20,95 +31,83 @@ static bool is_server_connected   = false;
  */
 static EventGroupHandle_t* firmware_event_group = NULL;
 
-extern const uint8_t bin_data_index_html_start[] asm("_binary_index_html_start");          /**< Start of index.html binary data. */
-extern const uint8_t bin_data_index_html_end[] asm("_binary_index_html_end");              /**< End of index.html binary data. */
-extern const uint8_t bin_data_styles_css_start[] asm("_binary_styles_css_start");          /**< Start of styles.css binary data. */
-extern const uint8_t bin_data_styles_css_end[] asm("_binary_styles_css_end");              /**< End of styles.css binary data. */
-extern const uint8_t bin_data_app_js_start[] asm("_binary_app_js_start");                  /**< Start of app.js binary data. */
-extern const uint8_t bin_data_app_js_end[] asm("_binary_app_js_end");                      /**< End of app.js binary data. */
-extern const uint8_t bin_data_jquery3_js_start[] asm("_binary_jquery_3_3_1_min_js_start"); /**< Start of jquery-3.3.1.min.js binary data. */
-extern const uint8_t bin_data_jquery3_js_end[] asm("_binary_jquery_3_3_1_min_js_end");     /**< End of jquery-3.3.1.min.js binary data. */
-extern const uint8_t bin_data_favicon_ico_start[] asm("_binary_favicon_ico_start");        /**< Start of favicon.ico binary data. */
-extern const uint8_t bin_data_favicon_ico_end[] asm("_binary_favicon_ico_end");            /**< End of favicon.ico binary data. */
-
 /**
- * @brief HTTP GET handler for serving index.html.
+ * @brief HTTP GET handler for serving the embedded web assets.
  *
- * @param[in] req HTTP request object.
- * @return ESP_OK on success, or an error code on failure.
- */
-static esp_err_t get_uri_index_html(httpd_req_t* req) {
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_send(req,
-                    (const char*)(bin_data_index_html_start),
-                    bin_data_index_html_end - bin_data_index_html_start);
-
-    return ESP_OK;
-}
-
-/**
- * @brief HTTP GET handler for serving styles.css.
+ * Registered once for every URI, the asset is looked up in the table
+ * generated at build time. Assets are sent as stored, with `Content-Encoding: gzip` when they are compressed, along
+ * with their ETag and caching policy. A request whose `If-None-Match` header
+ * holds the current ETag gets an empty 304 response.
  *
  * @param[in] req HTTP request object.
  * @return ESP_OK on success, or an error code on failure.
  */
-static esp_err_t get_uri_get_app_css(httpd_req_t* req) {
-    httpd_resp_set_type(req, "text/css");
-    httpd_resp_send(req,
-                    (const char*)(bin_data_styles_css_start),
-                    bin_data_styles_css_end - bin_data_styles_css_start);
+static esp_err_t get_uri_web_asset(httpd_req_t* req) {
+    const web_asset_st* asset = web_assets_find(req->uri);
+    char if_none_match[128]   = {0};
 
-    return ESP_OK;
-}
+    if (asset == NULL) {
+        return httpd_resp_send_404(req);
+    }
 
-/**
- * @brief HTTP GET handler for serving app.js.
- *
- * @param[in] req HTTP request object.
- * @return ESP_OK on success, or an error code on failure.
- */
-static esp_err_t get_uri_get_app_js(httpd_req_t* req) {
-    httpd_resp_set_type(req, "text/javascript");
-    httpd_resp_send(req,
-                    (const char*)(bin_data_app_js_start),
-                    bin_data_app_js_end - bin_data_app_js_start - 1);
+    httpd_resp_set_hdr(req, "ETag", asset->etag);
+    httpd_resp_set_hdr(req, "Cache-Control", asset->cache_control);
 
-    return ESP_OK;
-}
+    if ((httpd_req_get_hdr_value_str(req, "If-None-Match", if_none_match, sizeof(if_none_match)) == ESP_OK) &&
+        (strstr(if_none_match, asset->etag) != NULL)) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
 
-/**
- * @brief HTTP GET handler for serving jquery-3.3.1.min.js.
- *
- * @param[in] req HTTP request object.
- * @return ESP_OK on success, or an error code on failure.
- */
-static esp_err_t get_uri_get_jquery_js(httpd_req_t* req) {
-    httpd_resp_set_type(req, "text/javascript");
-    httpd_resp_send(
-        req, (const char*)(bin_data_jquery3_js_start),
-        bin_data_jquery3_js_end - bin_data_jquery3_js_start - 1);
+    httpd_resp_set_type(req, asset->content_type);
+    if (asset->is_gzip) {
+        httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    }
 
-    return ESP_OK;
+    return httpd_resp_send(req, (const char*)asset->data, asset->length);
 }
 
 /**
- * @brief HTTP GET handler for serving favicon.ico.
+ * @brief Check whether a request was received on the provisioning Access Point.
+ *
+ * Compares the local address of the connection with the address of the
+ * Access Point interface. The server listens on an IPv6 socket when lwIP has
+ * IPv6 enabled, IPv4 clients then show up with IPv4-mapped addresses.
  *
  * @param[in] req HTTP request object.
- * @return ESP_OK on success, or an error code on failure.
+ *
+ * @return true if the client joined the provisioning Access Point.
  */
-static esp_err_t get_uri_favicon_icon(httpd_req_t* req) {
-    httpd_resp_set_type(req, "image/x-icon");
-    httpd_resp_send(
-        req, (const char*)(bin_data_favicon_ico_start),
-        bin_data_favicon_ico_end - bin_data_favicon_ico_start);
+static bool is_request_on_access_point(httpd_req_t* req) {
+    struct sockaddr_storage local_address = {0};
+    socklen_t address_length              = sizeof(local_address);
+    esp_netif_ip_info_t ap_ip_info        = {0};
+    esp_netif_t* ap_netif                 = esp_netif_get_handle_from_ifkey("WIFI_AP_DEF");
+    uint32_t address                      = 0;
+
+    if ((ap_netif == NULL) || (esp_netif_get_ip_info(ap_netif, &ap_ip_info) != ESP_OK) ||
+        (getsockname(httpd_req_to_sockfd(req), (struct sockaddr*)&local_address, &address_length) != 0)) {
+        return false;
+    }
+
+    if (local_address.ss_family == AF_INET) {
+        address = ((struct sockaddr_in*)&local_address)->sin_addr.s_addr;
+    } else if (local_address.ss_family == AF_INET6) {
+        memcpy(&address, &((struct sockaddr_in6*)&local_address)->sin6_addr.s6_addr[12], sizeof(address));
+    }
 
-    return ESP_OK;
+    return (address != 0) && (address == ap_ip_info.ip.addr);
 }
 
 /**
  * @brief HTTP POST handler for processing WiFi credentials.
  *
+ * The network task starts connecting as soon as the credentials are stored.
+ * The response carries the connection status, whose version the UI then
+ * long-polls `/status.json` with to follow the progress. Credentials are
+ * only accepted from the provisioning Access Point, so a client of the
+ * station network cannot move the device to another network.
+ *
  * @param[in] req HTTP request object.
  * @return ESP_OK on success, or an error code on failure.
  */
@@ -120,6 +119,11 @@ static esp_err_t post_uri_wifi_credentials(httpd_req_t* req) {
     uint8_t ssid_len = httpd_req_get_hdr_value_len(req, "my-connected-ssid") + 1;
     uint8_t pwd_len  = httpd_req_get_hdr_value_len(req, "my-connected-pwd") + 1;
 
+    if (!is_request_on_access_point(req)) {
+        httpd_resp_send_err(req, HTTPD_403_FORBIDDEN, "Credentials are only accepted on the provisioning Access Point");
+        return ESP_FAIL;
+    }
+
     do {
         if (ssid_len <= 0) {
             httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
@@ -150,7 +154,12 @@ static esp_err_t post_uri_wifi_credentials(httpd_req_t* req) {
         password[pwd_len] = '\0';
 
         result = network_set_credentials(ssid, password);
+        if (result != ESP_OK) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid credentials!");
+            break;
+        }
 
+        result = status_endpoint_send(req);
     } while (0);
 
     return result;
@@ -158,40 +167,17 @@ static esp_err_t post_uri_wifi_credentials(httpd_req_t* req) {
 
 /**
  * @brief Initializes the list of HTTP request URIs and their corresponding handlers.
+ *
+ * A single wildcard GET handler serves every embedded web asset, so adding
+ * assets does not consume URI handlers. The status, metrics and live
+ * telemetry endpoints are registered first so the wildcard does not shadow
+ * them.
  */
 esp_err_t initialize_request_list(void) {
-    static const httpd_uri_t uri_index_html = {
-        .uri      = "/",
+    static const httpd_uri_t uri_get_web_asset = {
+        .uri      = "/*",
         .method   = HTTP_GET,
-        .handler  = get_uri_index_html,
-        .user_ctx = NULL,
-    };
-
-    static const httpd_uri_t uri_get_styles_css = {
-        .uri      = "/styles.css",
-        .method   = HTTP_GET,
-        .handler  = get_uri_get_app_css,
-        .user_ctx = NULL,
-    };
-
-    static const httpd_uri_t uri_get_app_js = {
-        .uri      = "/app.js",
-        .method   = HTTP_GET,
-        .handler  = get_uri_get_app_js,
-        .user_ctx = NULL,
-    };
-
-    static const httpd_uri_t uri_get_jquery_js = {
-        .uri      = "/jquery-3.3.1.min.js",
-        .method   = HTTP_GET,
-        .handler  = get_uri_get_jquery_js,
-        .user_ctx = NULL,
-    };
-
-    static const httpd_uri_t uri_get_favicon_ico = {
-        .uri      = "/favicon.ico",
-        .method   = HTTP_GET,
-        .handler  = get_uri_favicon_icon,
+        .handler  = get_uri_web_asset,
         .user_ctx = NULL,
     };
 
@@ -203,15 +189,14 @@ esp_err_t initialize_request_list(void) {
     };
 
     esp_err_t result = ESP_OK;
-    result += httpd_register_uri_handler(http_server, &uri_index_html);
-    ESP_ERROR_CHECK_WITHOUT_ABORT(result);
-    result += httpd_register_uri_handler(http_server, &uri_get_styles_css);
+    result += status_endpoint_register(http_server);
     ESP_ERROR_CHECK_WITHOUT_ABORT(result);
-    result += httpd_register_uri_handler(http_server, &uri_get_app_js);
+    result += metrics_endpoint_register(http_server);
     ESP_ERROR_CHECK_WITHOUT_ABORT(result);
-    result += httpd_register_uri_handler(http_server, &uri_get_jquery_js);
+    result += logs_endpoint_register(http_server);
     ESP_ERROR_CHECK_WITHOUT_ABORT(result);
-    result += httpd_register_uri_handler(http_server, &uri_get_favicon_ico);
+    ESP_ERROR_CHECK_WITHOUT_ABORT(telemetry_ws_register(http_server));
+    result += httpd_register_uri_handler(http_server, &uri_get_web_asset);
     ESP_ERROR_CHECK_WITHOUT_ABORT(result);
     result += httpd_register_uri_handler(http_server, &uri_post_credentials);
     ESP_ERROR_CHECK_WITHOUT_ABORT(result);
@@ -225,8 +210,7 @@ esp_err_t initialize_request_list(void) {
  * @return ESP_OK on success, or an error code on failure.
  */
 esp_err_t start_http_server(void) {
-    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-    esp_err_t result      = httpd_start(&http_server, &config);
+    esp_err_t result = httpd_start(&http_server, &config);
     if (result == ESP_OK) {
         ESP_LOGI(TAG, "HTTP server started successfully");
         initialize_request_list();
@@ -244,6 +228,7 @@ esp_err_t start_http_server(void) {
  */
 void stop_http_server(void) {
     if (http_server) {
+        status_endpoint_process(true);
         httpd_stop(http_server);
         http_server         = NULL;
         is_server_connected = false;
@@ -262,6 +247,7 @@ static esp_err_t http_server_task_initialize(void) {
     config.send_wait_timeout = 10;
     config.recv_wait_timeout = 10;
     config.max_uri_handlers  = 20;
+    config.uri_match_fn      = httpd_uri_match_wildcard;
 
     return result;
 }
@@ -271,6 +257,15 @@ static esp_err_t http_server_task_initialize(void) {
  *
  * This function initializes and starts the HTTP server, enabling the ESP32 to
  * handle incoming web requests. It processes requests in a FreeRTOS task.
+ * The server runs while a client is connected to the provisioning Access
+ * Point or the station is connected, so the metrics, the logs and the live
+ * telemetry stay reachable from the station network once the device is
+ * provisioned; until then the task blocks on `WIFI_CONNECTED_AP` and
+ * `WIFI_CONNECTED_STA`. While
+ * serving, it sleeps on `LIVE_DATA_READY` and `NETWORK_STATUS_CHANGED`,
+ * forwarding every sweep of the temperature monitor to the live telemetry
+ * clients and every connection status change to the long-polled status
+ * requests.
  *
  * @param[in] pvParameters Pointer to task parameters (TaskHandle_t).
  */
@@ -280,23 +275,35 @@ void http_server_task_execute(void* pvParameters) {
         vTaskDelete(NULL);
     }
 
+    metrics_register_task();
+
     while (1) {
-        EventBits_t firmware_event_bits = xEventGroupWaitBits(*firmware_event_group,
-                                                              WIFI_CONNECTED_AP,
-                                                              pdFALSE,
-                                                              pdFALSE,
-                                                              pdMS_TO_TICKS(100));
-
-        if (is_server_connected) {
-            if ((firmware_event_bits & WIFI_CONNECTED_AP) == 0) {
-                stop_http_server();
-            }
-        } else {
-            if (firmware_event_bits & WIFI_CONNECTED_AP) {
-                start_http_server();
+        if (!is_server_connected) {
+            // Nothing to serve until a client joins the provisioning Access Point or the station is connected.
+            xEventGroupWaitBits(*firmware_event_group, WIFI_CONNECTED_AP | WIFI_CONNECTED_STA, pdFALSE, pdFALSE,
+                                portMAX_DELAY);
+            if (start_http_server() != ESP_OK) {
+                vTaskDelay(pdMS_TO_TICKS(POLL_MS));
             }
+            continue;
         }
 
-        vTaskDelay(pdMS_TO_TICKS(1000));
+        EventBits_t update_event_bits = xEventGroupWaitBits(*firmware_event_group,
+                                                            LIVE_DATA_READY | NETWORK_STATUS_CHANGED,
+                                                            pdTRUE,
+                                                            pdFALSE,
+                                                            pdMS_TO_TICKS(POLL_MS));
+
+        if ((xEventGroupGetBits(*firmware_event_group) & (WIFI_CONNECTED_AP | WIFI_CONNECTED_STA)) == 0) {
+            stop_http_server();
+            continue;
+        }
+
+        // Also runs on the timeout, which expires the long-polled requests.
+        status_endpoint_process(false);
+
+        if (update_event_bits & LIVE_DATA_READY) {
+            telemetry_ws_broadcast(http_server);
+        }
     }
 }
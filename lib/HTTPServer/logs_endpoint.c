@@ -0,0 +1,57 @@
+/**
+ * @file logs_endpoint.c
+ * @brief Implementation of the deferred log endpoint.
+ */
+
+#include "deferred_log.h"
+#include "logs_endpoint.h"
+
+#define LOGS_BODY_SIZE 4096    ///< Size of the response body buffer, in bytes.
+#define LOGS_URI "/logs.json"  ///< URI of the endpoint.
+
+/**
+ * @brief Response body, too large for the stack of the server task.
+ *
+ * The server runs its handlers one at a time, so a single buffer suffices.
+ */
+static char logs_body[LOGS_BODY_SIZE] = {0};
+
+/**
+ * @brief HTTP GET handler of the deferred log endpoint.
+ *
+ * @param[in] req HTTP request object.
+ * @return ESP_OK on success, or an error code on failure.
+ */
+static esp_err_t get_uri_logs(httpd_req_t* req) {
+    size_t length = 0;
+
+    if (deferred_log_format_json(logs_body, sizeof(logs_body), DEFERRED_LOG_CAPACITY, &length) != ESP_OK) {
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Logs do not fit");
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    return httpd_resp_send(req, logs_body, length);
+}
+
+/**
+ * @brief Register the deferred log endpoint on a running server.
+ *
+ * Must be called before any wildcard handler that would also match the
+ * endpoint URI.
+ *
+ * @param[in] server Handle of the HTTP server.
+ *
+ * @return ESP_OK on success, or an error code on failure.
+ */
+esp_err_t logs_endpoint_register(httpd_handle_t server) {
+    static const httpd_uri_t uri_get_logs = {
+        .uri      = LOGS_URI,
+        .method   = HTTP_GET,
+        .handler  = get_uri_logs,
+        .user_ctx = NULL,
+    };
+
+    return httpd_register_uri_handler(server, &uri_get_logs);
+}
@@ -0,0 +1,27 @@
+#ifndef LOGS_ENDPOINT_H
+#define LOGS_ENDPOINT_H
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+/**
+ * @file logs_endpoint.h
+ * @brief Deferred log endpoint.
+ *
+ * `GET /logs.json` returns the last entries of the deferred log, newest
+ * first, in the format described in `deferred_log.h`.
+ */
+
+/**
+ * @brief Register the deferred log endpoint on a running server.
+ *
+ * Must be called before any wildcard handler that would also match the
+ * endpoint URI.
+ *
+ * @param[in] server Handle of the HTTP server.
+ *
+ * @return ESP_OK on success, or an error code on failure.
+ */
+esp_err_t logs_endpoint_register(httpd_handle_t server);
+
+#endif /* LOGS_ENDPOINT_H */
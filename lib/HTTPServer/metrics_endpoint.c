@@ -0,0 +1,57 @@
+/**
+ * @file metrics_endpoint.c
+ * @brief Implementation of the runtime metrics endpoint.
+ */
+
+#include "metrics.h"
+#include "metrics_endpoint.h"
+
+#define METRICS_BODY_SIZE 2048       ///< Size of the response body buffer, in bytes.
+#define METRICS_URI "/metrics.json"  ///< URI of the endpoint.
+
+/**
+ * @brief Response body, too large for the stack of the server task.
+ *
+ * The server runs its handlers one at a time, so a single buffer suffices.
+ */
+static char metrics_body[METRICS_BODY_SIZE] = {0};
+
+/**
+ * @brief HTTP GET handler of the metrics endpoint.
+ *
+ * @param[in] req HTTP request object.
+ * @return ESP_OK on success, or an error code on failure.
+ */
+static esp_err_t get_uri_metrics(httpd_req_t* req) {
+    size_t length = 0;
+
+    if (metrics_format_json(metrics_body, sizeof(metrics_body), &length) != ESP_OK) {
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Metrics do not fit");
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    return httpd_resp_send(req, metrics_body, length);
+}
+
+/**
+ * @brief Register the metrics endpoint on a running server.
+ *
+ * Must be called before any wildcard handler that would also match the
+ * endpoint URI.
+ *
+ * @param[in] server Handle of the HTTP server.
+ *
+ * @return ESP_OK on success, or an error code on failure.
+ */
+esp_err_t metrics_endpoint_register(httpd_handle_t server) {
+    static const httpd_uri_t uri_get_metrics = {
+        .uri      = METRICS_URI,
+        .method   = HTTP_GET,
+        .handler  = get_uri_metrics,
+        .user_ctx = NULL,
+    };
+
+    return httpd_register_uri_handler(server, &uri_get_metrics);
+}
@@ -0,0 +1,27 @@
+#ifndef METRICS_ENDPOINT_H
+#define METRICS_ENDPOINT_H
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+/**
+ * @file metrics_endpoint.h
+ * @brief Runtime metrics endpoint.
+ *
+ * `GET /metrics.json` returns a snapshot of the runtime metrics, in the
+ * format described in `metrics.h`.
+ */
+
+/**
+ * @brief Register the metrics endpoint on a running server.
+ *
+ * Must be called before any wildcard handler that would also match the
+ * endpoint URI.
+ *
+ * @param[in] server Handle of the HTTP server.
+ *
+ * @return ESP_OK on success, or an error code on failure.
+ */
+esp_err_t metrics_endpoint_register(httpd_handle_t server);
+
+#endif /* METRICS_ENDPOINT_H */
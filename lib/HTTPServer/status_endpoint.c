@@ -0,0 +1,253 @@
+/**
+ * @file status_endpoint.c
+ * @brief Implementation of the connection status endpoint.
+ */
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "network_task.h"
+#include "status_endpoint.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define STATUS_MAX_PARKED 2        ///< Largest number of requests long-polled at once.
+#define STATUS_BODY_SIZE 192       ///< Size of the response body buffer, in bytes.
+#define STATUS_QUERY_SIZE 32       ///< Size of the query string buffer, in bytes.
+#define STATUS_URI "/status.json"  ///< URI of the endpoint.
+
+static const char* TAG                    = "Status Endpoint";  ///< Tag used for logging.
+static const int64_t LONG_POLL_TIMEOUT_MS = 10000;              ///< Longest time a request is parked, in milliseconds.
+
+/**
+ * @brief Request waiting for the next change of the connection status.
+ */
+typedef struct parked_request_s {
+    httpd_req_t* req;     ///< Asynchronous copy of the request, NULL if the slot is free.
+    uint32_t version;     ///< Version of the status the client already has.
+    int64_t deadline_ms;  ///< Uptime at which the request is answered regardless.
+} parked_request_st;
+
+static parked_request_st parked_requests[STATUS_MAX_PARKED] = {0};                           ///< Long-polled requests.
+static portMUX_TYPE parked_requests_lock                    = portMUX_INITIALIZER_UNLOCKED;  ///< Guards parked_requests across tasks.
+
+/**
+ * @brief Get the name of a connection state, as reported to clients.
+ *
+ * @param[in] state Connection state.
+ *
+ * @return Name of the state.
+ */
+static const char* status_state_name(network_sta_state_e state) {
+    switch (state) {
+        case NETWORK_STA_CONNECTING:
+            return "connecting";
+        case NETWORK_STA_CONNECTED:
+            return "connected";
+        case NETWORK_STA_FAILED:
+            return "failed";
+        default:
+            return "idle";
+    }
+}
+
+/**
+ * @brief Copies a string as the contents of a JSON string literal.
+ *
+ * Quotes and backslashes are escaped and control characters are dropped, so
+ * a user-supplied SSID cannot break the document.
+ *
+ * @param[out] buffer Buffer receiving the escaped string, NUL-terminated.
+ * @param[in]  size   Size of the buffer, in bytes.
+ * @param[in]  text   String to escape.
+ */
+static void status_escape_json(char* buffer, size_t size, const char* text) {
+    size_t length = 0;
+
+    for (; (*text != '\0') && (length + 2 < size); text++) {
+        if ((unsigned char)*text < 0x20) {
+            continue;
+        }
+        if ((*text == '"') || (*text == '\\')) {
+            buffer[length++] = '\\';
+        }
+        buffer[length++] = *text;
+    }
+
+    buffer[length] = '\0';
+}
+
+/**
+ * @brief Reply with a connection status snapshot.
+ *
+ * @param[in] req  HTTP request object.
+ * @param[in] info Connection status to send.
+ *
+ * @return ESP_OK on success, or an error code on failure.
+ */
+static esp_err_t status_send_info(httpd_req_t* req, const network_sta_info_st* info) {
+    char body[STATUS_BODY_SIZE]       = {0};
+    char ssid[2 * sizeof(info->ssid)] = {0};
+
+    status_escape_json(ssid, sizeof(ssid), info->ssid);
+
+    int length = snprintf(body, sizeof(body),
+                          "{\"version\": %lu, \"state\": \"%s\", \"ssid\": \"%s\", \"attempt\": %u, "
+                          "\"reason\": %u, \"ip\": \"%s\", \"rssi\": %d}",
+                          (unsigned long)info->version, status_state_name(info->state), ssid,
+                          info->attempt, info->disconnect_reason, info->ip, info->rssi);
+    if ((length < 0) || (length >= (int)sizeof(body))) {
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Status does not fit");
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    return httpd_resp_send(req, body, length);
+}
+
+/**
+ * @brief Parks a request until the status moves past a version.
+ *
+ * @param[in] req     HTTP request object.
+ * @param[in] version Version of the status the client already has.
+ *
+ * @return true if the request was parked, false if it must be answered now.
+ */
+static bool status_park_request(httpd_req_t* req, uint32_t version) {
+    httpd_req_t* async_req = NULL;
+    size_t slot            = STATUS_MAX_PARKED;
+
+    // Reserve a slot first, the request cannot be answered synchronously once
+    // it has been handed over to the asynchronous copy.
+    taskENTER_CRITICAL(&parked_requests_lock);
+    for (size_t i = 0; i < STATUS_MAX_PARKED; i++) {
+        if (parked_requests[i].req == NULL) {
+            parked_requests[i].req = req;
+            slot                   = i;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&parked_requests_lock);
+
+    if (slot == STATUS_MAX_PARKED) {
+        return false;
+    }
+
+    if (httpd_req_async_handler_begin(req, &async_req) != ESP_OK) {
+        taskENTER_CRITICAL(&parked_requests_lock);
+        parked_requests[slot].req = NULL;
+        taskEXIT_CRITICAL(&parked_requests_lock);
+        return false;
+    }
+
+    taskENTER_CRITICAL(&parked_requests_lock);
+    parked_requests[slot].req         = async_req;
+    parked_requests[slot].version     = version;
+    parked_requests[slot].deadline_ms = (esp_timer_get_time() / 1000) + LONG_POLL_TIMEOUT_MS;
+    taskEXIT_CRITICAL(&parked_requests_lock);
+
+    return true;
+}
+
+/**
+ * @brief HTTP GET handler of the status endpoint.
+ *
+ * @param[in] req HTTP request object.
+ * @return ESP_OK on success, or an error code on failure.
+ */
+static esp_err_t get_uri_status(httpd_req_t* req) {
+    network_sta_info_st info      = {0};
+    char query[STATUS_QUERY_SIZE] = {0};
+    char version[12]              = {0};
+
+    network_get_sta_info(&info);
+
+    if ((httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) &&
+        (httpd_query_key_value(query, "version", version, sizeof(version)) == ESP_OK)) {
+        uint32_t known_version = strtoul(version, NULL, 10);
+        if ((known_version == info.version) && status_park_request(req, known_version)) {
+            return ESP_OK;
+        }
+    }
+
+    return status_send_info(req, &info);
+}
+
+/**
+ * @brief Register the status endpoint on a running server.
+ *
+ * Must be called before any wildcard handler that would also match the
+ * endpoint URI.
+ *
+ * @param[in] server Handle of the HTTP server.
+ *
+ * @return ESP_OK on success, or an error code on failure.
+ */
+esp_err_t status_endpoint_register(httpd_handle_t server) {
+    static const httpd_uri_t uri_get_status = {
+        .uri      = STATUS_URI,
+        .method   = HTTP_GET,
+        .handler  = get_uri_status,
+        .user_ctx = NULL,
+    };
+
+    return httpd_register_uri_handler(server, &uri_get_status);
+}
+
+/**
+ * @brief Reply with the current connection status.
+ *
+ * @param[in] req HTTP request object.
+ *
+ * @return ESP_OK on success, or an error code on failure.
+ */
+esp_err_t status_endpoint_send(httpd_req_t* req) {
+    network_sta_info_st info = {0};
+
+    network_get_sta_info(&info);
+
+    return status_send_info(req, &info);
+}
+
+/**
+ * @brief Answer the parked requests whose status changed or timed out.
+ *
+ * Called from the HTTP server task whenever `NETWORK_STATUS_CHANGED` is set,
+ * and at least once per second.
+ *
+ * @param[in] flush Answer every parked request, e.g. before stopping the server.
+ */
+void status_endpoint_process(bool flush) {
+    network_sta_info_st info = {0};
+    int64_t now_ms           = esp_timer_get_time() / 1000;
+
+    network_get_sta_info(&info);
+
+    for (size_t i = 0; i < STATUS_MAX_PARKED; i++) {
+        httpd_req_t* req = NULL;
+
+        taskENTER_CRITICAL(&parked_requests_lock);
+        parked_request_st* parked = &parked_requests[i];
+        // A slot still holding the synchronous request is being parked by the handler.
+        if ((parked->req != NULL) && (parked->deadline_ms != 0) &&
+            (flush || (parked->version != info.version) || (now_ms >= parked->deadline_ms))) {
+            req                 = parked->req;
+            parked->req         = NULL;
+            parked->deadline_ms = 0;
+        }
+        taskEXIT_CRITICAL(&parked_requests_lock);
+
+        if (req == NULL) {
+            continue;
+        }
+
+        if (status_send_info(req, &info) != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to answer a long-polled status request");
+        }
+        httpd_req_async_handler_complete(req);
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef STATUS_ENDPOINT_H
+#define STATUS_ENDPOINT_H
+
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+/**
+ * @file status_endpoint.h
+ * @brief Connection status endpoint polled by the provisioning UI.
+ *
+ * `GET /status.json` returns the station connection reported by the network
+ * task:
+ *
+ *   {"version": 4, "state": "connecting", "ssid": "Home", "attempt": 1,
+ *    "reason": 0, "ip": "", "rssi": 0}
+ *
+ * A client passing the version it already has, `GET /status.json?version=4`,
+ * is long-polled: the request is parked without holding the server task and
+ * answered as soon as the status changes, or after a timeout with the same
+ * status.
+ */
+
+/**
+ * @brief Register the status endpoint on a running server.
+ *
+ * Must be called before any wildcard handler that would also match the
+ * endpoint URI.
+ *
+ * @param[in] server Handle of the HTTP server.
+ *
+ * @return ESP_OK on success, or an error code on failure.
+ */
+esp_err_t status_endpoint_register(httpd_handle_t server);
+
+/**
+ * @brief Reply with the current connection status.
+ *
+ * @param[in] req HTTP request object.
+ *
+ * @return ESP_OK on success, or an error code on failure.
+ */
+esp_err_t status_endpoint_send(httpd_req_t *req);
+
+/**
+ * @brief Answer the parked requests whose status changed or timed out.
+ *
+ * Called from the HTTP server task whenever `NETWORK_STATUS_CHANGED` is set,
+ * and at least once per second.
+ *
+ * @param[in] flush Answer every parked request, e.g. before stopping the server.
+ */
+void status_endpoint_process(bool flush);
+
+#endif /* STATUS_ENDPOINT_H */
@@ -0,0 +1,247 @@
+/**
+ * @file telemetry_ws.c
+ * @brief Implementation of the live telemetry stream over WebSocket.
+ */
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+
+#include "telemetry_encoder.h"
+#include "telemetry_ws.h"
+#include "temperature_monitor_task.h"
+#include "utils.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+#define TELEMETRY_WS_FRAME_SIZE 1024      ///< Size of the shared frame buffer, in bytes.
+#define TELEMETRY_WS_MAX_SENSORS 8        ///< Largest number of sensors streamed.
+#define TELEMETRY_WS_MAX_CLIENTS 8        ///< Largest number of sessions inspected per frame.
+#define TELEMETRY_WS_RX_SIZE 64           ///< Largest incoming frame accepted, in bytes.
+#define TELEMETRY_WS_URI "/ws/telemetry"  ///< URI of the endpoint.
+
+static const char* TAG = "Telemetry WS";  ///< Tag used for logging.
+
+#if CONFIG_HTTPD_WS_SUPPORT
+
+static const uint32_t SEND_TIMEOUT_MS = 200;  ///< Longest time a client may block a frame, in milliseconds.
+
+static uint8_t frame_buffer[TELEMETRY_WS_FRAME_SIZE]    = {0};    ///< Frame shared by all clients.
+static size_t frame_length                              = 0;      ///< Length of the frame, in bytes.
+static atomic_bool is_frame_pending                     = false;  ///< Whether the frame is still being sent.
+static uint32_t sent_sequence[TELEMETRY_WS_MAX_SENSORS] = {0};    ///< Sequence of the last reading sent for each sensor.
+
+/**
+ * @brief WebSocket handler of the telemetry endpoint.
+ *
+ * On the handshake, the send timeout of the socket is lowered so a slow
+ * client fails fast instead of holding the server task. The stream is one
+ * way, frames received afterwards are read and discarded.
+ *
+ * @param[in] req HTTP request object.
+ * @return ESP_OK on success, or an error code on failure.
+ */
+static esp_err_t ws_uri_telemetry(httpd_req_t* req) {
+    static uint8_t rx_buffer[TELEMETRY_WS_RX_SIZE] = {0};
+    httpd_ws_frame_t frame                         = {0};
+
+    if (req->method == HTTP_GET) {
+        struct timeval timeout = {
+            .tv_sec  = SEND_TIMEOUT_MS / 1000,
+            .tv_usec = (SEND_TIMEOUT_MS % 1000) * 1000,
+        };
+        int fd = httpd_req_to_sockfd(req);
+        if (setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) != 0) {
+            ESP_LOGW(TAG, "Failed to set the send timeout of socket %d", fd);
+        }
+        ESP_LOGI(TAG, "Client connected on socket %d", fd);
+        return ESP_OK;
+    }
+
+    esp_err_t result = httpd_ws_recv_frame(req, &frame, 0);
+    if (result != ESP_OK) {
+        return result;
+    }
+
+    if (frame.len > sizeof(rx_buffer)) {
+        ESP_LOGW(TAG, "Dropping client, incoming frame of %u bytes", (unsigned)frame.len);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    frame.payload = rx_buffer;
+
+    return httpd_ws_recv_frame(req, &frame, sizeof(rx_buffer));
+}
+
+/**
+ * @brief Sends the shared frame to every WebSocket client.
+ *
+ * Runs in the HTTP server task. Clients failing to take the frame are closed.
+ *
+ * @param[in] arg Handle of the HTTP server.
+ */
+static void telemetry_ws_send_frame(void* arg) {
+    httpd_handle_t server                    = (httpd_handle_t)arg;
+    int client_fds[TELEMETRY_WS_MAX_CLIENTS] = {0};
+    size_t client_count                      = TELEMETRY_WS_MAX_CLIENTS;
+    httpd_ws_frame_t frame                   = {
+        .final      = true,
+        .fragmented = false,
+        .type       = HTTPD_WS_TYPE_TEXT,
+        .payload    = frame_buffer,
+        .len        = frame_length,
+    };
+
+    if (httpd_get_client_list(server, &client_count, client_fds) == ESP_OK) {
+        for (size_t i = 0; i < client_count; i++) {
+            if (httpd_ws_get_fd_info(server, client_fds[i]) != HTTPD_WS_CLIENT_WEBSOCKET) {
+                continue;
+            }
+
+            if (httpd_ws_send_frame_async(server, client_fds[i], &frame) != ESP_OK) {
+                ESP_LOGW(TAG, "Closing slow client on socket %d", client_fds[i]);
+                httpd_sess_trigger_close(server, client_fds[i]);
+            }
+        }
+    }
+
+    atomic_store_explicit(&is_frame_pending, false, memory_order_release);
+}
+
+/**
+ * @brief Encodes the readings published since the previous frame.
+ *
+ * @return Number of samples in the frame.
+ */
+static uint16_t telemetry_ws_build_frame(void) {
+    telemetry_encoder_st encoder = {0};
+    temperature_data_st sample   = {0};
+    uint32_t sequence            = 0;
+    uint8_t sensor_count         = temperature_monitor_get_sensor_count();
+    int64_t epoch_offset_us      = get_epoch_offset_us();
+
+    if (sensor_count > TELEMETRY_WS_MAX_SENSORS) {
+        sensor_count = TELEMETRY_WS_MAX_SENSORS;
+    }
+
+    if (telemetry_encoder_begin(&encoder, TELEMETRY_FORMAT_JSON, frame_buffer, sizeof(frame_buffer),
+                                (esp_timer_get_time() + epoch_offset_us) / 1000) != ESP_OK) {
+        return 0;
+    }
+
+    for (uint8_t i = 0; i < sensor_count; i++) {
+        if (!temperature_monitor_get_latest(i, &sample, &sequence) || (sequence == sent_sequence[i])) {
+            continue;
+        }
+
+        // A reading that does not fit is sent with the next frame.
+        if (telemetry_encoder_append(&encoder, &sample, (sample.timestamp_us + epoch_offset_us) / 1000) != ESP_OK) {
+            break;
+        }
+        sent_sequence[i] = sequence;
+    }
+
+    if ((encoder.sample_count == 0) || (telemetry_encoder_finish(&encoder, &frame_length) != ESP_OK)) {
+        return 0;
+    }
+
+    return encoder.sample_count;
+}
+
+/**
+ * @brief Register the WebSocket endpoint on a running server.
+ *
+ * Must be called before any wildcard handler that would also match the
+ * endpoint URI.
+ *
+ * @param[in] server Handle of the HTTP server.
+ *
+ * @return ESP_OK on success, or an error code on failure.
+ */
+esp_err_t telemetry_ws_register(httpd_handle_t server) {
+    static const httpd_uri_t uri_ws_telemetry = {
+        .uri                      = TELEMETRY_WS_URI,
+        .method                   = HTTP_GET,
+        .handler                  = ws_uri_telemetry,
+        .user_ctx                 = NULL,
+        .is_websocket             = true,
+        .handle_ws_control_frames = false,
+    };
+
+    atomic_store_explicit(&is_frame_pending, false, memory_order_relaxed);
+    memset(sent_sequence, 0, sizeof(sent_sequence));
+
+    esp_err_t result = httpd_register_uri_handler(server, &uri_ws_telemetry);
+    if (result == ESP_OK) {
+        ESP_LOGI(TAG, "Streaming telemetry on %s", TELEMETRY_WS_URI);
+    }
+
+    return result;
+}
+
+/**
+ * @brief Send the readings published since the previous frame to all clients.
+ *
+ * Does nothing if no reading changed or if the previous frame is still being
+ * sent; the readings are then picked up by the next call.
+ *
+ * @param[in] server Handle of the HTTP server.
+ *
+ * @return ESP_OK on success, or an error code on failure.
+ */
+esp_err_t telemetry_ws_broadcast(httpd_handle_t server) {
+    if (server == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // The frame buffer belongs to the server task until the frame is sent.
+    if (atomic_load_explicit(&is_frame_pending, memory_order_acquire)) {
+        return ESP_OK;
+    }
+
+    if (telemetry_ws_build_frame() == 0) {
+        return ESP_OK;
+    }
+
+    atomic_store_explicit(&is_frame_pending, true, memory_order_relaxed);
+
+    esp_err_t result = httpd_queue_work(server, telemetry_ws_send_frame, server);
+    if (result != ESP_OK) {
+        atomic_store_explicit(&is_frame_pending, false, memory_order_relaxed);
+        ESP_LOGE(TAG, "Failed to queue the frame: %s", esp_err_to_name(result));
+    }
+
+    return result;
+}
+
+#else
+
+/**
+ * @brief Register the WebSocket endpoint on a running server.
+ *
+ * WebSocket support is disabled in the HTTP server configuration.
+ *
+ * @param[in] server Handle of the HTTP server.
+ *
+ * @return ESP_ERR_NOT_SUPPORTED.
+ */
+esp_err_t telemetry_ws_register(httpd_handle_t server) {
+    ESP_LOGW(TAG, "CONFIG_HTTPD_WS_SUPPORT is disabled, %s is not served", TELEMETRY_WS_URI);
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+/**
+ * @brief Send the readings published since the previous frame to all clients.
+ *
+ * WebSocket support is disabled in the HTTP server configuration.
+ *
+ * @param[in] server Handle of the HTTP server.
+ *
+ * @return ESP_OK.
+ */
+esp_err_t telemetry_ws_broadcast(httpd_handle_t server) {
+    return ESP_OK;
+}
+
+#endif /* CONFIG_HTTPD_WS_SUPPORT */
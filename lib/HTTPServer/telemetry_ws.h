@@ -0,0 +1,49 @@
+#ifndef TELEMETRY_WS_H
+#define TELEMETRY_WS_H
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+/**
+ * @file telemetry_ws.h
+ * @brief Live telemetry stream over WebSocket.
+ *
+ * Clients connecting to `/ws/telemetry` receive the latest reading of every
+ * sensor as soon as the temperature monitor publishes it, as a JSON frame in
+ * the format produced by the telemetry encoder with one sample per updated
+ * sensor.
+ *
+ * Every frame is encoded once into a shared buffer and sent to all clients
+ * from the HTTP server task, so clients never hold a copy of their own. While
+ * a frame is still being sent, new readings are not queued behind it: the
+ * next frame is built from the latest values once the current one is done,
+ * so a slow client only ever misses intermediate readings. A client that
+ * cannot take a frame within a short send timeout is disconnected, so it
+ * cannot stall the others.
+ */
+
+/**
+ * @brief Register the WebSocket endpoint on a running server.
+ *
+ * Must be called before any wildcard handler that would also match the
+ * endpoint URI.
+ *
+ * @param[in] server Handle of the HTTP server.
+ *
+ * @return ESP_OK on success, or an error code on failure.
+ */
+esp_err_t telemetry_ws_register(httpd_handle_t server);
+
+/**
+ * @brief Send the readings published since the previous frame to all clients.
+ *
+ * Does nothing if no reading changed or if the previous frame is still being
+ * sent; the readings are then picked up by the next call.
+ *
+ * @param[in] server Handle of the HTTP server.
+ *
+ * @return ESP_OK on success, or an error code on failure.
+ */
+esp_err_t telemetry_ws_broadcast(httpd_handle_t server);
+
+#endif /* TELEMETRY_WS_H */
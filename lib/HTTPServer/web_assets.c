@@ -0,0 +1,64 @@
+/**
+ * @file web_assets.c
+ * @brief Lookup of the embedded web assets.
+ */
+
+#include "web_assets.h"
+
+#include <string.h>
+
+/**
+ * @brief Compare a requested URI with the URI of an asset.
+ *
+ * @param[in] uri        Requested URI, possibly followed by a query string.
+ * @param[in] path_len   Length of the path part of `uri`.
+ * @param[in] asset_uri  URI of the asset.
+ *
+ * @return A negative, zero or positive value, as `strcmp`.
+ */
+static int compare_uri(const char *uri, size_t path_len, const char *asset_uri) {
+    int order = strncmp(uri, asset_uri, path_len);
+    if (order != 0) {
+        return order;
+    }
+
+    // Equal prefixes, the shorter string sorts first.
+    return (asset_uri[path_len] == '\0') ? 0 : -1;
+}
+
+/**
+ * @brief Look up the asset served at a URI.
+ *
+ * Uses a binary search over the sorted table. Only the path is compared, a
+ * query string starting with '?' is ignored.
+ *
+ * @param[in] uri Requested URI.
+ *
+ * @return The asset, or NULL if no asset is served at this URI.
+ */
+const web_asset_st *web_assets_find(const char *uri) {
+    if (uri == NULL) {
+        return NULL;
+    }
+
+    size_t path_len = strcspn(uri, "?");
+    size_t low      = 0;
+    size_t high     = web_assets_count;
+
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        int order     = compare_uri(uri, path_len, web_assets[middle].uri);
+
+        if (order == 0) {
+            return &web_assets[middle];
+        }
+
+        if (order < 0) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+
+    return NULL;
+}
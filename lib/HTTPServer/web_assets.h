@@ -0,0 +1,48 @@
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file web_assets.h
+ * @brief Static files of the provisioning UI embedded in the firmware image.
+ *
+ * The table is generated at configure time by tools/embed_assets.py from the
+ * files in src/static. Assets are stored gzip-compressed whenever that makes
+ * them smaller, and carry a strong ETag computed from the stored bytes so
+ * browsers can revalidate them with `If-None-Match`. The table is sorted by
+ * URI; adding a file to the asset list in src/CMakeLists.txt is all it takes
+ * to serve it.
+ */
+
+/**
+ * @brief Static file served by the HTTP server.
+ */
+typedef struct web_asset_s {
+    const char *uri;            ///< URI the asset is served at.
+    const char *content_type;   ///< MIME type of the asset.
+    const char *cache_control;  ///< Value of the `Cache-Control` header.
+    const char *etag;           ///< Strong ETag of the stored bytes, quotes included.
+    const uint8_t *data;        ///< Stored bytes.
+    size_t length;              ///< Number of stored bytes.
+    bool is_gzip;               ///< Whether the stored bytes are gzip-compressed.
+} web_asset_st;
+
+extern const web_asset_st web_assets[];  ///< Embedded assets, sorted by URI.
+extern const size_t web_assets_count;    ///< Number of embedded assets.
+
+/**
+ * @brief Look up the asset served at a URI.
+ *
+ * Uses a binary search over the sorted table. Only the path is compared, a
+ * query string starting with '?' is ignored.
+ *
+ * @param[in] uri Requested URI.
+ *
+ * @return The asset, or NULL if no asset is served at this URI.
+ */
+const web_asset_st *web_assets_find(const char *uri);
+
+#endif /* WEB_ASSETS_H */
@@ -0,0 +1,208 @@
+/**
+ * @file low_power.c
+ * @brief Implementation of the duty-cycled deep-sleep mode.
+ *
+ * The RTC buffer is in `RTC_DATA_ATTR` memory, which the bootloader loads
+ * with its initial value on every boot but a deep-sleep wake, so it starts
+ * empty after a power-on or a reset and needs no validity check. Records are
+ * stamped with the wall-clock time when they are buffered, since the
+ * monotonic uptime restarts on every wake. The system time keeps running
+ * across deep sleep; until it has been set once, the readings are dropped and
+ * the wake flushes instead, so the SNTP task gets to synchronize it.
+ */
+
+#include "low_power.h"
+#include "device_config.h"
+#include "mqtt_client_task.h"
+#include "network_task.h"
+#include "telemetry_store.h"
+#include "temperature_monitor_task.h"
+#include "utils.h"
+
+#include <string.h>
+
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define LOW_POWER_BUFFER_CAPACITY 64  ///< Number of samples the RTC buffer can hold.
+#define LOW_POWER_MAX_SENSORS 8       ///< Largest number of sensors read on a wake.
+
+/**
+ * @brief State kept in RTC slow memory across deep sleep.
+ */
+typedef struct low_power_rtc_state_s {
+    uint16_t count;                                                ///< Number of samples buffered.
+    uint16_t wake_count;                                           ///< Number of wakes since the last flush.
+    uint32_t sequences[LOW_POWER_MAX_SENSORS];                     ///< Sequence number of the next sample of each sensor.
+    telemetry_store_record_st records[LOW_POWER_BUFFER_CAPACITY];  ///< Buffered samples, oldest first.
+} low_power_rtc_state_st;
+
+static const char *TAG                            = "Low Power";    ///< Tag for logging.
+static const uint32_t LOW_POWER_SAMPLE_PERIOD_MS  = 60 * 1000;      ///< Period between two wakes, in milliseconds.
+static const uint16_t LOW_POWER_SAMPLES_PER_FLUSH = 30;             ///< Number of wakes between two flushes.
+static const uint32_t LOW_POWER_PROVISIONING_MS   = 5 * 60 * 1000;  ///< Time spent awake after a power-on, in milliseconds.
+static const uint32_t LOW_POWER_FLUSH_TIMEOUT_MS  = 60 * 1000;      ///< Longest time a flush waits for the broker, in milliseconds.
+static const uint32_t LOW_POWER_POLL_INTERVAL_MS  = 500;            ///< Interval between two checks of the flush, in milliseconds.
+static const int64_t LOW_POWER_MIN_SLEEP_US       = 1000000;        ///< Shortest sleep, when the wake overran the period.
+static const int64_t MIN_VALID_EPOCH_MS           = 1577836800000;  ///< Times before 2020-01-01 mean the clock was never set.
+
+_Static_assert(LOW_POWER_MAX_SENSORS <= LOW_POWER_BUFFER_CAPACITY, "A wake must fit in an empty buffer");
+
+RTC_DATA_ATTR static low_power_rtc_state_st rtc_state;  ///< Samples buffered across deep sleep.
+
+/**
+ * @brief Check whether the low-power mode is enabled.
+ *
+ * The switch is the `low_power` setting of `device_config.h`, so it is
+ * changed remotely with the other runtime settings.
+ *
+ * @return true if the low-power mode is enabled in NVS.
+ */
+bool low_power_is_enabled(void) {
+    device_config_st config = {0};
+
+    return (device_config_load(&config) == ESP_OK) && config.is_low_power_enabled;
+}
+
+/**
+ * @brief Enter deep sleep until the next sample is due.
+ *
+ * The time spent awake is deducted from the period, so the samples keep a
+ * fixed cadence whatever the wake did.
+ */
+static void low_power_sleep(void) {
+    int64_t sleep_us = ((int64_t)LOW_POWER_SAMPLE_PERIOD_MS * 1000) - esp_timer_get_time();
+    if (sleep_us < LOW_POWER_MIN_SLEEP_US) {
+        sleep_us = LOW_POWER_MIN_SLEEP_US;
+    }
+
+    ESP_LOGI(TAG, "Sleeping %lld ms, %u sample(s) buffered", (long long)(sleep_us / 1000), rtc_state.count);
+
+    esp_sleep_enable_timer_wakeup((uint64_t)sleep_us);
+    esp_deep_sleep_start();
+}
+
+/**
+ * @brief Read every sensor once and append the samples to the RTC buffer.
+ *
+ * Samples that do not fit in the buffer are dropped.
+ */
+static void low_power_take_reading(void) {
+    temperature_data_st samples[LOW_POWER_MAX_SENSORS] = {0};
+    size_t count                                       = 0;
+
+    if (temperature_monitor_read_once(samples, LOW_POWER_MAX_SENSORS, &count) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to read the sensors");
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (rtc_state.count >= LOW_POWER_BUFFER_CAPACITY) {
+            ESP_LOGW(TAG, "RTC buffer full, dropping sample of sensor %u", samples[i].sensor_id);
+            break;
+        }
+
+        telemetry_store_record_st *record = &rtc_state.records[rtc_state.count++];
+        record->sample                    = samples[i];
+        record->timestamp_ms              = monotonic_to_epoch_ms(samples[i].timestamp_us);
+        if (samples[i].sensor_id < LOW_POWER_MAX_SENSORS) {
+            record->sample.sequence = rtc_state.sequences[samples[i].sensor_id]++;
+        }
+    }
+}
+
+/**
+ * @brief Move the RTC buffer to the offline store, for the MQTT task to replay.
+ *
+ * Samples the store refuses stay in the buffer for the next flush.
+ */
+static void low_power_flush_buffer(void) {
+    uint16_t stored = 0;
+
+    if (telemetry_store_init() == ESP_OK) {
+        while ((stored < rtc_state.count) && (telemetry_store_append(&rtc_state.records[stored]) == ESP_OK)) {
+            stored++;
+        }
+    }
+
+    if (stored < rtc_state.count) {
+        ESP_LOGE(TAG, "Failed to store %u sample(s), keeping them for the next flush", rtc_state.count - stored);
+    }
+
+    memmove(&rtc_state.records[0], &rtc_state.records[stored], (rtc_state.count - stored) * sizeof(rtc_state.records[0]));
+    rtc_state.count      = rtc_state.count - stored;
+    rtc_state.wake_count = 0;
+}
+
+/**
+ * @brief Handle the wake-up, before any task is created.
+ *
+ * On a sample wake, takes the reading, buffers it and enters deep sleep
+ * without returning. On a flush wake, moves the buffered samples to the
+ * offline store first. Must be called once, after NVS is initialized.
+ *
+ * @return How the firmware runs for this boot.
+ */
+low_power_mode_e low_power_begin(void) {
+    if (!low_power_is_enabled() || !network_has_stored_credentials()) {
+        return LOW_POWER_MODE_OFF;
+    }
+
+    if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_TIMER) {
+        ESP_LOGI(TAG, "Staying awake %lu s for provisioning", (unsigned long)(LOW_POWER_PROVISIONING_MS / 1000));
+        return LOW_POWER_MODE_PROVISIONING;
+    }
+
+    bool is_clock_set = get_epoch_time_ms() >= MIN_VALID_EPOCH_MS;
+    if (is_clock_set) {
+        low_power_take_reading();
+    } else {
+        ESP_LOGW(TAG, "Clock not set, dropping the reading");
+    }
+    rtc_state.wake_count++;
+
+    bool has_room = (rtc_state.count + temperature_monitor_get_sensor_count()) <= LOW_POWER_BUFFER_CAPACITY;
+    if (is_clock_set && has_room && (rtc_state.wake_count < LOW_POWER_SAMPLES_PER_FLUSH)) {
+        low_power_sleep();
+    }
+
+    ESP_LOGI(TAG, "Flushing %u sample(s)", rtc_state.count);
+    low_power_flush_buffer();
+
+    return LOW_POWER_MODE_FLUSH;
+}
+
+/**
+ * @brief Enter deep sleep once the current boot has done its work.
+ *
+ * Waits for the provisioning window in `LOW_POWER_MODE_PROVISIONING`, then
+ * until every sample was delivered to the broker or the flush timed out, and
+ * enters deep sleep without returning. Returns right away in
+ * `LOW_POWER_MODE_OFF`.
+ *
+ * @param[in] mode Mode returned by `low_power_begin()`.
+ */
+void low_power_finish(low_power_mode_e mode) {
+    if (mode == LOW_POWER_MODE_OFF) {
+        return;
+    }
+
+    if (mode == LOW_POWER_MODE_PROVISIONING) {
+        vTaskDelay(pdMS_TO_TICKS(LOW_POWER_PROVISIONING_MS));
+    }
+
+    TickType_t start_time = xTaskGetTickCount();
+    while (!mqtt_client_task_is_idle()) {
+        if ((xTaskGetTickCount() - start_time) >= pdMS_TO_TICKS(LOW_POWER_FLUSH_TIMEOUT_MS)) {
+            ESP_LOGW(TAG, "Flush timed out, the remaining samples stay in the offline store");
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(LOW_POWER_POLL_INTERVAL_MS));
+    }
+
+    low_power_sleep();
+}
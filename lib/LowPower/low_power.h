@@ -0,0 +1,73 @@
+#ifndef LOW_POWER_H
+#define LOW_POWER_H
+
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+/**
+ * @file low_power.h
+ * @brief Duty-cycled deep-sleep mode, buffering samples in RTC memory.
+ *
+ * Once enabled, with `{"low_power": true}` on the configuration topic of
+ * `device_config.h`, and provisioned with station credentials, the device
+ * spends most of its time in deep sleep. It wakes on the RTC timer, takes a
+ * single reading of every sensor and appends it to a buffer kept in RTC slow
+ * memory, then goes back to sleep right away, without starting Wi-Fi. Every
+ * `LOW_POWER_SAMPLES_PER_FLUSH` wakes, or when the buffer is about to fill
+ * up, the buffered samples are moved to the offline store and only the
+ * network, MQTT and SNTP tasks are started, with Wi-Fi in station mode only:
+ * the provisioning Access Point and the HTTP server are skipped. The MQTT
+ * task replays the store as a batch, and the device sleeps again once the
+ * broker has acknowledged it or the flush timed out. With an mqtts broker,
+ * every flush starts with a full TLS handshake, see `mqtt_tls.h`.
+ *
+ * After a power-on or any reset other than a deep-sleep wake, the firmware
+ * runs normally for a provisioning window before it first goes to sleep, so
+ * the provisioning Access Point can still be requested, or start when the
+ * stored network cannot be joined.
+ */
+
+/**
+ * @brief How the firmware runs for the current boot.
+ */
+typedef enum low_power_mode_t {
+    LOW_POWER_MODE_OFF = 0,       ///< Low-power mode disabled or not provisioned, every task runs and the device never sleeps.
+    LOW_POWER_MODE_PROVISIONING,  ///< Every task runs for the provisioning window, then the device sleeps.
+    LOW_POWER_MODE_FLUSH,         ///< Only the network, MQTT and SNTP tasks run, until the buffered samples are delivered.
+} low_power_mode_e;
+
+/**
+ * @brief Check whether the low-power mode is enabled.
+ *
+ * The switch is the `low_power` setting of `device_config.h`, so it is
+ * changed remotely with the other runtime settings.
+ *
+ * @return true if the low-power mode is enabled in NVS.
+ */
+bool low_power_is_enabled(void);
+
+/**
+ * @brief Handle the wake-up, before any task is created.
+ *
+ * On a sample wake, takes the reading, buffers it and enters deep sleep
+ * without returning. On a flush wake, moves the buffered samples to the
+ * offline store first. Must be called once, after NVS is initialized.
+ *
+ * @return How the firmware runs for this boot.
+ */
+low_power_mode_e low_power_begin(void);
+
+/**
+ * @brief Enter deep sleep once the current boot has done its work.
+ *
+ * Waits for the provisioning window in `LOW_POWER_MODE_PROVISIONING`, then
+ * until every sample was delivered to the broker or the flush timed out, and
+ * enters deep sleep without returning. Returns right away in
+ * `LOW_POWER_MODE_OFF`.
+ *
+ * @param[in] mode Mode returned by `low_power_begin()`.
+ */
+void low_power_finish(low_power_mode_e mode);
+
+#endif /* LOW_POWER_H */
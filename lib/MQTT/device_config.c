@@ -0,0 +1,700 @@
+/**
+ * @file device_config.c
+ * @brief Implementation of the runtime settings of the telemetry pipeline.
+ */
+
+#include "device_config.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "nvs.h"
+
+/**
+ * @brief Read position in a configuration document.
+ */
+typedef struct config_cursor_s {
+    const char *position;  ///< Next character to read.
+    const char *end;       ///< End of the document.
+} config_cursor_st;
+
+static const char *TAG                        = "Device Config";  ///< Tag for logging.
+static const char *NVS_NAMESPACE              = "device";         ///< NVS namespace of the runtime settings.
+static const char *NVS_KEY_SAMPLE_PERIOD      = "sample_period";  ///< NVS key of the sample period.
+static const char *NVS_KEY_WINDOW_PERIOD      = "window_period";  ///< NVS key of the aggregation window length.
+static const char *NVS_KEY_PUBLISH_MODE       = "publish_mode";   ///< NVS key of the publishing mode.
+static const char *NVS_KEY_BATCH_SIZE         = "batch_size";     ///< NVS key of the batch size.
+static const char *NVS_KEY_FORMAT             = "format";         ///< NVS key of the payload format.
+static const char *NVS_KEY_TEMPERATURE_DB     = "temp_db";        ///< NVS key of the absolute temperature deadband.
+static const char *NVS_KEY_TEMPERATURE_DB_PCT = "temp_db_pct";    ///< NVS key of the relative temperature deadband.
+static const char *NVS_KEY_HUMIDITY_DB        = "hum_db";         ///< NVS key of the absolute humidity deadband.
+static const char *NVS_KEY_HUMIDITY_DB_PCT    = "hum_db_pct";     ///< NVS key of the relative humidity deadband.
+static const char *NVS_KEY_HEARTBEAT          = "heartbeat";      ///< NVS key of the deadband heartbeat.
+static const char *NVS_KEY_LOW_POWER          = "low_power";      ///< NVS key of the low-power mode switch.
+static const uint32_t MIN_SAMPLE_PERIOD_MS    = 100;              ///< Shortest sample period, a sweep takes about 80 ms.
+static const uint32_t MIN_WINDOW_PERIOD_MS    = 1000;             ///< Shortest aggregation window.
+static const uint32_t MAX_WINDOW_PERIOD_MS    = 3600000;          ///< Longest aggregation window, under `UINT16_MAX` sweeps at the shortest sample period.
+
+/** @brief Name of the QoS setting of each channel, indexed by `mqtt_channel_e`. */
+static const char *QOS_SETTINGS[] = {"qos_raw", "qos_aggregate", "qos_replay", "qos_metrics"};
+
+_Static_assert(sizeof(QOS_SETTINGS) / sizeof(QOS_SETTINGS[0]) == MQTT_CHANNEL_COUNT, "One QoS setting per channel");
+
+/**
+ * @brief Settings used for every setting missing from NVS.
+ *
+ * The sample period and the window length are the ones of the temperature
+ * monitor. The minimum and maximum of each window are compared to the last
+ * reported mean too, so the deadbands must stay above the usual spread of a
+ * window. The settings of
+ * the MQTT client are loaded with `mqtt_config_load()`, and the IP
+ * configuration mode with `network_get_ip_mode()`.
+ */
+static const device_config_st DEFAULT_CONFIG = {
+    .sample_period_ms     = 250,
+    .window_period_ms     = 30000,
+    .publish_mode         = MQTT_PUBLISH_MODE_BATCH,
+    .batch_size           = DEVICE_CONFIG_MAX_BATCH_SIZE,
+    .payload_format       = TELEMETRY_FORMAT_JSON,
+    .deadband             = {
+        .temperature  = {.absolute = 50, .percent = 0},
+        .humidity     = {.absolute = 200, .percent = 0},
+        .heartbeat_ms = 15 * 60 * 1000,
+    },
+    .is_low_power_enabled = false,
+    .ip_mode              = NETWORK_IP_MODE_DHCP,
+};
+
+/**
+ * @brief Check whether a sample period is usable.
+ *
+ * A window must hold at least one sweep.
+ *
+ * @param[in] period_ms        Sample period, in milliseconds.
+ * @param[in] window_period_ms Length of the aggregation window, in milliseconds.
+ *
+ * @return true if the period is within range.
+ */
+static bool device_config_is_period_valid(uint32_t period_ms, uint32_t window_period_ms) {
+    return (period_ms >= MIN_SAMPLE_PERIOD_MS) && (period_ms <= window_period_ms);
+}
+
+/**
+ * @brief Check whether an aggregation window length is usable.
+ *
+ * @param[in] period_ms Window length, in milliseconds.
+ *
+ * @return true if the length is within range.
+ */
+static bool device_config_is_window_valid(uint32_t period_ms) {
+    return (period_ms >= MIN_WINDOW_PERIOD_MS) && (period_ms <= MAX_WINDOW_PERIOD_MS);
+}
+
+/**
+ * @brief Check whether a deadband heartbeat is usable.
+ *
+ * The filter sees one aggregated sample per sensor and window, so a shorter
+ * heartbeat, 0 included, would report every sample and disable the deadband.
+ *
+ * @param[in] heartbeat_ms     Heartbeat interval, in milliseconds.
+ * @param[in] window_period_ms Length of the aggregation window, in milliseconds.
+ *
+ * @return true if the heartbeat lasts at least one window.
+ */
+static bool device_config_is_heartbeat_valid(uint32_t heartbeat_ms, uint32_t window_period_ms) {
+    return heartbeat_ms >= window_period_ms;
+}
+
+/**
+ * @brief Check whether a publishing mode is known.
+ *
+ * @param[in] mode Publishing mode.
+ *
+ * @return true if the mode is known.
+ */
+static bool device_config_is_publish_mode_valid(uint32_t mode) {
+    return (mode == MQTT_PUBLISH_MODE_SINGLE) || (mode == MQTT_PUBLISH_MODE_COMBINED) || (mode == MQTT_PUBLISH_MODE_BATCH);
+}
+
+/**
+ * @brief Check whether a batch size is usable.
+ *
+ * @param[in] batch_size Number of samples per batch.
+ *
+ * @return true if the batch size is within range.
+ */
+static bool device_config_is_batch_size_valid(uint32_t batch_size) {
+    return (batch_size > 0) && (batch_size <= DEVICE_CONFIG_MAX_BATCH_SIZE);
+}
+
+/**
+ * @brief Check whether a payload format is known.
+ *
+ * @param[in] format Payload format.
+ *
+ * @return true if the format is known.
+ */
+static bool device_config_is_format_valid(uint32_t format) {
+    return (format == TELEMETRY_FORMAT_JSON) || (format == TELEMETRY_FORMAT_BINARY);
+}
+
+/**
+ * @brief Check whether settings are usable.
+ *
+ * @param[in] config Settings to check.
+ *
+ * @return true if every setting is in range.
+ */
+static bool device_config_is_valid(const device_config_st *config) {
+    return device_config_is_window_valid(config->window_period_ms) &&
+           device_config_is_period_valid(config->sample_period_ms, config->window_period_ms) &&
+           device_config_is_heartbeat_valid(config->deadband.heartbeat_ms, config->window_period_ms) &&
+           device_config_is_publish_mode_valid(config->publish_mode) &&
+           device_config_is_batch_size_valid(config->batch_size) &&
+           device_config_is_format_valid(config->payload_format) &&
+           mqtt_config_is_valid(&config->mqtt);
+}
+
+/**
+ * @brief Skip the whitespace at the cursor.
+ *
+ * @param[in,out] cursor Read position.
+ */
+static void config_skip_spaces(config_cursor_st *cursor) {
+    while ((cursor->position < cursor->end) &&
+           ((*cursor->position == ' ') || (*cursor->position == '\t') ||
+            (*cursor->position == '\r') || (*cursor->position == '\n'))) {
+        cursor->position++;
+    }
+}
+
+/**
+ * @brief Consume a punctuation character, after any whitespace.
+ *
+ * @param[in,out] cursor    Read position, left on the character if it does not match.
+ * @param[in]     character Character expected.
+ *
+ * @return true if the character was consumed.
+ */
+static bool config_expect(config_cursor_st *cursor, char character) {
+    config_skip_spaces(cursor);
+    if ((cursor->position < cursor->end) && (*cursor->position == character)) {
+        cursor->position++;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Parse a string without escape sequences.
+ *
+ * @param[in,out] cursor Read position.
+ * @param[out]    string First character of the string, inside the document.
+ * @param[out]    length Length of the string, in bytes.
+ *
+ * @return true if a string was parsed.
+ */
+static bool config_parse_string(config_cursor_st *cursor, const char **string, size_t *length) {
+    if (!config_expect(cursor, '"')) {
+        return false;
+    }
+
+    const char *start = cursor->position;
+    while ((cursor->position < cursor->end) && (*cursor->position != '"')) {
+        if (*cursor->position == '\\') {
+            return false;
+        }
+        cursor->position++;
+    }
+
+    if (cursor->position == cursor->end) {
+        return false;
+    }
+
+    *string = start;
+    *length = (size_t)(cursor->position - start);
+    cursor->position++;
+
+    return true;
+}
+
+/**
+ * @brief Parse an unsigned integer.
+ *
+ * @param[in,out] cursor Read position.
+ * @param[out]    value  Value parsed.
+ *
+ * @return true if an integer that fits in 32 bits was parsed.
+ */
+static bool config_parse_uint(config_cursor_st *cursor, uint32_t *value) {
+    uint32_t result = 0;
+    size_t digits   = 0;
+
+    config_skip_spaces(cursor);
+    while ((cursor->position < cursor->end) && (*cursor->position >= '0') && (*cursor->position <= '9')) {
+        uint32_t digit = (uint32_t)(*cursor->position - '0');
+        if (result > ((UINT32_MAX - digit) / 10)) {
+            return false;
+        }
+        result = (result * 10) + digit;
+        cursor->position++;
+        digits++;
+    }
+
+    *value = result;
+
+    return digits > 0;
+}
+
+/**
+ * @brief Compare a string of the document to a NUL-terminated one.
+ *
+ * @param[in] string Characters of the document.
+ * @param[in] length Number of characters.
+ * @param[in] name   String to compare with.
+ *
+ * @return true if both strings are equal.
+ */
+static bool config_is_equal(const char *string, size_t length, const char *name) {
+    return (strlen(name) == length) && (memcmp(string, name, length) == 0);
+}
+
+/**
+ * @brief Parse a boolean literal.
+ *
+ * @param[in,out] cursor Read position.
+ * @param[out]    value  Value parsed.
+ *
+ * @return true if "true" or "false" was parsed.
+ */
+static bool config_parse_bool(config_cursor_st *cursor, bool *value) {
+    static const char *TRUE_LITERAL  = "true";
+    static const char *FALSE_LITERAL = "false";
+
+    config_skip_spaces(cursor);
+    size_t remaining = (size_t)(cursor->end - cursor->position);
+
+    if ((remaining >= strlen(TRUE_LITERAL)) && (memcmp(cursor->position, TRUE_LITERAL, strlen(TRUE_LITERAL)) == 0)) {
+        cursor->position += strlen(TRUE_LITERAL);
+        *value            = true;
+        return true;
+    }
+    if ((remaining >= strlen(FALSE_LITERAL)) && (memcmp(cursor->position, FALSE_LITERAL, strlen(FALSE_LITERAL)) == 0)) {
+        cursor->position += strlen(FALSE_LITERAL);
+        *value            = false;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Parse a value into a 16-bit setting.
+ *
+ * @param[in,out] cursor  Read position.
+ * @param[out]    setting Setting to set.
+ *
+ * @return true if an integer that fits in 16 bits was parsed.
+ */
+static bool config_parse_u16(config_cursor_st *cursor, uint16_t *setting) {
+    uint32_t value = 0;
+
+    if (!config_parse_uint(cursor, &value) || (value > UINT16_MAX)) {
+        return false;
+    }
+    *setting = (uint16_t)value;
+
+    return true;
+}
+
+/**
+ * @brief Parse a value into an 8-bit setting.
+ *
+ * @param[in,out] cursor  Read position.
+ * @param[out]    setting Setting to set.
+ *
+ * @return true if an integer that fits in 8 bits was parsed.
+ */
+static bool config_parse_u8(config_cursor_st *cursor, uint8_t *setting) {
+    uint32_t value = 0;
+
+    if (!config_parse_uint(cursor, &value) || (value > UINT8_MAX)) {
+        return false;
+    }
+    *setting = (uint8_t)value;
+
+    return true;
+}
+
+/**
+ * @brief Parse the value of a setting.
+ *
+ * @param[in,out] cursor     Read position, on the value.
+ * @param[in]     key        Name of the setting, inside the document.
+ * @param[in]     key_length Length of the name, in bytes.
+ * @param[in,out] config     Settings to update.
+ *
+ * @return true if the setting is known and its value was parsed.
+ */
+static bool device_config_parse_setting(config_cursor_st *cursor, const char *key, size_t key_length,
+                                        device_config_st *config) {
+    const char *name   = NULL;
+    size_t name_length = 0;
+    uint32_t value     = 0;
+
+    if (config_is_equal(key, key_length, "format")) {
+        if (!config_parse_string(cursor, &name, &name_length)) {
+            return false;
+        }
+        if (config_is_equal(name, name_length, "json")) {
+            config->payload_format = TELEMETRY_FORMAT_JSON;
+        } else if (config_is_equal(name, name_length, "binary")) {
+            config->payload_format = TELEMETRY_FORMAT_BINARY;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    if (config_is_equal(key, key_length, "publish_mode")) {
+        if (!config_parse_string(cursor, &name, &name_length)) {
+            return false;
+        }
+        if (config_is_equal(name, name_length, "single")) {
+            config->publish_mode = MQTT_PUBLISH_MODE_SINGLE;
+        } else if (config_is_equal(name, name_length, "combined")) {
+            config->publish_mode = MQTT_PUBLISH_MODE_COMBINED;
+        } else if (config_is_equal(name, name_length, "batch")) {
+            config->publish_mode = MQTT_PUBLISH_MODE_BATCH;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    if (config_is_equal(key, key_length, "low_power")) {
+        return config_parse_bool(cursor, &config->is_low_power_enabled);
+    }
+
+    if (config_is_equal(key, key_length, "ip_mode")) {
+        if (!config_parse_string(cursor, &name, &name_length)) {
+            return false;
+        }
+        if (config_is_equal(name, name_length, "dhcp")) {
+            config->ip_mode = NETWORK_IP_MODE_DHCP;
+        } else if (config_is_equal(name, name_length, "static_cached")) {
+            config->ip_mode = NETWORK_IP_MODE_STATIC_CACHED;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    if (config_is_equal(key, key_length, "broker_uri")) {
+        if (!config_parse_string(cursor, &name, &name_length) || (name_length >= MQTT_CONFIG_URI_SIZE)) {
+            return false;
+        }
+        memcpy(config->mqtt.broker_uri, name, name_length);
+        config->mqtt.broker_uri[name_length] = '\0';
+        return true;
+    }
+    if (config_is_equal(key, key_length, "max_in_flight")) {
+        return config_parse_u8(cursor, &config->mqtt.max_in_flight);
+    }
+    for (uint8_t i = 0; i < MQTT_CHANNEL_COUNT; i++) {
+        if (config_is_equal(key, key_length, QOS_SETTINGS[i])) {
+            return config_parse_u8(cursor, &config->mqtt.qos[i]);
+        }
+    }
+
+    if (config_is_equal(key, key_length, "temperature_deadband")) {
+        return config_parse_u16(cursor, &config->deadband.temperature.absolute);
+    }
+    if (config_is_equal(key, key_length, "temperature_deadband_percent")) {
+        return config_parse_u16(cursor, &config->deadband.temperature.percent);
+    }
+    if (config_is_equal(key, key_length, "humidity_deadband")) {
+        return config_parse_u16(cursor, &config->deadband.humidity.absolute);
+    }
+    if (config_is_equal(key, key_length, "humidity_deadband_percent")) {
+        return config_parse_u16(cursor, &config->deadband.humidity.percent);
+    }
+
+    if (!config_parse_uint(cursor, &value)) {
+        return false;
+    }
+
+    if (config_is_equal(key, key_length, "sample_period_ms")) {
+        config->sample_period_ms = value;
+    } else if (config_is_equal(key, key_length, "window_period_ms")) {
+        config->window_period_ms = value;
+    } else if (config_is_equal(key, key_length, "batch_size") && device_config_is_batch_size_valid(value)) {
+        config->batch_size = (uint8_t)value;
+    } else if (config_is_equal(key, key_length, "heartbeat_ms")) {
+        config->deadband.heartbeat_ms = value;
+    } else if (config_is_equal(key, key_length, "outbox_limit")) {
+        config->mqtt.outbox_limit = value;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Load the runtime settings.
+ *
+ * Every setting missing from NVS or out of range is set to its default.
+ *
+ * @param[out] config Settings loaded.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if `config` is NULL.
+ */
+esp_err_t device_config_load(device_config_st *config) {
+    nvs_handle_t handle = 0;
+    uint32_t value      = 0;
+    uint8_t small_value = 0;
+
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *config = DEFAULT_CONFIG;
+    mqtt_config_load(&config->mqtt);
+    config->ip_mode = network_get_ip_mode();
+
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        ESP_LOGI(TAG, "No stored settings, using the defaults");
+        return ESP_OK;
+    }
+
+    if ((nvs_get_u32(handle, NVS_KEY_WINDOW_PERIOD, &value) == ESP_OK) && device_config_is_window_valid(value)) {
+        config->window_period_ms = value;
+    }
+    if ((nvs_get_u32(handle, NVS_KEY_SAMPLE_PERIOD, &value) == ESP_OK) &&
+        device_config_is_period_valid(value, config->window_period_ms)) {
+        config->sample_period_ms = value;
+    }
+    if ((nvs_get_u8(handle, NVS_KEY_PUBLISH_MODE, &small_value) == ESP_OK) && device_config_is_publish_mode_valid(small_value)) {
+        config->publish_mode = (mqtt_publish_mode_e)small_value;
+    }
+    if ((nvs_get_u8(handle, NVS_KEY_BATCH_SIZE, &small_value) == ESP_OK) && device_config_is_batch_size_valid(small_value)) {
+        config->batch_size = small_value;
+    }
+    if ((nvs_get_u8(handle, NVS_KEY_FORMAT, &small_value) == ESP_OK) && device_config_is_format_valid(small_value)) {
+        config->payload_format = (telemetry_format_e)small_value;
+    }
+
+    nvs_get_u16(handle, NVS_KEY_TEMPERATURE_DB, &config->deadband.temperature.absolute);
+    nvs_get_u16(handle, NVS_KEY_TEMPERATURE_DB_PCT, &config->deadband.temperature.percent);
+    nvs_get_u16(handle, NVS_KEY_HUMIDITY_DB, &config->deadband.humidity.absolute);
+    nvs_get_u16(handle, NVS_KEY_HUMIDITY_DB_PCT, &config->deadband.humidity.percent);
+    if ((nvs_get_u32(handle, NVS_KEY_HEARTBEAT, &value) == ESP_OK) &&
+        device_config_is_heartbeat_valid(value, config->window_period_ms)) {
+        config->deadband.heartbeat_ms = value;
+    }
+    if (!device_config_is_heartbeat_valid(config->deadband.heartbeat_ms, config->window_period_ms)) {
+        // The default heartbeat is shorter than a long stored window.
+        config->deadband.heartbeat_ms = config->window_period_ms;
+    }
+    if (nvs_get_u8(handle, NVS_KEY_LOW_POWER, &small_value) == ESP_OK) {
+        config->is_low_power_enabled = (small_value != 0);
+    }
+
+    nvs_close(handle);
+
+    ESP_LOGI(TAG, "Sample period %lu ms, window %lu ms, batches of %u, format %u",
+             (unsigned long)config->sample_period_ms, (unsigned long)config->window_period_ms,
+             config->batch_size, config->payload_format);
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Save the runtime settings.
+ *
+ * The settings are validated first and nothing is written if any of them is
+ * out of range.
+ *
+ * @param[in] config Settings to save.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if the settings are invalid,
+ *         or an NVS error code.
+ */
+esp_err_t device_config_save(const device_config_st *config) {
+    nvs_handle_t handle = 0;
+
+    if ((config == NULL) || !device_config_is_valid(config)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t result = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (result != ESP_OK) {
+        return result;
+    }
+
+    do {
+        result = nvs_set_u32(handle, NVS_KEY_SAMPLE_PERIOD, config->sample_period_ms);
+        if (result != ESP_OK) {
+            break;
+        }
+        result = nvs_set_u32(handle, NVS_KEY_WINDOW_PERIOD, config->window_period_ms);
+        if (result != ESP_OK) {
+            break;
+        }
+        result = nvs_set_u8(handle, NVS_KEY_PUBLISH_MODE, (uint8_t)config->publish_mode);
+        if (result != ESP_OK) {
+            break;
+        }
+        result = nvs_set_u8(handle, NVS_KEY_BATCH_SIZE, config->batch_size);
+        if (result != ESP_OK) {
+            break;
+        }
+        result = nvs_set_u8(handle, NVS_KEY_FORMAT, (uint8_t)config->payload_format);
+        if (result != ESP_OK) {
+            break;
+        }
+        result = nvs_set_u16(handle, NVS_KEY_TEMPERATURE_DB, config->deadband.temperature.absolute);
+        if (result != ESP_OK) {
+            break;
+        }
+        result = nvs_set_u16(handle, NVS_KEY_TEMPERATURE_DB_PCT, config->deadband.temperature.percent);
+        if (result != ESP_OK) {
+            break;
+        }
+        result = nvs_set_u16(handle, NVS_KEY_HUMIDITY_DB, config->deadband.humidity.absolute);
+        if (result != ESP_OK) {
+            break;
+        }
+        result = nvs_set_u16(handle, NVS_KEY_HUMIDITY_DB_PCT, config->deadband.humidity.percent);
+        if (result != ESP_OK) {
+            break;
+        }
+        result = nvs_set_u32(handle, NVS_KEY_HEARTBEAT, config->deadband.heartbeat_ms);
+        if (result != ESP_OK) {
+            break;
+        }
+        result = nvs_set_u8(handle, NVS_KEY_LOW_POWER, config->is_low_power_enabled ? 1 : 0);
+        if (result != ESP_OK) {
+            break;
+        }
+        result = nvs_commit(handle);
+    } while (0);
+
+    nvs_close(handle);
+
+    if (result == ESP_OK) {
+        result = mqtt_config_save(&config->mqtt);
+    }
+    if (result == ESP_OK) {
+        result = network_set_ip_mode(config->ip_mode);
+    }
+
+    if (result != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to save the settings: %s", esp_err_to_name(result));
+    }
+
+    return result;
+}
+
+/**
+ * @brief Apply a configuration document on top of the current settings.
+ *
+ * `config` is only updated if the whole document is valid.
+ *
+ * @param[in]     data   Document, not necessarily NUL-terminated.
+ * @param[in]     length Length of the document, in bytes.
+ * @param[in,out] config Current settings, updated with the settings of the document.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if the document is malformed,
+ *         names an unknown setting or holds an out-of-range value.
+ */
+esp_err_t device_config_parse(const char *data, size_t length, device_config_st *config) {
+    config_cursor_st cursor = {0};
+    const char *key         = NULL;
+    size_t key_length       = 0;
+
+    if ((data == NULL) || (config == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    cursor.position         = data;
+    cursor.end              = data + length;
+    device_config_st parsed = *config;
+
+    if (!config_expect(&cursor, '{')) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!config_expect(&cursor, '}')) {
+        do {
+            if (!config_parse_string(&cursor, &key, &key_length) || !config_expect(&cursor, ':') ||
+                !device_config_parse_setting(&cursor, key, key_length, &parsed)) {
+                return ESP_ERR_INVALID_ARG;
+            }
+        } while (config_expect(&cursor, ','));
+
+        if (!config_expect(&cursor, '}')) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    config_skip_spaces(&cursor);
+    if ((cursor.position != cursor.end) || !device_config_is_valid(&parsed)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *config = parsed;
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Check whether two configurations of the MQTT client are the same.
+ *
+ * @param[in] a First configuration.
+ * @param[in] b Second configuration.
+ *
+ * @return true if every setting is equal.
+ */
+static bool device_config_is_mqtt_equal(const mqtt_config_st *a, const mqtt_config_st *b) {
+    bool is_equal = (strncmp(a->broker_uri, b->broker_uri, MQTT_CONFIG_URI_SIZE) == 0) &&
+                    (a->buffer_size == b->buffer_size) &&
+                    (a->out_buffer_size == b->out_buffer_size) &&
+                    (a->outbox_limit == b->outbox_limit) &&
+                    (a->max_in_flight == b->max_in_flight);
+
+    for (uint8_t i = 0; i < MQTT_CHANNEL_COUNT; i++) {
+        is_equal = is_equal && (a->qos[i] == b->qos[i]);
+    }
+
+    return is_equal;
+}
+
+/**
+ * @brief Check whether two sets of settings are the same.
+ *
+ * Used to skip the NVS write when a configuration document changes nothing.
+ *
+ * @param[in] a First settings.
+ * @param[in] b Second settings.
+ *
+ * @return true if every setting is equal.
+ */
+bool device_config_is_equal(const device_config_st *a, const device_config_st *b) {
+    return (a->sample_period_ms == b->sample_period_ms) &&
+           (a->window_period_ms == b->window_period_ms) &&
+           (a->publish_mode == b->publish_mode) &&
+           (a->batch_size == b->batch_size) &&
+           (a->payload_format == b->payload_format) &&
+           (a->deadband.temperature.absolute == b->deadband.temperature.absolute) &&
+           (a->deadband.temperature.percent == b->deadband.temperature.percent) &&
+           (a->deadband.humidity.absolute == b->deadband.humidity.absolute) &&
+           (a->deadband.humidity.percent == b->deadband.humidity.percent) &&
+           (a->deadband.heartbeat_ms == b->deadband.heartbeat_ms) &&
+           (a->is_low_power_enabled == b->is_low_power_enabled) &&
+           (a->ip_mode == b->ip_mode) &&
+           device_config_is_mqtt_equal(&a->mqtt, &b->mqtt);
+}
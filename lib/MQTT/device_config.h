@@ -0,0 +1,126 @@
+#ifndef DEVICE_CONFIG_H
+#define DEVICE_CONFIG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "mqtt_config.h"
+#include "network_task.h"
+#include "telemetry_deadband.h"
+#include "telemetry_encoder.h"
+
+/**
+ * @file device_config.h
+ * @brief Runtime settings of the telemetry pipeline, changed remotely over MQTT.
+ *
+ * The settings are kept in the "device" NVS namespace, one key per setting,
+ * and fall back to the compiled-in defaults like `mqtt_config_st`. They are
+ * changed at runtime by publishing a flat JSON object to
+ * "/titanium/<unique_id>/config", holding only the settings to change:
+ *
+ *   {"sample_period_ms": 500, "window_period_ms": 30000,
+ *    "publish_mode": "batch", "batch_size": 16, "format": "binary",
+ *    "temperature_deadband": 50, "temperature_deadband_percent": 0,
+ *    "humidity_deadband": 200, "humidity_deadband_percent": 0,
+ *    "heartbeat_ms": 900000, "low_power": false, "ip_mode": "dhcp",
+ *    "broker_uri": "mqtts://broker.local", "outbox_limit": 16384,
+ *    "max_in_flight": 4, "qos_raw": 0, "qos_aggregate": 1, "qos_replay": 1,
+ *    "qos_metrics": 0}
+ *
+ * Deadbands are in hundredths of the unit of the channel, or of a percent of
+ * the last reported value, as in `telemetry_deadband_threshold_st`. The
+ * aggregation window lasts from 1 s to 1 h, takes effect when the current
+ * window closes, and must hold at least one sample period. The heartbeat of
+ * the deadband must last at least one window, 0 being rejected: the filter
+ * sees one sample per sensor and window, so a shorter heartbeat would report
+ * every one of them. The outbox limit is 0, for no limit, or at least
+ * `MQTT_CONFIG_MIN_OUTBOX_LIMIT` bytes, so the outbox can take a full batch.
+ * The low-power mode of `low_power.h` and the settings of the MQTT client,
+ * kept in the "mqtt" namespace of `mqtt_config.h`, are read once at boot, so
+ * changing them takes effect at the next boot. The IP configuration mode,
+ * "dhcp" or "static_cached", is kept by `network_set_ip_mode()` and applies
+ * from the next connection attempt. A document with an unknown key or an
+ * out-of-range value is rejected as a whole. The parser works in place on
+ * the received payload, which needs not be NUL-terminated, and never
+ * allocates.
+ */
+
+#define DEVICE_CONFIG_MAX_BATCH_SIZE 32  ///< Largest number of samples per batch.
+
+/**
+ * @brief Publishing modes supported by the MQTT task.
+ */
+typedef enum mqtt_publish_mode_t {
+    MQTT_PUBLISH_MODE_SINGLE = 0,  ///< One PUBLISH per channel for every sample.
+    MQTT_PUBLISH_MODE_COMBINED,    ///< One PUBLISH carrying every channel of a sample.
+    MQTT_PUBLISH_MODE_BATCH,       ///< One PUBLISH carrying every sample drained from the ring.
+} mqtt_publish_mode_e;
+
+/**
+ * @brief Runtime settings of the telemetry pipeline.
+ */
+typedef struct device_config_s {
+    uint32_t sample_period_ms;              ///< Period between two sweeps of the sensors, in milliseconds.
+    uint32_t window_period_ms;              ///< Length of an aggregation window, in milliseconds.
+    mqtt_publish_mode_e publish_mode;       ///< How samples are grouped into messages.
+    uint8_t batch_size;                     ///< Largest number of samples per batch.
+    telemetry_format_e payload_format;      ///< Format of the batch payloads.
+    telemetry_deadband_config_st deadband;  ///< Deadband applied before publishing or storing.
+    bool is_low_power_enabled;              ///< Whether the device duty-cycles in deep sleep, from the next boot.
+    mqtt_config_st mqtt;                    ///< Settings of the MQTT client, from the next boot.
+    network_ip_mode_e ip_mode;              ///< How the station obtains its IP configuration.
+} device_config_st;
+
+/**
+ * @brief Load the runtime settings.
+ *
+ * Every setting missing from NVS or out of range is set to its default.
+ *
+ * @param[out] config Settings loaded.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if `config` is NULL.
+ */
+esp_err_t device_config_load(device_config_st *config);
+
+/**
+ * @brief Save the runtime settings.
+ *
+ * The settings are validated first and nothing is written if any of them is
+ * out of range.
+ *
+ * @param[in] config Settings to save.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if the settings are invalid,
+ *         or an NVS error code.
+ */
+esp_err_t device_config_save(const device_config_st *config);
+
+/**
+ * @brief Apply a configuration document on top of the current settings.
+ *
+ * `config` is only updated if the whole document is valid.
+ *
+ * @param[in]     data   Document, not necessarily NUL-terminated.
+ * @param[in]     length Length of the document, in bytes.
+ * @param[in,out] config Current settings, updated with the settings of the document.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if the document is malformed,
+ *         names an unknown setting or holds an out-of-range value.
+ */
+esp_err_t device_config_parse(const char *data, size_t length, device_config_st *config);
+
+/**
+ * @brief Check whether two sets of settings are the same.
+ *
+ * Used to skip the NVS write when a configuration document changes nothing.
+ *
+ * @param[in] a First settings.
+ * @param[in] b Second settings.
+ *
+ * @return true if every setting is equal.
+ */
+bool device_config_is_equal(const device_config_st *a, const device_config_st *b);
+
+#endif /* DEVICE_CONFIG_H */
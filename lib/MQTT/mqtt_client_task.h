@@ -1,6 +1,8 @@
 #ifndef MQTT_CLIENT_TASK_H
 #define MQTT_CLIENT_TASK_H
 
+#include <stdbool.h>
+
 /**
  * @file mqtt_client_task.h
  * @brief MQTT Client interface for handling web requests on the ESP32.
@@ -16,4 +18,15 @@
  */
 void mqtt_client_task_execute(void* pvParameters);
 
+/**
+ * @brief Check whether every sample was delivered to the broker.
+ *
+ * Updated by the MQTT task on every wake-up, so it may lag the outbox by up
+ * to `MQTT_LINK_CHECK_TIMEOUT_MS`. Safe to call from any task.
+ *
+ * @return true if the broker session is up and no sample is left in the ring,
+ *         in the offline store or in the outbox.
+ */
+bool mqtt_client_task_is_idle(void);
+
 #endif /* MQTT_CLIENT_TASK_H */
@@ -0,0 +1,223 @@
+/**
+ * @file mqtt_config.c
+ * @brief Implementation of the persistent MQTT client configuration.
+ */
+
+#include "mqtt_config.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "nvs.h"
+#include "sdkconfig.h"
+
+static const char *TAG                     = "MQTT Config";      ///< Tag for logging.
+static const char *NVS_NAMESPACE           = "mqtt";             ///< NVS namespace of the MQTT settings.
+static const char *NVS_KEY_BROKER_URI      = "broker_uri";       ///< NVS key of the broker URI.
+static const char *NVS_KEY_BUFFER_SIZE     = "buffer_size";      ///< NVS key of the receive buffer size.
+static const char *NVS_KEY_OUT_BUFFER_SIZE = "out_buffer_size";  ///< NVS key of the send buffer size.
+static const char *NVS_KEY_OUTBOX_LIMIT    = "outbox_limit";     ///< NVS key of the outbox limit.
+static const char *NVS_KEY_MAX_IN_FLIGHT   = "max_in_flight";    ///< NVS key of the in-flight window.
+static const uint16_t MIN_BUFFER_SIZE      = 256;                ///< Smallest buffer accepted, in bytes.
+
+/** @brief NVS key of the QoS of each channel, indexed by `mqtt_channel_e`. */
+static const char *NVS_KEY_QOS[] = {"qos_raw", "qos_aggregate", "qos_replay", "qos_metrics"};
+
+_Static_assert(sizeof(NVS_KEY_QOS) / sizeof(NVS_KEY_QOS[0]) == MQTT_CHANNEL_COUNT, "One QoS key per channel");
+_Static_assert((CONFIG_TITANIUM_MQTT_OUTBOX_LIMIT == 0) || (CONFIG_TITANIUM_MQTT_OUTBOX_LIMIT >= MQTT_CONFIG_MIN_OUTBOX_LIMIT),
+               "The outbox limit must be 0 or hold a full batch payload");
+
+/**
+ * @brief Configuration used for every setting missing from NVS.
+ *
+ * The broker, the outbox limit, the in-flight window and the QoS of each
+ * channel come from the "Titanium MQTT" menu of menuconfig, so a fleet is
+ * built for its own broker. The send buffer holds a whole batch payload, so
+ * batches are enqueued in a single piece. By default, raw per-sample messages
+ * are superseded by the next sample and go out at QoS 0, like metrics which
+ * are superseded by the next snapshot; aggregates and replayed batches are
+ * acknowledged.
+ */
+static const mqtt_config_st DEFAULT_CONFIG = {
+    .broker_uri      = CONFIG_TITANIUM_MQTT_BROKER_URI,
+    .buffer_size     = 1024,
+    .out_buffer_size = 2560,
+    .outbox_limit    = CONFIG_TITANIUM_MQTT_OUTBOX_LIMIT,
+    .max_in_flight   = CONFIG_TITANIUM_MQTT_MAX_IN_FLIGHT,
+    .qos             = {
+        [MQTT_CHANNEL_RAW]       = CONFIG_TITANIUM_MQTT_QOS_RAW,
+        [MQTT_CHANNEL_AGGREGATE] = CONFIG_TITANIUM_MQTT_QOS_AGGREGATE,
+        [MQTT_CHANNEL_REPLAY]    = CONFIG_TITANIUM_MQTT_QOS_REPLAY,
+        [MQTT_CHANNEL_METRICS]   = CONFIG_TITANIUM_MQTT_QOS_METRICS,
+    },
+};
+
+/**
+ * @brief Check whether a broker URI is usable.
+ *
+ * @param[in] uri Broker URI, NUL-terminated within `MQTT_CONFIG_URI_SIZE`.
+ *
+ * @return true if the URI names a scheme and a host.
+ */
+static bool mqtt_config_is_uri_valid(const char *uri) {
+    size_t length    = strnlen(uri, MQTT_CONFIG_URI_SIZE);
+    const char *host = strstr(uri, "://");
+
+    return (length > 0) && (length < MQTT_CONFIG_URI_SIZE) && (host != NULL) && (host != uri) && (host[3] != '\0');
+}
+
+/**
+ * @brief Check whether an outbox limit is usable.
+ *
+ * The client checks a whole batch payload against the limit before building
+ * it, so a smaller limit would keep every batch and replay from being sent.
+ *
+ * @param[in] limit Outbox limit, in bytes.
+ *
+ * @return true if the limit is 0, for no limit, or holds a full batch payload.
+ */
+static bool mqtt_config_is_outbox_limit_valid(uint32_t limit) {
+    return (limit == 0) || (limit >= MQTT_CONFIG_MIN_OUTBOX_LIMIT);
+}
+
+/**
+ * @brief Check whether a configuration is usable.
+ *
+ * @param[in] config Configuration to check.
+ *
+ * @return true if every setting is in range.
+ */
+bool mqtt_config_is_valid(const mqtt_config_st *config) {
+    bool is_valid = mqtt_config_is_uri_valid(config->broker_uri) &&
+                    (config->buffer_size >= MIN_BUFFER_SIZE) &&
+                    (config->out_buffer_size >= MIN_BUFFER_SIZE) &&
+                    mqtt_config_is_outbox_limit_valid(config->outbox_limit) &&
+                    (config->max_in_flight > 0);
+
+    for (uint8_t i = 0; i < MQTT_CHANNEL_COUNT; i++) {
+        is_valid = is_valid && (config->qos[i] <= 2);
+    }
+
+    return is_valid;
+}
+
+/**
+ * @brief Load the MQTT configuration.
+ *
+ * Every setting missing from NVS or out of range is set to its default.
+ *
+ * @param[out] config Configuration loaded.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if `config` is NULL.
+ */
+esp_err_t mqtt_config_load(mqtt_config_st *config) {
+    nvs_handle_t handle = 0;
+
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *config = DEFAULT_CONFIG;
+
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        ESP_LOGI(TAG, "No stored settings, using the defaults");
+        return ESP_OK;
+    }
+
+    char uri[MQTT_CONFIG_URI_SIZE] = {0};
+    size_t uri_length              = sizeof(uri);
+    if ((nvs_get_str(handle, NVS_KEY_BROKER_URI, uri, &uri_length) == ESP_OK) && mqtt_config_is_uri_valid(uri)) {
+        memcpy(config->broker_uri, uri, sizeof(config->broker_uri));
+    }
+
+    uint16_t buffer_size = 0;
+    if ((nvs_get_u16(handle, NVS_KEY_BUFFER_SIZE, &buffer_size) == ESP_OK) && (buffer_size >= MIN_BUFFER_SIZE)) {
+        config->buffer_size = buffer_size;
+    }
+    if ((nvs_get_u16(handle, NVS_KEY_OUT_BUFFER_SIZE, &buffer_size) == ESP_OK) && (buffer_size >= MIN_BUFFER_SIZE)) {
+        config->out_buffer_size = buffer_size;
+    }
+
+    uint32_t outbox_limit = 0;
+    if ((nvs_get_u32(handle, NVS_KEY_OUTBOX_LIMIT, &outbox_limit) == ESP_OK) && mqtt_config_is_outbox_limit_valid(outbox_limit)) {
+        config->outbox_limit = outbox_limit;
+    }
+
+    uint8_t value = 0;
+    if ((nvs_get_u8(handle, NVS_KEY_MAX_IN_FLIGHT, &value) == ESP_OK) && (value > 0)) {
+        config->max_in_flight = value;
+    }
+    for (uint8_t i = 0; i < MQTT_CHANNEL_COUNT; i++) {
+        if ((nvs_get_u8(handle, NVS_KEY_QOS[i], &value) == ESP_OK) && (value <= 2)) {
+            config->qos[i] = value;
+        }
+    }
+
+    nvs_close(handle);
+
+    ESP_LOGI(TAG, "Broker %s, outbox limit %lu bytes, %u in flight, QoS %u/%u/%u/%u",
+             config->broker_uri, (unsigned long)config->outbox_limit, config->max_in_flight,
+             config->qos[MQTT_CHANNEL_RAW], config->qos[MQTT_CHANNEL_AGGREGATE], config->qos[MQTT_CHANNEL_REPLAY],
+             config->qos[MQTT_CHANNEL_METRICS]);
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Save the MQTT configuration.
+ *
+ * The configuration is validated first and nothing is written if any
+ * setting is out of range. Takes effect at the next boot.
+ *
+ * @param[in] config Configuration to save.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if the configuration is
+ *         invalid, or an NVS error code.
+ */
+esp_err_t mqtt_config_save(const mqtt_config_st *config) {
+    nvs_handle_t handle = 0;
+
+    if ((config == NULL) || !mqtt_config_is_valid(config)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t result = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (result != ESP_OK) {
+        return result;
+    }
+
+    do {
+        result = nvs_set_str(handle, NVS_KEY_BROKER_URI, config->broker_uri);
+        if (result != ESP_OK) {
+            break;
+        }
+        result = nvs_set_u16(handle, NVS_KEY_BUFFER_SIZE, config->buffer_size);
+        if (result != ESP_OK) {
+            break;
+        }
+        result = nvs_set_u16(handle, NVS_KEY_OUT_BUFFER_SIZE, config->out_buffer_size);
+        if (result != ESP_OK) {
+            break;
+        }
+        result = nvs_set_u32(handle, NVS_KEY_OUTBOX_LIMIT, config->outbox_limit);
+        if (result != ESP_OK) {
+            break;
+        }
+        result = nvs_set_u8(handle, NVS_KEY_MAX_IN_FLIGHT, config->max_in_flight);
+        for (uint8_t i = 0; (i < MQTT_CHANNEL_COUNT) && (result == ESP_OK); i++) {
+            result = nvs_set_u8(handle, NVS_KEY_QOS[i], config->qos[i]);
+        }
+        if (result != ESP_OK) {
+            break;
+        }
+        result = nvs_commit(handle);
+    } while (0);
+
+    nvs_close(handle);
+
+    if (result != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to save the settings: %s", esp_err_to_name(result));
+    }
+
+    return result;
+}
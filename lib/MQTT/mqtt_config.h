@@ -0,0 +1,81 @@
+#ifndef MQTT_CONFIG_H
+#define MQTT_CONFIG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+/**
+ * @file mqtt_config.h
+ * @brief Persistent configuration of the MQTT client.
+ *
+ * The broker URI, the client buffers, the outbox limit, the in-flight window
+ * and the QoS of every publishing channel are kept in the "mqtt" NVS
+ * namespace, one key per setting. Settings missing from NVS, or holding an
+ * invalid value, fall back to the defaults of the "Titanium MQTT" menu of
+ * menuconfig, so a device works out of the box and only the overridden
+ * settings need to be written. A running device overrides them through the
+ * configuration topic of `device_config.h`.
+ */
+
+#define MQTT_CONFIG_URI_SIZE 128           ///< Size of the broker URI buffer, including the terminator.
+#define MQTT_CONFIG_MIN_OUTBOX_LIMIT 2048  ///< Smallest outbox limit other than 0, one full batch payload, in bytes.
+
+/**
+ * @brief Publishing channels, each with its own QoS.
+ */
+typedef enum mqtt_channel_t {
+    MQTT_CHANNEL_RAW = 0,    ///< Per-sample messages of the single and combined publishing modes, high rate.
+    MQTT_CHANNEL_AGGREGATE,  ///< Batched aggregates of live samples.
+    MQTT_CHANNEL_REPLAY,     ///< Batches replayed from the offline store.
+    MQTT_CHANNEL_METRICS,    ///< Periodic snapshots of the runtime metrics.
+    MQTT_CHANNEL_COUNT,      ///< Number of channels.
+} mqtt_channel_e;
+
+/**
+ * @brief Configuration of the MQTT client.
+ */
+typedef struct mqtt_config_s {
+    char broker_uri[MQTT_CONFIG_URI_SIZE];  ///< URI of the broker, e.g. "mqtt://broker.local:1883".
+    uint16_t buffer_size;                   ///< Size of the receive buffer, in bytes.
+    uint16_t out_buffer_size;               ///< Size of the send buffer, in bytes.
+    uint32_t outbox_limit;                  ///< Largest size of the outbox, in bytes, 0 for no limit or at least `MQTT_CONFIG_MIN_OUTBOX_LIMIT`.
+    uint8_t max_in_flight;                  ///< Largest number of QoS 1 and 2 messages awaiting their acknowledgment.
+    uint8_t qos[MQTT_CHANNEL_COUNT];        ///< QoS of each channel.
+} mqtt_config_st;
+
+/**
+ * @brief Check whether a configuration is usable.
+ *
+ * @param[in] config Configuration to check.
+ *
+ * @return true if every setting is in range.
+ */
+bool mqtt_config_is_valid(const mqtt_config_st *config);
+
+/**
+ * @brief Load the MQTT configuration.
+ *
+ * Every setting missing from NVS or out of range is set to its default.
+ *
+ * @param[out] config Configuration loaded.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if `config` is NULL.
+ */
+esp_err_t mqtt_config_load(mqtt_config_st *config);
+
+/**
+ * @brief Save the MQTT configuration.
+ *
+ * The configuration is validated first and nothing is written if any
+ * setting is out of range. Takes effect at the next boot.
+ *
+ * @param[in] config Configuration to save.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if the configuration is
+ *         invalid, or an NVS error code.
+ */
+esp_err_t mqtt_config_save(const mqtt_config_st *config);
+
+#endif /* MQTT_CONFIG_H */
@@ -0,0 +1,96 @@
+/**
+ * @file mqtt_tls.c
+ * @brief Implementation of the TLS transport of the MQTT client.
+ */
+
+#include "mqtt_tls.h"
+
+#include <string.h>
+
+#include "esp_crt_bundle.h"
+#include "esp_log.h"
+#include "esp_transport_ssl.h"
+
+extern const char mqtt_ca_pem_start[] asm("_binary_mqtt_ca_pem_start");          ///< CA certificate of the broker.
+extern const char mqtt_ca_pem_end[] asm("_binary_mqtt_ca_pem_end");              ///< End of the CA certificate.
+extern const char mqtt_client_pem_start[] asm("_binary_mqtt_client_pem_start");  ///< Certificate of the device.
+extern const char mqtt_client_pem_end[] asm("_binary_mqtt_client_pem_end");      ///< End of the certificate of the device.
+extern const char mqtt_client_key_start[] asm("_binary_mqtt_client_key_start");  ///< Private key of the device.
+extern const char mqtt_client_key_end[] asm("_binary_mqtt_client_key_end");      ///< End of the private key of the device.
+
+static const char *TAG                 = "MQTT TLS";    ///< Tag for logging.
+static const char *TLS_SCHEME          = "mqtts://";    ///< Scheme of the broker URIs that require TLS.
+static const char *PEM_BLOCK_MARKER    = "-----BEGIN";  ///< Start of every PEM block.
+static const int MQTT_TLS_DEFAULT_PORT = 8883;          ///< Port used when the URI does not name one.
+
+/**
+ * @brief Check whether an embedded file holds a PEM block.
+ *
+ * Embedded text files are NUL-terminated, so the content can be searched as a
+ * string.
+ *
+ * @param[in] start Start of the embedded file.
+ *
+ * @return true if the file holds a PEM block.
+ */
+static bool mqtt_tls_is_pem_present(const char *start) {
+    return strstr(start, PEM_BLOCK_MARKER) != NULL;
+}
+
+/**
+ * @brief Check whether a broker URI requires TLS.
+ *
+ * @param[in] uri Broker URI.
+ *
+ * @return true if the scheme of the URI is "mqtts".
+ */
+bool mqtt_tls_is_required(const char *uri) {
+    return (uri != NULL) && (strncmp(uri, TLS_SCHEME, strlen(TLS_SCHEME)) == 0);
+}
+
+/**
+ * @brief Check whether the certificate and private key of the device are embedded.
+ *
+ * @return true if the client authenticates itself during the TLS handshake.
+ */
+bool mqtt_tls_has_client_certificate(void) {
+    return mqtt_tls_is_pem_present(mqtt_client_pem_start) && mqtt_tls_is_pem_present(mqtt_client_key_start);
+}
+
+/**
+ * @brief Create the TLS transport of the MQTT client.
+ *
+ * The transport is handed over to the client, which destroys it with itself.
+ *
+ * @return Transport handle, or NULL on failure.
+ */
+esp_transport_handle_t mqtt_tls_create_transport(void) {
+    esp_transport_handle_t transport = esp_transport_ssl_init();
+    if (transport == NULL) {
+        ESP_LOGE(TAG, "Failed to create the TLS transport");
+        return NULL;
+    }
+
+    esp_transport_set_default_port(transport, MQTT_TLS_DEFAULT_PORT);
+
+    if (mqtt_tls_is_pem_present(mqtt_ca_pem_start)) {
+        // The length of PEM data includes the terminator.
+        esp_transport_ssl_set_cert_data(transport, mqtt_ca_pem_start, mqtt_ca_pem_end - mqtt_ca_pem_start);
+    } else {
+        ESP_LOGW(TAG, "No CA certificate embedded, verifying the broker against the certificate bundle");
+        esp_transport_ssl_crt_bundle_attach(transport, esp_crt_bundle_attach);
+    }
+
+    if (mqtt_tls_has_client_certificate()) {
+        esp_transport_ssl_set_client_cert_data(transport, mqtt_client_pem_start, mqtt_client_pem_end - mqtt_client_pem_start);
+        esp_transport_ssl_set_client_key_data(transport, mqtt_client_key_start, mqtt_client_key_end - mqtt_client_key_start);
+        ESP_LOGI(TAG, "Mutual authentication enabled");
+    }
+
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    // The ticket stays in the heap of the transport and is lost in deep sleep, see mqtt_tls.h.
+    esp_transport_ssl_session_tickets_enable(transport);
+#endif
+
+    return transport;
+}
@@ -0,0 +1,65 @@
+#ifndef MQTT_TLS_H
+#define MQTT_TLS_H
+
+#include <stdbool.h>
+
+#include "esp_transport.h"
+
+/**
+ * @file mqtt_tls.h
+ * @brief TLS transport of the MQTT client.
+ *
+ * The certificates are embedded in the firmware from the `certs` directory:
+ * the CA certificate of the broker (`mqtt_ca.pem`) and, for mutual
+ * authentication, the certificate and private key of the device
+ * (`mqtt_client.pem` and `mqtt_client.key`). A file without a PEM block is
+ * treated as absent; without a CA certificate the broker is verified against
+ * the certificate bundle of ESP-IDF.
+ *
+ * The client owns a single transport for its whole lifetime, so the session
+ * ticket received from the broker is kept across reconnections and resumes
+ * the TLS session with an abbreviated handshake.
+ *
+ * The ticket does not survive deep sleep, so every flush wake of
+ * `low_power.h` pays a full handshake. Keeping it in RTC memory is blocked
+ * by two limits of ESP-IDF 5.2, not by the TLS protocol:
+ * - esp-mqtt only accepts an `esp_transport_handle_t`, and the SSL transport
+ *   keeps its `esp_tls_t` and `esp_tls_cfg_t` private. Neither
+ *   `esp_tls_get_client_session()` nor `esp_tls_cfg_t.client_session` can
+ *   be reached without replacing the whole SSL transport.
+ * - `esp_tls_client_session_t` is allocated on the heap by
+ *   `esp_tls_get_client_session()`, and its mbedtls session points to a
+ *   heap-allocated ticket and peer certificate. Copying it to RTC memory
+ *   leaves dangling pointers after the wake. esp-tls has no function to build
+ *   one from the bytes of `mbedtls_ssl_session_save()`.
+ * Lifting the limit takes a custom transport over mbedtls that saves the
+ * session with `mbedtls_ssl_session_save()` and restores it with
+ * `mbedtls_ssl_session_load()` and `mbedtls_ssl_set_session()`.
+ */
+
+/**
+ * @brief Check whether a broker URI requires TLS.
+ *
+ * @param[in] uri Broker URI.
+ *
+ * @return true if the scheme of the URI is "mqtts".
+ */
+bool mqtt_tls_is_required(const char *uri);
+
+/**
+ * @brief Check whether the certificate and private key of the device are embedded.
+ *
+ * @return true if the client authenticates itself during the TLS handshake.
+ */
+bool mqtt_tls_has_client_certificate(void);
+
+/**
+ * @brief Create the TLS transport of the MQTT client.
+ *
+ * The transport is handed over to the client, which destroys it with itself.
+ *
+ * @return Transport handle, or NULL on failure.
+ */
+esp_transport_handle_t mqtt_tls_create_transport(void);
+
+#endif /* MQTT_TLS_H */
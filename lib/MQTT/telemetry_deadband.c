@@ -0,0 +1,128 @@
+/**
+ * @file telemetry_deadband.c
+ * @brief Implementation of the report-by-exception filter.
+ */
+
+#include "telemetry_deadband.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Last sample reported for a sensor.
+ */
+typedef struct deadband_state_s {
+    bool has_reported;       ///< Whether a sample was reported since the filter was initialized.
+    int32_t temperature;     ///< Last reported temperature, in centi-degrees Celsius.
+    int32_t humidity;        ///< Last reported humidity, in centi-percent.
+    int64_t last_report_ms;  ///< Acquisition time of the last sample reported, in milliseconds of uptime.
+} deadband_state_st;
+
+static telemetry_deadband_config_st deadband_config                      = {0};  ///< Active configuration.
+static deadband_state_st deadband_states[TELEMETRY_DEADBAND_MAX_SENSORS] = {0};  ///< State of each sensor.
+static deadband_state_st saved_states[TELEMETRY_DEADBAND_MAX_SENSORS]    = {0};  ///< State of each sensor at the last checkpoint.
+
+/**
+ * @brief Check whether a value left the deadband around a reference.
+ *
+ * @param[in] threshold Deadband of the channel.
+ * @param[in] reference Last reported value, in hundredths.
+ * @param[in] value     Value to check, in hundredths.
+ *
+ * @return true if the change exceeds any enabled threshold.
+ */
+static bool is_outside_deadband(const telemetry_deadband_threshold_st *threshold, int32_t reference, int32_t value) {
+    int32_t change = abs(value - reference);
+
+    if ((threshold->absolute == 0) && (threshold->percent == 0)) {
+        return change > 0;
+    }
+
+    if ((threshold->absolute > 0) && (change > threshold->absolute)) {
+        return true;
+    }
+
+    // change > |reference| * (percent / 100) / 100, kept in integers.
+    return (threshold->percent > 0) && (((int64_t)change * 10000) > ((int64_t)abs(reference) * threshold->percent));
+}
+
+/**
+ * @brief Set the filter configuration and forget every reported value.
+ *
+ * @param[in] config Configuration to apply, copied by the filter.
+ */
+void telemetry_deadband_init(const telemetry_deadband_config_st *config) {
+    if (config != NULL) {
+        deadband_config = *config;
+    }
+    memset(deadband_states, 0, sizeof(deadband_states));
+    memset(saved_states, 0, sizeof(saved_states));
+}
+
+/**
+ * @brief Check whether a sample must be reported.
+ *
+ * The filter state is left untouched, call `telemetry_deadband_mark_reported()`
+ * once the sample has actually been handed over.
+ *
+ * @param[in] sample Sample to check.
+ *
+ * @return true if the sample is the first of its sensor, leaves the deadband
+ *         or the heartbeat interval has elapsed.
+ */
+bool telemetry_deadband_is_reportable(const temperature_data_st *sample) {
+    if ((sample == NULL) || (sample->sensor_id >= TELEMETRY_DEADBAND_MAX_SENSORS)) {
+        return true;
+    }
+
+    const deadband_state_st *state = &deadband_states[sample->sensor_id];
+    int64_t sample_ms              = sample->timestamp_us / 1000;
+    if (!state->has_reported || ((sample_ms - state->last_report_ms) >= deadband_config.heartbeat_ms)) {
+        return true;
+    }
+
+    const int32_t temperatures[] = {sample->temperature, sample->temperature_min, sample->temperature_max};
+    const int32_t humidities[]   = {sample->humidity, sample->humidity_min, sample->humidity_max};
+
+    for (uint8_t i = 0; i < sizeof(temperatures) / sizeof(temperatures[0]); i++) {
+        if (is_outside_deadband(&deadband_config.temperature, state->temperature, temperatures[i]) ||
+            is_outside_deadband(&deadband_config.humidity, state->humidity, humidities[i])) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Record a sample as reported.
+ *
+ * @param[in] sample Sample reported.
+ */
+void telemetry_deadband_mark_reported(const temperature_data_st *sample) {
+    if ((sample == NULL) || (sample->sensor_id >= TELEMETRY_DEADBAND_MAX_SENSORS)) {
+        return;
+    }
+
+    deadband_state_st *state = &deadband_states[sample->sensor_id];
+    state->has_reported      = true;
+    state->temperature       = sample->temperature;
+    state->humidity          = sample->humidity;
+    state->last_report_ms    = sample->timestamp_us / 1000;
+}
+
+/**
+ * @brief Save the state of every sensor, to be restored by `telemetry_deadband_rollback()`.
+ */
+void telemetry_deadband_checkpoint(void) {
+    memcpy(saved_states, deadband_states, sizeof(deadband_states));
+}
+
+/**
+ * @brief Restore the state saved by the last `telemetry_deadband_checkpoint()`.
+ *
+ * Reports recorded since the checkpoint are forgotten.
+ */
+void telemetry_deadband_rollback(void) {
+    memcpy(deadband_states, saved_states, sizeof(deadband_states));
+}
@@ -0,0 +1,89 @@
+#ifndef TELEMETRY_DEADBAND_H
+#define TELEMETRY_DEADBAND_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "temperature_monitor_task.h"
+
+/**
+ * @file telemetry_deadband.h
+ * @brief Report-by-exception filter placed between the sensor queue and the publisher.
+ *
+ * A sample is reported only when one of its channels moved away from the last
+ * reported value by more than the deadband of that channel, or when nothing was
+ * reported for a sensor during the heartbeat interval. The interval is measured
+ * between the acquisition times of the samples, not the time they are
+ * processed, so a backlog drained in one pass keeps its heartbeats. The
+ * minimum and maximum of aggregated samples are checked as well, so a short
+ * spike is reported even if the mean stayed within the deadband.
+ *
+ * The filter keeps one state per sensor and is meant to be used by the MQTT
+ * task only. Samples of a batch are marked as reported while it is encoded,
+ * so later samples of the same batch are compared with them; the state can be
+ * saved with `telemetry_deadband_checkpoint()` beforehand and restored with
+ * `telemetry_deadband_rollback()` if the batch is not handed over after all.
+ */
+
+#define TELEMETRY_DEADBAND_MAX_SENSORS 8  ///< Number of sensors tracked, samples of other sensors are always reported.
+
+/**
+ * @brief Deadband of one channel.
+ *
+ * A change is reportable when it exceeds any enabled threshold. A threshold of
+ * 0 disables it; with both disabled, every change is reportable.
+ */
+typedef struct telemetry_deadband_threshold_s {
+    uint16_t absolute;  ///< Largest change ignored, in hundredths of the unit of the channel.
+    uint16_t percent;   ///< Largest change ignored, in hundredths of a percent of the last reported value.
+} telemetry_deadband_threshold_st;
+
+/**
+ * @brief Configuration of the deadband filter.
+ */
+typedef struct telemetry_deadband_config_s {
+    telemetry_deadband_threshold_st temperature;  ///< Deadband of the temperature, in degrees Celsius.
+    telemetry_deadband_threshold_st humidity;     ///< Deadband of the relative humidity, in percentage (%).
+    uint32_t heartbeat_ms;                        ///< Longest silence per sensor before a sample is reported anyway.
+} telemetry_deadband_config_st;
+
+/**
+ * @brief Set the filter configuration and forget every reported value.
+ *
+ * @param[in] config Configuration to apply, copied by the filter.
+ */
+void telemetry_deadband_init(const telemetry_deadband_config_st *config);
+
+/**
+ * @brief Check whether a sample must be reported.
+ *
+ * The filter state is left untouched, call `telemetry_deadband_mark_reported()`
+ * once the sample has actually been handed over.
+ *
+ * @param[in] sample Sample to check.
+ *
+ * @return true if the sample is the first of its sensor, leaves the deadband
+ *         or the heartbeat interval has elapsed.
+ */
+bool telemetry_deadband_is_reportable(const temperature_data_st *sample);
+
+/**
+ * @brief Record a sample as reported.
+ *
+ * @param[in] sample Sample reported.
+ */
+void telemetry_deadband_mark_reported(const temperature_data_st *sample);
+
+/**
+ * @brief Save the state of every sensor, to be restored by `telemetry_deadband_rollback()`.
+ */
+void telemetry_deadband_checkpoint(void);
+
+/**
+ * @brief Restore the state saved by the last `telemetry_deadband_checkpoint()`.
+ *
+ * Reports recorded since the checkpoint are forgotten.
+ */
+void telemetry_deadband_rollback(void);
+
+#endif /* TELEMETRY_DEADBAND_H */
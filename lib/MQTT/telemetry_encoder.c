@@ -0,0 +1,198 @@
+/**
+ * @file telemetry_encoder.c
+ * @brief Implementation of the JSON and binary telemetry encoders.
+ */
+
+#include "telemetry_encoder.h"
+#include "utils.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static const char JSON_TRAILER[] = "]}";  ///< Closing characters of a JSON payload.
+
+/**
+ * @brief Store a 16-bit value in little-endian order.
+ */
+static void put_le16(uint8_t *buffer, uint16_t value) {
+    buffer[0] = (uint8_t)(value);
+    buffer[1] = (uint8_t)(value >> 8);
+}
+
+/**
+ * @brief Store a 32-bit value in little-endian order.
+ */
+static void put_le32(uint8_t *buffer, uint32_t value) {
+    put_le16(&buffer[0], (uint16_t)value);
+    put_le16(&buffer[2], (uint16_t)(value >> 16));
+}
+
+/**
+ * @brief Store a 64-bit value in little-endian order.
+ */
+static void put_le64(uint8_t *buffer, uint64_t value) {
+    for (uint8_t i = 0; i < 8; i++) {
+        buffer[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+/**
+ * @brief Start a new payload.
+ *
+ * For binary payloads the header is written with a sample count of 0, which is
+ * patched by `telemetry_encoder_finish()`.
+ *
+ * @param[out] encoder      Encoder state to initialize.
+ * @param[in]  format       Format of the payload.
+ * @param[in]  buffer       Buffer receiving the payload.
+ * @param[in]  size         Size of the buffer, in bytes.
+ * @param[in]  timestamp_ms Timestamp of the batch, in milliseconds since the epoch.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid parameters or
+ *         ESP_ERR_NO_MEM if the buffer cannot hold an empty payload.
+ */
+esp_err_t telemetry_encoder_begin(telemetry_encoder_st *encoder, telemetry_format_e format,
+                                  uint8_t *buffer, size_t size, int64_t timestamp_ms) {
+    if ((encoder == NULL) || (buffer == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    encoder->format       = format;
+    encoder->buffer       = buffer;
+    encoder->size         = size;
+    encoder->length       = 0;
+    encoder->timestamp_ms = timestamp_ms;
+    encoder->sample_count = 0;
+
+    if (format == TELEMETRY_FORMAT_BINARY) {
+        if (size < TELEMETRY_BINARY_HEADER_SIZE) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        buffer[0] = TELEMETRY_BINARY_VERSION;
+        buffer[1] = 0;
+        put_le16(&buffer[2], 0);
+        put_le64(&buffer[4], (uint64_t)timestamp_ms);
+        encoder->length = TELEMETRY_BINARY_HEADER_SIZE;
+    } else {
+        char time_buffer[32] = {0};
+        // Round toward the past, so a time before the epoch keeps a millisecond field in 0..999.
+        int64_t seconds      = timestamp_ms / 1000;
+        int64_t milliseconds = timestamp_ms % 1000;
+        if (milliseconds < 0) {
+            seconds--;
+            milliseconds += 1000;
+        }
+        format_timestamp_in_iso_format((time_t)seconds, time_buffer, sizeof(time_buffer));
+
+        int written = snprintf((char *)buffer, size, "{\"timestamp\": \"%s.%03u\", \"samples\": [",
+                               time_buffer, (unsigned)milliseconds);
+        if ((written < 0) || ((size_t)written + sizeof(JSON_TRAILER) > size)) {
+            return ESP_ERR_NO_MEM;
+        }
+        encoder->length = written;
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Append one sample to the payload.
+ *
+ * The payload is left untouched if the sample does not fit, so the caller can
+ * keep the sample for the next payload.
+ *
+ * @param[in,out] encoder      Encoder state.
+ * @param[in]     sample       Sample to append.
+ * @param[in]     timestamp_ms Time the sample was acquired, in milliseconds since the epoch.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid parameters or
+ *         ESP_ERR_NO_MEM if the sample does not fit in the buffer.
+ */
+esp_err_t telemetry_encoder_append(telemetry_encoder_st *encoder, const temperature_data_st *sample, int64_t timestamp_ms) {
+    if ((encoder == NULL) || (sample == NULL) || (encoder->sample_count == UINT16_MAX)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int64_t offset_ms = timestamp_ms - encoder->timestamp_ms;
+    if ((offset_ms < INT32_MIN) || (offset_ms > INT32_MAX)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const int16_t temperatures[] = {sample->temperature, sample->temperature_min, sample->temperature_max, (int16_t)sample->temperature_stddev};
+    const uint16_t humidities[]  = {sample->humidity, sample->humidity_min, sample->humidity_max, sample->humidity_stddev};
+
+    if (encoder->format == TELEMETRY_FORMAT_BINARY) {
+        if (encoder->length + TELEMETRY_BINARY_SAMPLE_SIZE > encoder->size) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        uint8_t *record = &encoder->buffer[encoder->length];
+        record[0]       = sample->sensor_id;
+        record[1]       = 0;
+        put_le16(&record[2], sample->sample_count);
+        put_le32(&record[4], sample->sequence);
+        put_le32(&record[8], (uint32_t)(int32_t)offset_ms);
+        for (uint8_t i = 0; i < TELEMETRY_STATS_COUNT; i++) {
+            put_le16(&record[12 + 2 * i], (uint16_t)temperatures[i]);
+            put_le16(&record[12 + 2 * (TELEMETRY_STATS_COUNT + i)], humidities[i]);
+        }
+        encoder->length += TELEMETRY_BINARY_SAMPLE_SIZE;
+    } else {
+        char temperature_buffer[TELEMETRY_STATS_COUNT][16] = {0};
+        char humidity_buffer[TELEMETRY_STATS_COUNT][16]    = {0};
+        for (uint8_t i = 0; i < TELEMETRY_STATS_COUNT; i++) {
+            format_centi(temperature_buffer[i], sizeof(temperature_buffer[i]), temperatures[i]);
+            format_centi(humidity_buffer[i], sizeof(humidity_buffer[i]), humidities[i]);
+        }
+
+        size_t available = encoder->size - encoder->length;
+        int written      = snprintf((char *)&encoder->buffer[encoder->length], available,
+                                    "%s{\"sensor\": %u, \"seq\": %lu, \"offset_ms\": %ld, \"count\": %u, "
+                                    "\"temperature\": %s, \"temperature_min\": %s, \"temperature_max\": %s, \"temperature_stddev\": %s, "
+                                    "\"humidity\": %s, \"humidity_min\": %s, \"humidity_max\": %s, \"humidity_stddev\": %s}",
+                                    (encoder->sample_count > 0) ? ", " : "",
+                                    (unsigned)sample->sensor_id,
+                                    (unsigned long)sample->sequence,
+                                    (long)offset_ms,
+                                    (unsigned)sample->sample_count,
+                                    temperature_buffer[0], temperature_buffer[1], temperature_buffer[2], temperature_buffer[3],
+                                    humidity_buffer[0], humidity_buffer[1], humidity_buffer[2], humidity_buffer[3]);
+
+        // Keep room for the trailer so the payload can always be completed.
+        if ((written < 0) || ((size_t)written + sizeof(JSON_TRAILER) > available)) {
+            encoder->buffer[encoder->length] = '\0';
+            return ESP_ERR_NO_MEM;
+        }
+        encoder->length += written;
+    }
+
+    encoder->sample_count++;
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Complete the payload.
+ *
+ * @param[in,out] encoder Encoder state.
+ * @param[out]    length  Total length of the payload, in bytes.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid parameters.
+ */
+esp_err_t telemetry_encoder_finish(telemetry_encoder_st *encoder, size_t *length) {
+    if ((encoder == NULL) || (length == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (encoder->format == TELEMETRY_FORMAT_BINARY) {
+        put_le16(&encoder->buffer[2], encoder->sample_count);
+    } else {
+        memcpy(&encoder->buffer[encoder->length], JSON_TRAILER, sizeof(JSON_TRAILER));
+        encoder->length += sizeof(JSON_TRAILER) - 1;
+    }
+
+    *length = encoder->length;
+
+    return ESP_OK;
+}
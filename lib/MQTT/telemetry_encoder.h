@@ -0,0 +1,110 @@
+#ifndef TELEMETRY_ENCODER_H
+#define TELEMETRY_ENCODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "temperature_monitor_task.h"
+
+/**
+ * @file telemetry_encoder.h
+ * @brief Encoders turning batches of sensor samples into MQTT payloads.
+ *
+ * The encoder is fed one sample at a time and writes directly into a buffer
+ * owned by the caller, so building a payload never allocates. Two formats are
+ * supported:
+ *
+ * - JSON, human readable:
+ *   {"timestamp": "<ISO 8601>", "samples": [{"sensor": 0, "seq": 42, "offset_ms": 1500, "count": 120,
+ *    "temperature": 21.53, "temperature_min": 21.40, "temperature_max": 21.71, "temperature_stddev": 0.06,
+ *    "humidity": 40.12, "humidity_min": 39.80, "humidity_max": 40.35, "humidity_stddev": 0.11}, ...]}
+ *
+ * - Binary, a versioned fixed-layout record (all fields little-endian):
+ *   | Offset | Size | Field                                      |
+ *   |--------|------|--------------------------------------------|
+ *   | 0      | 1    | Format version (`TELEMETRY_BINARY_VERSION`) |
+ *   | 1      | 1    | Reserved, always 0                         |
+ *   | 2      | 2    | Number of samples (uint16)                 |
+ *   | 4      | 8    | Batch timestamp, epoch milliseconds (int64) |
+ *   | 12     | 28*n | Samples                                    |
+ *
+ *   Each sample holds the sensor identifier (uint8), a reserved byte always
+ *   0, the number of readings aggregated (uint16), the sequence number of the
+ *   sample (uint32), its acquisition time relative to the batch timestamp in
+ *   milliseconds (int32), then the mean, minimum, maximum and standard
+ *   deviation of the temperature in centi-degrees Celsius (4 x int16) and of
+ *   the relative humidity in centi-percent (4 x uint16).
+ *
+ * Samples already hold fixed-point hundredths, which are copied to the binary
+ * format as is and printed with two decimals in JSON, so neither format
+ * relies on float formatting. Sample times are encoded as offsets from the
+ * batch timestamp, so a calendar time is formatted once per payload at most.
+ */
+
+#define TELEMETRY_BINARY_VERSION 4       ///< Version byte leading every binary payload.
+#define TELEMETRY_BINARY_HEADER_SIZE 12  ///< Size of the binary header, in bytes.
+#define TELEMETRY_BINARY_SAMPLE_SIZE 28  ///< Size of one binary sample, in bytes.
+#define TELEMETRY_STATS_COUNT 4          ///< Statistics per quantity: mean, minimum, maximum, standard deviation.
+
+/**
+ * @brief Payload formats supported by the telemetry encoder.
+ */
+typedef enum telemetry_format_t {
+    TELEMETRY_FORMAT_JSON = 0,  ///< JSON document with an array of samples.
+    TELEMETRY_FORMAT_BINARY,    ///< Versioned fixed-layout binary record.
+} telemetry_format_e;
+
+/**
+ * @brief State of a payload being built.
+ */
+typedef struct telemetry_encoder_s {
+    telemetry_format_e format;  ///< Format of the payload.
+    uint8_t *buffer;            ///< Buffer receiving the payload, owned by the caller.
+    size_t size;                ///< Size of the buffer, in bytes.
+    size_t length;              ///< Number of bytes written so far.
+    int64_t timestamp_ms;       ///< Timestamp of the batch, in milliseconds since the epoch.
+    uint16_t sample_count;      ///< Number of samples appended so far.
+} telemetry_encoder_st;
+
+/**
+ * @brief Start a new payload.
+ *
+ * @param[out] encoder      Encoder state to initialize.
+ * @param[in]  format       Format of the payload.
+ * @param[in]  buffer       Buffer receiving the payload.
+ * @param[in]  size         Size of the buffer, in bytes.
+ * @param[in]  timestamp_ms Timestamp of the batch, in milliseconds since the epoch.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid parameters or
+ *         ESP_ERR_NO_MEM if the buffer cannot hold an empty payload.
+ */
+esp_err_t telemetry_encoder_begin(telemetry_encoder_st *encoder, telemetry_format_e format,
+                                  uint8_t *buffer, size_t size, int64_t timestamp_ms);
+
+/**
+ * @brief Append one sample to the payload.
+ *
+ * The payload is left untouched if the sample does not fit, so the caller can
+ * keep the sample for the next payload.
+ *
+ * @param[in,out] encoder      Encoder state.
+ * @param[in]     sample       Sample to append.
+ * @param[in]     timestamp_ms Time the sample was acquired, in milliseconds since the epoch.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid parameters or
+ *         ESP_ERR_NO_MEM if the sample does not fit in the buffer.
+ */
+esp_err_t telemetry_encoder_append(telemetry_encoder_st *encoder, const temperature_data_st *sample, int64_t timestamp_ms);
+
+/**
+ * @brief Complete the payload.
+ *
+ * @param[in,out] encoder Encoder state.
+ * @param[out]    length  Total length of the payload, in bytes.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid parameters.
+ */
+esp_err_t telemetry_encoder_finish(telemetry_encoder_st *encoder, size_t *length);
+
+#endif /* TELEMETRY_ENCODER_H */
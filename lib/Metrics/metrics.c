@@ -0,0 +1,260 @@
+/**
+ * @file metrics.c
+ * @brief Implementation of the runtime metrics registry.
+ */
+
+#include "metrics.h"
+#include "utils.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "esp_heap_caps.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/** @brief Name of each counter, as reported. */
+static const char *COUNTER_NAMES[METRICS_COUNTER_COUNT] = {
+    [METRICS_COUNTER_SAMPLES_DROPPED]       = "samples_dropped",
+    [METRICS_COUNTER_SENSOR_READ_ERRORS]    = "sensor_read_errors",
+    [METRICS_COUNTER_I2C_ERRORS]            = "i2c_errors",
+    [METRICS_COUNTER_MQTT_ENQUEUED]         = "mqtt_enqueued",
+    [METRICS_COUNTER_MQTT_PUBLISH_FAILURES] = "mqtt_publish_failures",
+    [METRICS_COUNTER_MQTT_BACKPRESSURE]     = "mqtt_backpressure",
+    [METRICS_COUNTER_STORE_FAILURES]        = "store_failures",
+    [METRICS_COUNTER_LOG_OVERRUNS]          = "log_overruns",
+};
+
+/** @brief Name of each gauge, as reported. */
+static const char *GAUGE_NAMES[METRICS_GAUGE_COUNT] = {
+    [METRICS_GAUGE_SAMPLE_RING_HIGH_WATER] = "sample_ring_high_water",
+    [METRICS_GAUGE_MQTT_OUTBOX_BYTES]      = "mqtt_outbox_bytes",
+    [METRICS_GAUGE_MQTT_IN_FLIGHT]         = "mqtt_in_flight",
+};
+
+/** @brief Name of each histogram, as reported. */
+static const char *HISTOGRAM_NAMES[METRICS_HISTOGRAM_COUNT] = {
+    [METRICS_HISTOGRAM_I2C_TRANSACTION_US] = "i2c_transaction_us",
+    [METRICS_HISTOGRAM_SAMPLE_LATENCY_MS]  = "sample_latency_ms",
+};
+
+/**
+ * @brief Upper bound of every bucket but the last one, in the unit of each histogram.
+ */
+static const uint32_t HISTOGRAM_BOUNDS[METRICS_HISTOGRAM_COUNT][METRICS_HISTOGRAM_BUCKETS - 1] = {
+    [METRICS_HISTOGRAM_I2C_TRANSACTION_US] = {100, 200, 500, 1000, 2000, 5000, 10000},
+    [METRICS_HISTOGRAM_SAMPLE_LATENCY_MS]  = {10, 100, 1000, 5000, 30000, 60000, 300000},
+};
+
+/**
+ * @brief Values recorded in a histogram.
+ */
+typedef struct metrics_histogram_s {
+    atomic_uint counts[METRICS_HISTOGRAM_BUCKETS];  ///< Number of values recorded in each bucket.
+    atomic_uint max;                                ///< Largest value recorded.
+} metrics_histogram_st;
+
+static atomic_uint counters[METRICS_COUNTER_COUNT]              = {0};                           ///< Value of each counter.
+static atomic_uint gauges[METRICS_GAUGE_COUNT]                  = {0};                           ///< Value of each gauge.
+static metrics_histogram_st histograms[METRICS_HISTOGRAM_COUNT] = {0};                           ///< Values of each histogram.
+static TaskHandle_t tasks[METRICS_MAX_TASKS]                    = {0};                           ///< Tasks whose stack watermark is reported.
+static size_t task_count                                        = 0;                             ///< Number of tasks registered.
+static portMUX_TYPE tasks_lock                                  = portMUX_INITIALIZER_UNLOCKED;  ///< Guards tasks across cores.
+
+/**
+ * @brief Add a value to a counter.
+ *
+ * @param[in] counter Counter to increment.
+ * @param[in] value   Value to add.
+ */
+void metrics_counter_add(metrics_counter_e counter, uint32_t value) {
+    if (counter < METRICS_COUNTER_COUNT) {
+        atomic_fetch_add_explicit(&counters[counter], value, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Set the value of a gauge.
+ *
+ * @param[in] gauge Gauge to set.
+ * @param[in] value New value of the gauge.
+ */
+void metrics_gauge_set(metrics_gauge_e gauge, uint32_t value) {
+    if (gauge < METRICS_GAUGE_COUNT) {
+        atomic_store_explicit(&gauges[gauge], value, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Record a value in a histogram.
+ *
+ * @param[in] histogram Histogram to record the value in.
+ * @param[in] value     Value to record, in the unit of the histogram.
+ */
+void metrics_histogram_record(metrics_histogram_e histogram, uint32_t value) {
+    if (histogram >= METRICS_HISTOGRAM_COUNT) {
+        return;
+    }
+
+    metrics_histogram_st *target = &histograms[histogram];
+    const uint32_t *bounds       = HISTOGRAM_BOUNDS[histogram];
+    uint8_t bucket               = 0;
+
+    while ((bucket < METRICS_HISTOGRAM_BUCKETS - 1) && (value > bounds[bucket])) {
+        bucket++;
+    }
+    atomic_fetch_add_explicit(&target->counts[bucket], 1, memory_order_relaxed);
+
+    unsigned int max = atomic_load_explicit(&target->max, memory_order_relaxed);
+    while ((value > max) &&
+           !atomic_compare_exchange_weak_explicit(&target->max, &max, value, memory_order_relaxed, memory_order_relaxed)) {
+        // max was reloaded by the failed exchange.
+    }
+}
+
+/**
+ * @brief Register the calling task, so its stack watermark is reported.
+ *
+ * A task must not be deleted once registered.
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if `METRICS_MAX_TASKS` tasks are
+ *         already registered.
+ */
+esp_err_t metrics_register_task(void) {
+    esp_err_t result = ESP_ERR_NO_MEM;
+
+    taskENTER_CRITICAL(&tasks_lock);
+    if (task_count < METRICS_MAX_TASKS) {
+        tasks[task_count++] = xTaskGetCurrentTaskHandle();
+        result              = ESP_OK;
+    }
+    taskEXIT_CRITICAL(&tasks_lock);
+
+    return result;
+}
+
+/**
+ * @brief Append a JSON object mapping names to atomic values.
+ *
+ * @param[out]    buffer Buffer holding the document.
+ * @param[in]     size   Size of the buffer, in bytes.
+ * @param[in,out] length Length of the document, in bytes.
+ * @param[in]     key    Key of the object.
+ * @param[in]     names  Name of each value.
+ * @param[in]     values Values.
+ * @param[in]     count  Number of values.
+ *
+ * @return true if the object fits in the buffer.
+ */
+static bool metrics_append_values(char *buffer, size_t size, size_t *length, const char *key,
+                                  const char *const *names, atomic_uint *values, size_t count) {
+    bool is_fitting = format_append(buffer, size, length, ", \"%s\": {", key);
+
+    for (size_t i = 0; is_fitting && (i < count); i++) {
+        is_fitting = format_append(buffer, size, length, "%s\"%s\": %u", (i > 0) ? ", " : "", names[i],
+                                    atomic_load_explicit(&values[i], memory_order_relaxed));
+    }
+
+    return is_fitting && format_append(buffer, size, length, "}");
+}
+
+/**
+ * @brief Append the histograms to a document.
+ *
+ * @param[out]    buffer Buffer holding the document.
+ * @param[in]     size   Size of the buffer, in bytes.
+ * @param[in,out] length Length of the document, in bytes.
+ *
+ * @return true if the histograms fit in the buffer.
+ */
+static bool metrics_append_histograms(char *buffer, size_t size, size_t *length) {
+    bool is_fitting = format_append(buffer, size, length, ", \"histograms\": {");
+
+    for (size_t i = 0; is_fitting && (i < METRICS_HISTOGRAM_COUNT); i++) {
+        is_fitting = format_append(buffer, size, length, "%s\"%s\": {\"bounds\": [", (i > 0) ? ", " : "", HISTOGRAM_NAMES[i]);
+        for (size_t bucket = 0; is_fitting && (bucket < METRICS_HISTOGRAM_BUCKETS - 1); bucket++) {
+            is_fitting = format_append(buffer, size, length, "%s%lu", (bucket > 0) ? ", " : "", (unsigned long)HISTOGRAM_BOUNDS[i][bucket]);
+        }
+        is_fitting = is_fitting && format_append(buffer, size, length, "], \"counts\": [");
+        for (size_t bucket = 0; is_fitting && (bucket < METRICS_HISTOGRAM_BUCKETS); bucket++) {
+            is_fitting = format_append(buffer, size, length, "%s%u", (bucket > 0) ? ", " : "",
+                                        atomic_load_explicit(&histograms[i].counts[bucket], memory_order_relaxed));
+        }
+        is_fitting = is_fitting && format_append(buffer, size, length, "], \"max\": %u}",
+                                                  atomic_load_explicit(&histograms[i].max, memory_order_relaxed));
+    }
+
+    return is_fitting && format_append(buffer, size, length, "}");
+}
+
+/**
+ * @brief Append the stack watermark of every registered task to a document.
+ *
+ * @param[out]    buffer Buffer holding the document.
+ * @param[in]     size   Size of the buffer, in bytes.
+ * @param[in,out] length Length of the document, in bytes.
+ *
+ * @return true if the tasks fit in the buffer.
+ */
+static bool metrics_append_tasks(char *buffer, size_t size, size_t *length) {
+    TaskHandle_t snapshot[METRICS_MAX_TASKS] = {0};
+    size_t count                             = 0;
+
+    taskENTER_CRITICAL(&tasks_lock);
+    count = task_count;
+    for (size_t i = 0; i < count; i++) {
+        snapshot[i] = tasks[i];
+    }
+    taskEXIT_CRITICAL(&tasks_lock);
+
+    bool is_fitting = format_append(buffer, size, length, ", \"tasks\": [");
+    for (size_t i = 0; is_fitting && (i < count); i++) {
+        // The watermark is the smallest amount of stack left so far, in bytes.
+        is_fitting = format_append(buffer, size, length, "%s{\"name\": \"%s\", \"stack_free\": %u}",
+                                    (i > 0) ? ", " : "", pcTaskGetName(snapshot[i]),
+                                    (unsigned)uxTaskGetStackHighWaterMark(snapshot[i]));
+    }
+
+    return is_fitting && format_append(buffer, size, length, "]");
+}
+
+/**
+ * @brief Format a snapshot of every metric as a JSON document.
+ *
+ * @param[out] buffer Buffer receiving the document, NUL-terminated.
+ * @param[in]  size   Size of the buffer, in bytes.
+ * @param[out] length Length of the document, in bytes.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid parameters or
+ *         ESP_ERR_NO_MEM if the document does not fit in the buffer.
+ */
+esp_err_t metrics_format_json(char *buffer, size_t size, size_t *length) {
+    if ((buffer == NULL) || (size == 0) || (length == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *length = 0;
+
+    bool is_fitting = format_append(buffer, size, length,
+                                     "{\"uptime_s\": %lld, \"heap\": {\"free\": %lu, \"min_free\": %lu, \"largest_block\": %u}",
+                                     (long long)(esp_timer_get_time() / 1000000),
+                                     (unsigned long)esp_get_free_heap_size(),
+                                     (unsigned long)esp_get_minimum_free_heap_size(),
+                                     (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+    is_fitting = is_fitting && metrics_append_values(buffer, size, length, "counters", COUNTER_NAMES, counters, METRICS_COUNTER_COUNT);
+    is_fitting = is_fitting && metrics_append_values(buffer, size, length, "gauges", GAUGE_NAMES, gauges, METRICS_GAUGE_COUNT);
+    is_fitting = is_fitting && metrics_append_histograms(buffer, size, length);
+    is_fitting = is_fitting && metrics_append_tasks(buffer, size, length);
+    is_fitting = is_fitting && format_append(buffer, size, length, "}");
+
+    if (!is_fitting) {
+        buffer[0] = '\0';
+        *length   = 0;
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
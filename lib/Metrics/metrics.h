@@ -0,0 +1,113 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+/**
+ * @file metrics.h
+ * @brief Registry of runtime metrics: counters, gauges and latency histograms.
+ *
+ * Every metric is declared here at compile time and lives in a static array,
+ * so recording a value is a single relaxed atomic operation that never
+ * allocates, locks or blocks, and can be done from any task on the hot path.
+ * Tasks register themselves to have their stack watermark reported.
+ *
+ * `metrics_format_json()` takes a snapshot of the registry, together with the
+ * heap statistics, published by the MQTT task and served over HTTP:
+ *
+ *   {"uptime_s": 3600, "heap": {"free": 123456, "min_free": 98765, "largest_block": 65536},
+ *    "counters": {"samples_dropped": 0, ...}, "gauges": {"sample_ring_high_water": 3, ...},
+ *    "histograms": {"i2c_transaction_us": {"bounds": [100, ...], "counts": [12, ...], "max": 830}, ...},
+ *    "tasks": [{"name": "MQTT Task", "stack_free": 12000}, ...]}
+ *
+ * Histogram buckets count the values up to their bound, the last bucket
+ * counts every value above the previous bound.
+ */
+
+#define METRICS_HISTOGRAM_BUCKETS 8  ///< Number of buckets of every histogram.
+#define METRICS_MAX_TASKS 8          ///< Largest number of tasks reported.
+
+/**
+ * @brief Counters, only ever incremented.
+ */
+typedef enum metrics_counter_t {
+    METRICS_COUNTER_SAMPLES_DROPPED = 0,    ///< Samples dropped because the sample ring was full.
+    METRICS_COUNTER_SENSOR_READ_ERRORS,     ///< Sensor reads that failed.
+    METRICS_COUNTER_I2C_ERRORS,             ///< I2C transactions that failed.
+    METRICS_COUNTER_MQTT_ENQUEUED,          ///< Messages handed to the MQTT client.
+    METRICS_COUNTER_MQTT_PUBLISH_FAILURES,  ///< Messages refused by the MQTT client.
+    METRICS_COUNTER_MQTT_BACKPRESSURE,      ///< Publications deferred because the in-flight window or the outbox was full.
+    METRICS_COUNTER_STORE_FAILURES,         ///< Samples that could not be written to the offline store.
+    METRICS_COUNTER_LOG_OVERRUNS,           ///< Deferred log entries overwritten before they were printed.
+    METRICS_COUNTER_COUNT,                  ///< Number of counters.
+} metrics_counter_e;
+
+/**
+ * @brief Gauges, holding the last value set.
+ */
+typedef enum metrics_gauge_t {
+    METRICS_GAUGE_SAMPLE_RING_HIGH_WATER = 0,  ///< Highest number of samples pending in the sample ring.
+    METRICS_GAUGE_MQTT_OUTBOX_BYTES,           ///< Size of the MQTT outbox, in bytes.
+    METRICS_GAUGE_MQTT_IN_FLIGHT,              ///< MQTT messages awaiting their acknowledgment.
+    METRICS_GAUGE_COUNT,                       ///< Number of gauges.
+} metrics_gauge_e;
+
+/**
+ * @brief Histograms of durations.
+ */
+typedef enum metrics_histogram_t {
+    METRICS_HISTOGRAM_I2C_TRANSACTION_US = 0,  ///< Duration of an I2C transaction, in microseconds.
+    METRICS_HISTOGRAM_SAMPLE_LATENCY_MS,       ///< Time from the acquisition of a sample to its hand-over to the MQTT client, in milliseconds.
+    METRICS_HISTOGRAM_COUNT,                   ///< Number of histograms.
+} metrics_histogram_e;
+
+/**
+ * @brief Add a value to a counter.
+ *
+ * @param[in] counter Counter to increment.
+ * @param[in] value   Value to add.
+ */
+void metrics_counter_add(metrics_counter_e counter, uint32_t value);
+
+/**
+ * @brief Set the value of a gauge.
+ *
+ * @param[in] gauge Gauge to set.
+ * @param[in] value New value of the gauge.
+ */
+void metrics_gauge_set(metrics_gauge_e gauge, uint32_t value);
+
+/**
+ * @brief Record a value in a histogram.
+ *
+ * @param[in] histogram Histogram to record the value in.
+ * @param[in] value     Value to record, in the unit of the histogram.
+ */
+void metrics_histogram_record(metrics_histogram_e histogram, uint32_t value);
+
+/**
+ * @brief Register the calling task, so its stack watermark is reported.
+ *
+ * A task must not be deleted once registered.
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if `METRICS_MAX_TASKS` tasks are
+ *         already registered.
+ */
+esp_err_t metrics_register_task(void);
+
+/**
+ * @brief Format a snapshot of every metric as a JSON document.
+ *
+ * @param[out] buffer Buffer receiving the document, NUL-terminated.
+ * @param[in]  size   Size of the buffer, in bytes.
+ * @param[out] length Length of the document, in bytes.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid parameters or
+ *         ESP_ERR_NO_MEM if the document does not fit in the buffer.
+ */
+esp_err_t metrics_format_json(char *buffer, size_t size, size_t *length);
+
+#endif /* METRICS_H */
@@ -5,35 +5,88 @@
  * This file contains functions and configurations to manage Wi-Fi in both
  * Access Point (AP) and Station (STA) modes. It supports setting up an AP,
  * connecting to an external network as a STA, and handling network events.
+ *
+ * Wi-Fi runs in station mode only once the device is provisioned. The
+ * provisioning Access Point, with its network interface and DHCP server, is
+ * only brought up when no credentials are stored, on request with
+ * `network_start_provisioning()`, or after `PROVISIONING_FALLBACK_COUNT`
+ * consecutive failed attempts. It is taken down again
+ * `PROVISIONING_CLOSE_DELAY_MS` after the station connected, which leaves the
+ * provisioning page the time to report the outcome.
  */
 #include "network_task.h"
+#include "deferred_log.h"
 #include "events_definition.h"
+#include "metrics.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
 #include "esp_event.h"
 #include "esp_log.h"
+#include "esp_random.h"
 #include "esp_system.h"
 #include "esp_wifi.h"
 #include "lwip/err.h"
 #include "lwip/sockets.h"
 #include "lwip/sys.h"
+#include "nvs.h"
+
+#include <string.h>
+
+#define NETWORK_NOTIFY_CREDENTIALS BIT0   ///< New credentials were set.
+#define NETWORK_NOTIFY_DISCONNECTED BIT1  ///< An attempt failed or an established link was lost.
+#define NETWORK_NOTIFY_LINK_LOST BIT2     ///< The disconnection ended an established link.
+#define NETWORK_NOTIFY_GOT_IP BIT3        ///< The station got an IP address.
+#define NETWORK_NOTIFY_PROVISION BIT4     ///< The provisioning Access Point was requested.
+
+static const char *TAG                            = "Network Task";     ///< Tag for logging.
+static const char AP_SSID[]                       = "Titanium\0";       ///< Access Point SSID.
+static const char AP_PASSWORD[]                   = "root1234\0";       ///< Access Point password.
+static const uint8_t AP_CHANNEL                   = 1;                  ///< Access Point channel (1-14 depending on region).
+static const uint8_t AP_VISIBILITY                = 0;                  ///< Access Point visibility (0: hidden, 1: visible).
+static const uint8_t AP_MAX_CONNECTIONS           = 1;                  ///< Maximum number of connections to the Access Point.
+static const uint8_t AP_BEACON_INTERVAL           = 100;                ///< Beacon interval in milliseconds.
+static const char *AP_IP                          = "192.168.0.1";      ///< Access Point IP address.
+static const char *AP_GW                          = "192.168.0.1";      ///< Access Point gateway address.
+static const char *AP_NETMASK                     = "255.255.255.0";    ///< Access Point netmask.
+static const wifi_bandwidth_t AP_BW               = WIFI_BW_HT20;       ///< Access Point bandwidth configuration.
+static const wifi_ps_type_t AP_POWER_SAVE         = WIFI_PS_MIN_MODEM;  ///< Access Point power save mode.
+static const uint8_t FAILURE_REPORT_COUNT         = 3;                  ///< Consecutive failed attempts after which the connection is reported as failed.
+static const uint32_t ATTEMPT_TIMEOUT_MS          = 10000;              ///< Time after which an attempt without outcome is considered failed, in milliseconds.
+static const uint32_t BACKOFF_BASE_MS             = 1000;               ///< Backoff ceiling after the first failed attempt, in milliseconds.
+static const uint32_t BACKOFF_MAX_MS              = 60000;              ///< Largest backoff ceiling, in milliseconds.
+static const uint32_t LINK_LOSS_JITTER_MS         = 3000;               ///< Largest delay before reconnecting after losing an established link, in milliseconds.
+static const uint8_t PROVISIONING_FALLBACK_COUNT  = 5;                  ///< Consecutive failed attempts after which the provisioning Access Point is started.
+static const uint32_t PROVISIONING_CLOSE_DELAY_MS = 60000;              ///< Time the provisioning Access Point stays up once the station is connected, in milliseconds.
+static const uint32_t STATIC_IP_CHECK_TIMEOUT_MS  = 30000;              ///< Time the broker must be reached in after connecting with the cached IP configuration, in milliseconds.
+static const char *NVS_NAMESPACE                  = "network";          ///< NVS namespace of the network settings.
+static const char *NVS_KEY_FAST_CONNECT           = "fast_connect";     ///< NVS key of the fast-reconnect cache.
+static const char *NVS_KEY_SSID                   = "sta_ssid";         ///< NVS key of the station SSID.
+static const char *NVS_KEY_PASSWORD               = "sta_password";     ///< NVS key of the station password.
+static const char *NVS_KEY_IP_CACHE               = "ip_cache";         ///< NVS key of the last IP configuration.
+static const char *NVS_KEY_IP_MODE                = "ip_mode";          ///< NVS key of the IP configuration mode.
+
+/**
+ * @brief Access point of the last successful connection.
+ *
+ * Lets the first reconnection attempt target the known BSSID on the known
+ * channel, skipping the scan of every channel.
+ */
+typedef struct fast_connect_cache_s {
+    uint8_t ssid[32];  ///< SSID the access point was joined with.
+    uint8_t bssid[6];  ///< BSSID of the access point.
+    uint8_t channel;   ///< Primary channel of the access point, 0 if the cache is empty.
+} fast_connect_cache_st;
 
-static const char *TAG                      = "Network Task";     ///< Tag for logging.
-static const char AP_SSID[]                 = "Titanium\0";       ///< Access Point SSID.
-static const char AP_PASSWORD[]             = "root1234\0";       ///< Access Point password.
-static const uint8_t AP_CHANNEL             = 1;                  ///< Access Point channel (1-14 depending on region).
-static const uint8_t AP_VISIBILITY          = 0;                  ///< Access Point visibility (0: hidden, 1: visible).
-static const uint8_t AP_MAX_CONNECTIONS     = 1;                  ///< Maximum number of connections to the Access Point.
-static const uint8_t AP_BEACON_INTERVAL     = 100;                ///< Beacon interval in milliseconds.
-static const char *AP_IP                    = "192.168.0.1";      ///< Access Point IP address.
-static const char *AP_GW                    = "192.168.0.1";      ///< Access Point gateway address.
-static const char *AP_NETMASK               = "255.255.255.0";    ///< Access Point netmask.
-static const wifi_bandwidth_t AP_BW         = WIFI_BW_HT20;       ///< Access Point bandwidth configuration.
-static const wifi_ps_type_t AP_POWER_SAVE   = WIFI_PS_MIN_MODEM;  ///< Access Point power save mode.
-static const uint8_t MAX_RECONNECT_ATTEMPTS = 3;                  ///< Maximum number of reconnection attempts
-static const uint16_t RECONNECTION_DELAY_MS = 5000;               ///< Delay between reconnection attempts, in milliseconds
+/**
+ * @brief IP configuration of the last DHCP lease.
+ */
+typedef struct ip_cache_s {
+    uint8_t ssid[32];             ///< SSID of the network the lease was obtained on.
+    esp_netif_ip_info_t ip_info;  ///< Address, netmask and gateway.
+    esp_netif_dns_info_t dns;     ///< Main DNS server.
+} ip_cache_st;
 
 static network_status_st network_status = {
     .is_connect_ap  = false,  ///< Initial state: not connected to the Access Point.
@@ -41,13 +94,25 @@ static network_status_st network_status = {
 };
 
 // Global variables for connection handling
-static uint8_t connection_retry_counter = 0;      ///< Counter for tracking connection retries.
-static uint8_t is_retry_limit_exceeded  = 0;      ///< Flag to indicate that the limit was exceeded.
+static uint8_t connection_retry_counter = 0;      ///< Number of consecutive failed attempts.
 static bool is_credential_set           = false;  ///< Flag to indicate if credentials are set.
+static bool is_access_point_enabled     = true;   ///< Whether the provisioning Access Point may be started.
+static bool is_access_point_started     = false;  ///< Whether the provisioning Access Point is up.
 static esp_netif_t *esp_netif_sta       = {0};    ///< Pointer to the Station network interface.
 static esp_netif_t *esp_netif_ap        = {0};    ///< Pointer to the Access Point network interface.
 static wifi_config_t ap_config          = {0};    ///< Configuration structure for the Access Point.
 static wifi_config_t sta_config         = {0};    ///< Configuration structure for the Station.
+static TaskHandle_t network_task_handle = NULL;   ///< Handle of the network task, woken by events and new credentials.
+
+static fast_connect_cache_st fast_connect_cache = {0};                   ///< Access point of the last successful connection.
+static fast_connect_cache_st connected_ap       = {0};                   ///< Access point of the current association, set by the event handler.
+static ip_cache_st ip_cache                     = {0};                   ///< IP configuration of the last DHCP lease.
+static network_ip_mode_e ip_mode                = NETWORK_IP_MODE_DHCP;  ///< How the station obtains its IP configuration.
+static bool is_static_ip_used                   = false;                 ///< Whether the current attempt uses the cached IP configuration.
+static bool is_ip_cache_stale                   = false;                 ///< Whether the cached IP configuration stopped working, until the next lease.
+
+static network_sta_info_st sta_info    = {0};                           ///< Station connection reported to clients.
+static portMUX_TYPE sta_info_lock      = portMUX_INITIALIZER_UNLOCKED;  ///< Guards sta_info across tasks and cores.
 
 /**
  * @brief Event group for signaling system status and events.
@@ -60,6 +125,31 @@ static wifi_config_t sta_config         = {0};    ///< Configuration structure f
  */
 static EventGroupHandle_t *firmware_event_group = NULL;
 
+/**
+ * @brief Wakes the network task so it reacts to a change without waiting.
+ *
+ * @param[in] notification `NETWORK_NOTIFY_*` bits describing the change.
+ */
+static void network_notify_task(uint32_t notification) {
+    if (network_task_handle != NULL) {
+        xTaskNotify(network_task_handle, notification, eSetBits);
+    }
+}
+
+/**
+ * @brief Sets the station connection state and signals the change.
+ *
+ * @param[in] state New connection state.
+ */
+static void network_update_sta_state(network_sta_state_e state) {
+    taskENTER_CRITICAL(&sta_info_lock);
+    sta_info.state = state;
+    sta_info.version++;
+    taskEXIT_CRITICAL(&sta_info_lock);
+
+    xEventGroupSetBits(*firmware_event_group, NETWORK_STATUS_CHANGED);
+}
+
 /**
  * @brief Event handler for Wi-Fi-related events.
  *
@@ -88,12 +178,25 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
                 ESP_LOGI(TAG, "WIFI_EVENT_STA_START");
                 break;
             case WIFI_EVENT_STA_DISCONNECTED:
-                ESP_LOGI(TAG, "WIFI_EVENT_STA_DISCONNECTED");
+                wifi_event_sta_disconnected_t *disconnected = (wifi_event_sta_disconnected_t *)event_data;
+                DEFERRED_LOGI(TAG, "WIFI_EVENT_STA_DISCONNECTED, reason %u", disconnected->reason);
+                bool was_connected = network_status.is_connect_sta;
                 xEventGroupClearBits(*firmware_event_group, WIFI_CONNECTED_STA);
                 network_status.is_connect_sta = false;
+
+                taskENTER_CRITICAL(&sta_info_lock);
+                sta_info.disconnect_reason = disconnected->reason;
+                sta_info.ip[0]             = '\0';
+                taskEXIT_CRITICAL(&sta_info_lock);
+                network_notify_task(NETWORK_NOTIFY_DISCONNECTED | (was_connected ? NETWORK_NOTIFY_LINK_LOST : 0));
                 break;
             case WIFI_EVENT_STA_CONNECTED:
-                ESP_LOGI(TAG, "WIFI_EVENT_STA_CONNECTED");
+                wifi_event_sta_connected_t *connected = (wifi_event_sta_connected_t *)event_data;
+                ESP_LOGI(TAG, "WIFI_EVENT_STA_CONNECTED, channel %u", connected->channel);
+
+                memcpy(connected_ap.ssid, connected->ssid, sizeof(connected_ap.ssid));
+                memcpy(connected_ap.bssid, connected->bssid, sizeof(connected_ap.bssid));
+                connected_ap.channel = connected->channel;
                 break;
         }
     } else if (event_base == IP_EVENT) {
@@ -104,6 +207,13 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
 
                 xEventGroupSetBits(*firmware_event_group, WIFI_CONNECTED_STA);
                 network_status.is_connect_sta = true;
+
+                taskENTER_CRITICAL(&sta_info_lock);
+                esp_ip4addr_ntoa(&event->ip_info.ip, sta_info.ip, sizeof(sta_info.ip));
+                sta_info.disconnect_reason = 0;
+                taskEXIT_CRITICAL(&sta_info_lock);
+                network_update_sta_state(NETWORK_STA_CONNECTED);
+                network_notify_task(NETWORK_NOTIFY_GOT_IP);
                 break;
         }
     }
@@ -122,6 +232,260 @@ static void set_station_mode(void) {
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &sta_config));
 }
 
+/**
+ * @brief Reads a fixed-size blob from the network namespace.
+ *
+ * @param[in]  key    NVS key of the blob.
+ * @param[out] blob   Buffer receiving the blob, cleared if the entry is missing or malformed.
+ * @param[in]  length Expected size of the blob, in bytes.
+ *
+ * @return true if the blob was read.
+ */
+static bool network_nvs_get_blob(const char *key, void *blob, size_t length) {
+    nvs_handle_t handle = 0;
+    size_t stored       = length;
+    bool is_found       = false;
+
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+        is_found = (nvs_get_blob(handle, key, blob, &stored) == ESP_OK) && (stored == length);
+        nvs_close(handle);
+    }
+
+    if (!is_found) {
+        memset(blob, 0, length);
+    }
+
+    return is_found;
+}
+
+/**
+ * @brief Writes a blob to the network namespace.
+ *
+ * @param[in] key    NVS key of the blob.
+ * @param[in] blob   Blob to write.
+ * @param[in] length Size of the blob, in bytes.
+ *
+ * @return ESP_OK on success, or an NVS error code.
+ */
+static esp_err_t network_nvs_set_blob(const char *key, const void *blob, size_t length) {
+    nvs_handle_t handle = 0;
+
+    esp_err_t result = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (result == ESP_OK) {
+        result = nvs_set_blob(handle, key, blob, length);
+        if (result == ESP_OK) {
+            result = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+
+    if (result != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to persist %s: %s", key, esp_err_to_name(result));
+    }
+
+    return result;
+}
+
+/**
+ * @brief Loads the persisted credentials and network caches from NVS.
+ *
+ * With stored credentials, the station is configured right away so the
+ * first attempt starts as soon as the task runs, without provisioning.
+ */
+static void network_load_settings(void) {
+    nvs_handle_t handle  = 0;
+    size_t ssid_len      = sizeof(sta_config.sta.ssid) + 1;
+    size_t password_len  = sizeof(sta_config.sta.password) + 1;
+    char ssid[33]        = {0};
+    char password[65]    = {0};
+    bool has_credentials = false;
+
+    network_nvs_get_blob(NVS_KEY_FAST_CONNECT, &fast_connect_cache, sizeof(fast_connect_cache));
+    network_nvs_get_blob(NVS_KEY_IP_CACHE, &ip_cache, sizeof(ip_cache));
+    ip_mode = network_get_ip_mode();
+
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return;
+    }
+
+    has_credentials = (nvs_get_str(handle, NVS_KEY_SSID, ssid, &ssid_len) == ESP_OK) &&
+                      (nvs_get_str(handle, NVS_KEY_PASSWORD, password, &password_len) == ESP_OK);
+    nvs_close(handle);
+
+    if (has_credentials) {
+        ESP_LOGI(TAG, "Using the stored credentials for %s", ssid);
+        memcpy(sta_config.sta.ssid, ssid, sizeof(sta_config.sta.ssid));
+        memcpy(sta_config.sta.password, password, sizeof(sta_config.sta.password));
+        is_credential_set = true;
+        set_station_mode();
+
+        taskENTER_CRITICAL(&sta_info_lock);
+        snprintf(sta_info.ssid, sizeof(sta_info.ssid), "%.*s", (int)sizeof(sta_config.sta.ssid), (char *)sta_config.sta.ssid);
+        taskEXIT_CRITICAL(&sta_info_lock);
+        network_update_sta_state(NETWORK_STA_CONNECTING);
+    }
+
+    memset(password, 0, sizeof(password));
+}
+
+/**
+ * @brief Persists the station credentials.
+ *
+ * @return ESP_OK on success, or an NVS error code.
+ */
+static esp_err_t network_save_credentials(void) {
+    nvs_handle_t handle = 0;
+    char ssid[33]       = {0};
+    char password[65]   = {0};
+
+#if !CONFIG_NVS_ENCRYPTION
+    ESP_LOGW(TAG, "NVS encryption is disabled, the Wi-Fi password is stored in plain text");
+#endif
+
+    memcpy(ssid, sta_config.sta.ssid, sizeof(sta_config.sta.ssid));
+    memcpy(password, sta_config.sta.password, sizeof(sta_config.sta.password));
+
+    esp_err_t result = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (result == ESP_OK) {
+        result += nvs_set_str(handle, NVS_KEY_SSID, ssid);
+        result += nvs_set_str(handle, NVS_KEY_PASSWORD, password);
+        if (result == ESP_OK) {
+            result = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    memset(password, 0, sizeof(password));
+
+    if (result != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to persist the credentials: %s", esp_err_to_name(result));
+    }
+
+    return result;
+}
+
+/**
+ * @brief Caches the IP configuration of the current DHCP lease.
+ *
+ * Runs in both modes, so `NETWORK_IP_MODE_STATIC_CACHED` gets its first
+ * lease, and a new one after falling back to DHCP. NVS is only written when
+ * the configuration changed.
+ */
+static void network_save_ip_cache(void) {
+    ip_cache_st current = {0};
+
+    if (is_static_ip_used) {
+        return;
+    }
+    is_ip_cache_stale = false;
+
+    memcpy(current.ssid, sta_config.sta.ssid, sizeof(current.ssid));
+    if ((esp_netif_get_ip_info(esp_netif_sta, &current.ip_info) != ESP_OK) ||
+        (esp_netif_get_dns_info(esp_netif_sta, ESP_NETIF_DNS_MAIN, &current.dns) != ESP_OK) ||
+        (memcmp(&current, &ip_cache, sizeof(current)) == 0)) {
+        return;
+    }
+
+    ip_cache = current;
+    network_nvs_set_blob(NVS_KEY_IP_CACHE, &ip_cache, sizeof(ip_cache));
+}
+
+/**
+ * @brief Applies the IP configuration mode before a connection attempt.
+ *
+ * The cached configuration is only used for the network it was leased on,
+ * on the first attempt after a success, and while it has not been found
+ * stale; DHCP is used otherwise.
+ */
+static void network_apply_ip_mode(void) {
+    bool is_static = (ip_mode == NETWORK_IP_MODE_STATIC_CACHED) && !is_ip_cache_stale &&
+                     (connection_retry_counter == 0) && (ip_cache.ip_info.ip.addr != 0) &&
+                     (memcmp(ip_cache.ssid, sta_config.sta.ssid, sizeof(ip_cache.ssid)) == 0);
+
+    is_static_ip_used = is_static;
+    if (is_static) {
+        esp_netif_dhcpc_stop(esp_netif_sta);
+        ESP_ERROR_CHECK_WITHOUT_ABORT(esp_netif_set_ip_info(esp_netif_sta, &ip_cache.ip_info));
+        ESP_ERROR_CHECK_WITHOUT_ABORT(esp_netif_set_dns_info(esp_netif_sta, ESP_NETIF_DNS_MAIN, &ip_cache.dns));
+    } else {
+        // Fails harmlessly when the client is already running.
+        esp_netif_dhcpc_start(esp_netif_sta);
+    }
+}
+
+/**
+ * @brief Caches the access point of the current connection.
+ *
+ * NVS is only written when the access point or its channel changed, so a
+ * stable network does not wear the flash.
+ */
+static void network_save_fast_connect(void) {
+    if ((connected_ap.channel == 0) || (memcmp(&connected_ap, &fast_connect_cache, sizeof(connected_ap)) == 0)) {
+        return;
+    }
+
+    fast_connect_cache = connected_ap;
+    network_nvs_set_blob(NVS_KEY_FAST_CONNECT, &fast_connect_cache, sizeof(fast_connect_cache));
+}
+
+/**
+ * @brief Computes the delay before the next attempt after consecutive failures.
+ *
+ * The ceiling doubles with each failure up to `BACKOFF_MAX_MS`. The delay is
+ * drawn between half the ceiling and the ceiling, so retries slow down while
+ * devices that failed together spread out instead of retrying in lockstep.
+ *
+ * @param[in] failures Number of consecutive failed attempts, at least 1.
+ *
+ * @return Delay before the next attempt, in milliseconds.
+ */
+static uint32_t network_backoff_delay_ms(uint8_t failures) {
+    uint32_t ceiling = BACKOFF_MAX_MS;
+
+    if ((failures < 16) && ((BACKOFF_BASE_MS << (failures - 1)) < BACKOFF_MAX_MS)) {
+        ceiling = BACKOFF_BASE_MS << (failures - 1);
+    }
+
+    return (ceiling / 2) + (esp_random() % ((ceiling / 2) + 1));
+}
+
+/**
+ * @brief Starts a connection attempt with the current credentials.
+ *
+ * The first attempt after a success, or after new credentials for the same
+ * network, targets the cached access point on its channel. Later attempts
+ * scan every channel and pick the strongest access point.
+ *
+ * @return ESP_OK if the attempt started, or an error code on failure.
+ */
+static esp_err_t network_start_attempt(void) {
+    bool is_fast = (connection_retry_counter == 0) && (fast_connect_cache.channel != 0) &&
+                   (memcmp(fast_connect_cache.ssid, sta_config.sta.ssid, sizeof(fast_connect_cache.ssid)) == 0);
+
+    sta_config.sta.bssid_set   = is_fast;
+    sta_config.sta.channel     = is_fast ? fast_connect_cache.channel : 0;
+    sta_config.sta.scan_method = is_fast ? WIFI_FAST_SCAN : WIFI_ALL_CHANNEL_SCAN;
+    sta_config.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+    memcpy(sta_config.sta.bssid, fast_connect_cache.bssid, sizeof(sta_config.sta.bssid));
+
+    ESP_LOGI(TAG, "Connecting to the STA (attempt %u, %s)...", connection_retry_counter + 1,
+             is_fast ? "cached access point" : "full scan");
+
+    network_apply_ip_mode();
+
+    esp_err_t result = esp_wifi_set_config(WIFI_IF_STA, &sta_config);
+    if (result == ESP_OK) {
+        result = esp_wifi_connect();
+    }
+
+    taskENTER_CRITICAL(&sta_info_lock);
+    if (sta_info.attempt < UINT8_MAX) {
+        sta_info.attempt++;
+    }
+    taskEXIT_CRITICAL(&sta_info_lock);
+
+    return result;
+}
+
 /**
  * @brief Configure and initialize Access Point (AP) mode.
  *
@@ -170,10 +534,59 @@ static esp_err_t set_access_point_mode(void) {
     return result;
 }
 
+/**
+ * @brief Bring up the provisioning Access Point alongside the station.
+ *
+ * The Access Point network interface is created the first time only. Does
+ * nothing if the Access Point is already up or was disabled with
+ * `network_set_access_point_enabled()`.
+ *
+ * @return ESP_OK on success, or an error code on failure.
+ */
+static esp_err_t network_start_access_point(void) {
+    esp_err_t result = ESP_OK;
+
+    if (is_access_point_started || !is_access_point_enabled) {
+        return ESP_OK;
+    }
+
+    if (esp_netif_ap == NULL) {
+        esp_netif_ap = esp_netif_create_default_wifi_ap();
+    }
+
+    result += esp_wifi_set_mode(WIFI_MODE_APSTA);
+    ESP_ERROR_CHECK_WITHOUT_ABORT(result);
+    result += set_access_point_mode();
+
+    if (result == ESP_OK) {
+        is_access_point_started = true;
+        ESP_LOGI(TAG, "Provisioning Access Point started");
+    }
+
+    return result;
+}
+
+/**
+ * @brief Take the provisioning Access Point down, leaving the station alone.
+ */
+static void network_stop_access_point(void) {
+    if (!is_access_point_started) {
+        return;
+    }
+
+    ESP_ERROR_CHECK_WITHOUT_ABORT(esp_wifi_set_mode(WIFI_MODE_STA));
+    xEventGroupClearBits(*firmware_event_group, WIFI_CONNECTED_AP);
+    network_status.is_connect_ap = false;
+    is_access_point_started      = false;
+    ESP_LOGI(TAG, "Provisioning Access Point stopped");
+}
+
 /**
  * @brief Initialize Wi-Fi system and network interfaces.
  *
- * Sets up Wi-Fi in AP and STA modes, configures event handlers, and starts the Wi-Fi driver.
+ * Sets up Wi-Fi in STA mode, configures event handlers, and starts the Wi-Fi
+ * driver. The provisioning Access Point is started as well when no
+ * credentials are stored.
  *
  * @return ESP_OK on success, or an error code on failure.
  */
@@ -204,23 +617,73 @@ static esp_err_t network_task_initialize(void) {
                                                   &instance_got_ip);
     ESP_ERROR_CHECK_WITHOUT_ABORT(result);
     esp_netif_sta = esp_netif_create_default_wifi_sta();
-    esp_netif_ap  = esp_netif_create_default_wifi_ap();
 
-    result += esp_wifi_set_mode(WIFI_MODE_APSTA);
+    result += esp_wifi_set_mode(WIFI_MODE_STA);
     ESP_ERROR_CHECK_WITHOUT_ABORT(result);
 
-    set_access_point_mode();
+    network_load_settings();
     result += esp_wifi_start();
     ESP_ERROR_CHECK_WITHOUT_ABORT(result);
 
+    if (!is_credential_set) {
+        ESP_LOGI(TAG, "No stored credentials");
+        network_start_access_point();
+    }
+
     return result;
 }
 
+/**
+ * @brief Check whether station credentials are stored in NVS.
+ *
+ * Can be called before the network task is started.
+ *
+ * @return true if both the SSID and the password are stored.
+ */
+bool network_has_stored_credentials(void) {
+    nvs_handle_t handle = 0;
+    size_t ssid_len     = 0;
+    size_t password_len = 0;
+    bool is_stored      = false;
+
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+        is_stored = (nvs_get_str(handle, NVS_KEY_SSID, NULL, &ssid_len) == ESP_OK) &&
+                    (nvs_get_str(handle, NVS_KEY_PASSWORD, NULL, &password_len) == ESP_OK);
+        nvs_close(handle);
+    }
+
+    return is_stored;
+}
+
+/**
+ * @brief Enable or disable the provisioning Access Point.
+ *
+ * Must be called before the network task is started. Without the Access
+ * Point, Wi-Fi runs in station mode only and the stored credentials are the
+ * only way to join a network.
+ *
+ * @param[in] enabled true to let the Access Point be started when needed.
+ */
+void network_set_access_point_enabled(bool enabled) {
+    is_access_point_enabled = enabled;
+}
+
+/**
+ * @brief Bring up the provisioning Access Point, e.g. on a button press.
+ *
+ * The Access Point is started by the network task and taken down again once
+ * the station is connected. Safe to call from any task, not from an ISR.
+ */
+void network_start_provisioning(void) {
+    network_notify_task(NETWORK_NOTIFY_PROVISION);
+}
+
 /**
  * @brief Set Wi-Fi credentials for connecting to a station.
  *
  * This function stores the provided SSID and password for connecting the ESP32
- * to a Wi-Fi network in station mode.
+ * to a Wi-Fi network in station mode, and wakes the network task so the
+ * first connection attempt starts immediately.
  *
  * @param[in] ssid     Pointer to the SSID string.
  * @param[in] password Pointer to the password string.
@@ -248,15 +711,112 @@ esp_err_t network_set_credentials(const char *ssid, const char *password) {
     }
 
     if (result == ESP_OK) {
-        is_credential_set        = true;
-        is_retry_limit_exceeded  = false;
-        connection_retry_counter = 0;
+        is_credential_set = true;
         set_station_mode();
+        network_save_credentials();
+
+        taskENTER_CRITICAL(&sta_info_lock);
+        snprintf(sta_info.ssid, sizeof(sta_info.ssid), "%.*s", (int)sizeof(sta_config.sta.ssid), (char *)sta_config.sta.ssid);
+        sta_info.attempt           = 0;
+        sta_info.disconnect_reason = 0;
+        taskEXIT_CRITICAL(&sta_info_lock);
+        network_update_sta_state(NETWORK_STA_CONNECTING);
+
+        // Drop the current network, if any, so the new credentials are used right away.
+        if (network_status.is_connect_sta) {
+            ESP_ERROR_CHECK_WITHOUT_ABORT(esp_wifi_disconnect());
+        }
+        network_notify_task(NETWORK_NOTIFY_CREDENTIALS);
     }
 
     return result;
 }
 
+/**
+ * @brief Get how the station obtains its IP configuration.
+ *
+ * Reads the mode persisted in NVS, so it can be called before the network
+ * task is started.
+ *
+ * @return IP configuration mode, `NETWORK_IP_MODE_DHCP` if none is stored.
+ */
+network_ip_mode_e network_get_ip_mode(void) {
+    nvs_handle_t handle = 0;
+    uint8_t stored_mode = NETWORK_IP_MODE_DHCP;
+
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+        nvs_get_u8(handle, NVS_KEY_IP_MODE, &stored_mode);
+        nvs_close(handle);
+    }
+
+    return (stored_mode == NETWORK_IP_MODE_STATIC_CACHED) ? NETWORK_IP_MODE_STATIC_CACHED : NETWORK_IP_MODE_DHCP;
+}
+
+/**
+ * @brief Set how the station obtains its IP configuration.
+ *
+ * The mode is persisted in NVS and applies from the next connection attempt.
+ * With `NETWORK_IP_MODE_STATIC_CACHED`, DHCP is only used until a first lease
+ * has been obtained on the current network; the network administrator must
+ * then keep that address reserved for the device. When the broker cannot be
+ * reached within `STATIC_IP_CHECK_TIMEOUT_MS` with the cached configuration,
+ * the station reconnects with DHCP and caches the new lease.
+ *
+ * @param[in] mode IP configuration mode.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on an unknown mode, or an NVS error code.
+ */
+esp_err_t network_set_ip_mode(network_ip_mode_e mode) {
+    nvs_handle_t handle = 0;
+
+    if ((mode != NETWORK_IP_MODE_DHCP) && (mode != NETWORK_IP_MODE_STATIC_CACHED)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t result = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (result == ESP_OK) {
+        result = nvs_set_u8(handle, NVS_KEY_IP_MODE, (uint8_t)mode);
+        if (result == ESP_OK) {
+            result = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+
+    if (result == ESP_OK) {
+        ip_mode = mode;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Get a snapshot of the station connection.
+ *
+ * Every change is also signaled with `NETWORK_STATUS_CHANGED`.
+ *
+ * @param[out] info Snapshot of the station connection.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if info is NULL.
+ */
+esp_err_t network_get_sta_info(network_sta_info_st *info) {
+    wifi_ap_record_t ap_info = {0};
+
+    if (info == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    taskENTER_CRITICAL(&sta_info_lock);
+    *info = sta_info;
+    taskEXIT_CRITICAL(&sta_info_lock);
+
+    info->rssi = 0;
+    if ((info->state == NETWORK_STA_CONNECTED) && (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK)) {
+        info->rssi = ap_info.rssi;
+    }
+
+    return ESP_OK;
+}
+
 /**
  * @brief Main execution function for network management.
  *
@@ -264,50 +824,145 @@ esp_err_t network_set_credentials(const char *ssid, const char *password) {
  * continuously monitors the connection status, attempting to reconnect
  * if credentials are set but the device is disconnected.
  *
+ * The task sleeps on its notification: new credentials, disconnections and
+ * IP acquisition wake it up. Credentials stored in NVS and new credentials
+ * are tried immediately. Failed
+ * attempts are retried forever with an exponential backoff with jitter, and
+ * an established link that drops is retried after a short random delay, so
+ * a fleet losing the same access point reconnects quickly but staggered.
+ * The task also starts and stops the provisioning Access Point.
+ *
  * @param[in] pvParameters Pointer to task parameters (TaskHandle_t).
  */
 void network_task_execute(void *pvParameters) {
     firmware_event_group = (EventGroupHandle_t *)pvParameters;
-    if ((network_task_initialize() != ESP_OK) || (firmware_event_group == NULL)) {
+    network_task_handle  = xTaskGetCurrentTaskHandle();
+    if ((firmware_event_group == NULL) || (network_task_initialize() != ESP_OK)) {
         vTaskDelete(NULL);
     }
 
+    metrics_register_task();
+
+    TickType_t next_attempt_time  = xTaskGetTickCount();
+    TickType_t attempt_start_time = 0;
+    bool is_attempt_pending       = false;
+    bool is_link_drop_expected    = false;
+    bool is_ap_close_pending      = false;
+    TickType_t ap_close_time      = 0;
+    bool is_ip_check_pending      = false;
+    TickType_t ip_check_time      = 0;
+    uint32_t notifications        = 0;
+
     while (1) {
+        TickType_t now        = xTaskGetTickCount();
+        TickType_t wait_ticks = portMAX_DELAY;
+
+        if (notifications & NETWORK_NOTIFY_CREDENTIALS) {
+            // Someone is waiting on the provisioning page, do not make them wait.
+            connection_retry_counter = 0;
+            is_attempt_pending       = false;
+            is_link_drop_expected    = network_status.is_connect_sta;
+            next_attempt_time        = now;
+        } else if (notifications & NETWORK_NOTIFY_GOT_IP) {
+            connection_retry_counter = 0;
+            is_attempt_pending       = false;
+            is_ip_check_pending      = is_static_ip_used;
+            ip_check_time            = now + pdMS_TO_TICKS(STATIC_IP_CHECK_TIMEOUT_MS);
+            network_save_fast_connect();
+            network_save_ip_cache();
+        } else if ((notifications & NETWORK_NOTIFY_LINK_LOST) && !is_attempt_pending) {
+            // Dropping the link for new credentials is not an outage, connect right away.
+            if (!is_link_drop_expected) {
+                DEFERRED_LOGW(TAG, "Connection lost, reconnecting");
+                next_attempt_time = now + pdMS_TO_TICKS(esp_random() % (LINK_LOSS_JITTER_MS + 1));
+            }
+            is_link_drop_expected = false;
+            network_update_sta_state(NETWORK_STA_CONNECTING);
+        } else if (is_attempt_pending && ((notifications & NETWORK_NOTIFY_DISCONNECTED) ||
+                                          ((now - attempt_start_time) >= pdMS_TO_TICKS(ATTEMPT_TIMEOUT_MS)))) {
+            if (connection_retry_counter < UINT8_MAX) {
+                connection_retry_counter++;
+            }
+            is_attempt_pending = false;
+
+            uint32_t delay_ms = network_backoff_delay_ms(connection_retry_counter);
+            next_attempt_time = now + pdMS_TO_TICKS(delay_ms);
+            DEFERRED_LOGW(TAG, "Attempt failed, retrying in %lu ms", (unsigned long)delay_ms);
+            network_update_sta_state((connection_retry_counter >= FAILURE_REPORT_COUNT) ? NETWORK_STA_FAILED
+                                                                                       : NETWORK_STA_CONNECTING);
+            if (connection_retry_counter == PROVISIONING_FALLBACK_COUNT) {
+                ESP_LOGW(TAG, "Still not connected, falling back to provisioning");
+                network_start_access_point();
+            }
+        }
+
+        // A cached address that was reassigned, or a moved gateway, still "connects" but reaches nothing.
+        // The broker connection is only checked when the task wakes up, at the latest at the deadline.
+        if (!network_status.is_connect_sta) {
+            is_ip_check_pending = false;
+        } else if (is_ip_check_pending && ((xEventGroupGetBits(*firmware_event_group) & MQTT_CONNECTED) != 0)) {
+            is_ip_check_pending = false;
+        } else if (is_ip_check_pending && ((int32_t)(ip_check_time - now) <= 0)) {
+            DEFERRED_LOGW(TAG, "Cached IP configuration unreachable, falling back to DHCP");
+            is_ip_check_pending   = false;
+            is_ip_cache_stale     = true;
+            is_link_drop_expected = true;
+            ESP_ERROR_CHECK_WITHOUT_ABORT(esp_wifi_disconnect());
+        }
+
+        if (notifications & NETWORK_NOTIFY_PROVISION) {
+            network_start_access_point();
+            is_ap_close_pending = false;
+        }
+
+        // Keep the Access Point while the station is not connected, close it some time after.
+        if (!is_access_point_started || !network_status.is_connect_sta) {
+            is_ap_close_pending = false;
+        } else if (!is_ap_close_pending) {
+            is_ap_close_pending = true;
+            ap_close_time       = now + pdMS_TO_TICKS(PROVISIONING_CLOSE_DELAY_MS);
+        } else if ((int32_t)(ap_close_time - now) <= 0) {
+            network_stop_access_point();
+            is_ap_close_pending = false;
+        }
+
         do {
             if (network_status.is_connect_sta) {
                 // Network Already Connect
-                connection_retry_counter = 0;
-                break;
-            }
-            if (is_retry_limit_exceeded) {
-                // The retry limit was exceeded
                 break;
             }
             if (!is_credential_set) {
                 // No credential was passed trough the webserver
                 break;
             }
+            if (is_attempt_pending) {
+                wait_ticks = pdMS_TO_TICKS(ATTEMPT_TIMEOUT_MS) - (now - attempt_start_time);
+                break;
+            }
+            if ((int32_t)(next_attempt_time - now) > 0) {
+                wait_ticks = next_attempt_time - now;
+                break;
+            }
 
-            if (connection_retry_counter < MAX_RECONNECT_ATTEMPTS) {
-                ESP_LOGI(TAG, "Reconnecting to the STA (Attempt %d of %d)...",
-                         connection_retry_counter + 1,
-                         MAX_RECONNECT_ATTEMPTS);
-
-                esp_err_t err = ESP_ERROR_CHECK_WITHOUT_ABORT(esp_wifi_connect());
-                if (err == ESP_OK) {
-                    ESP_LOGI(TAG, "Connection attempt initiated.");
-                    connection_retry_counter++;
-                } else {
-                    ESP_LOGE(TAG, "Reconnect attempt failed: %s", esp_err_to_name(err));
-                }
-
-                vTaskDelay(pdMS_TO_TICKS(RECONNECTION_DELAY_MS));
-            } else {
-                ESP_LOGE(TAG, "Max reconnect attempts reached. Stopping further attempts.");
-                is_retry_limit_exceeded = true;
+            esp_err_t err = network_start_attempt();
+            if (err != ESP_OK) {
+                DEFERRED_LOGE(TAG, "Reconnect attempt failed: %s", esp_err_to_name(err));
             }
+
+            // A failure to start is handled as a failed attempt on timeout.
+            is_attempt_pending = true;
+            attempt_start_time = now;
+            wait_ticks         = pdMS_TO_TICKS(ATTEMPT_TIMEOUT_MS);
         } while (0);
 
-        vTaskDelay(pdMS_TO_TICKS(1000));
+        if (is_ap_close_pending && ((ap_close_time - now) < wait_ticks)) {
+            wait_ticks = ap_close_time - now;
+        }
+        if (is_ip_check_pending && ((ip_check_time - now) < wait_ticks)) {
+            wait_ticks = ip_check_time - now;
+        }
+
+        notifications = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &notifications, wait_ticks);
     }
 }
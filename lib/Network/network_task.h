@@ -2,6 +2,7 @@
 #define NETWORK_TASK_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "esp_err.h"
 
 /**
@@ -17,11 +18,72 @@ typedef struct network_status_s {
     bool is_connect_sta;  ///< Indicates if the device is connected to a Station.
 } network_status_st;
 
+/**
+ * @brief Connection state of the station interface.
+ */
+typedef enum network_sta_state_t {
+    NETWORK_STA_IDLE = 0,    ///< No credentials were provided yet.
+    NETWORK_STA_CONNECTING,  ///< Connecting, or waiting to retry, with the current credentials.
+    NETWORK_STA_CONNECTED,   ///< Connected and holding an IP address.
+    NETWORK_STA_FAILED,      ///< Several consecutive attempts failed, still retrying with a backoff.
+} network_sta_state_e;
+
+/**
+ * @brief Snapshot of the station connection, for reporting progress.
+ */
+typedef struct network_sta_info_s {
+    network_sta_state_e state;  ///< Connection state.
+    uint32_t version;           ///< Incremented on every change, lets a client wait for the next one.
+    uint8_t attempt;            ///< Connection attempts made since the credentials were set.
+    uint8_t disconnect_reason;  ///< Reason code of the last disconnection (`wifi_err_reason_t`), 0 if none.
+    int8_t rssi;                ///< Signal strength of the access point in dBm, 0 when not connected.
+    char ssid[33];              ///< SSID of the network, NUL-terminated.
+    char ip[16];                ///< IP address in dotted notation, empty when not connected.
+} network_sta_info_st;
+
+/**
+ * @brief How the station obtains its IP configuration.
+ */
+typedef enum network_ip_mode_t {
+    NETWORK_IP_MODE_DHCP = 0,       ///< Lease an address with DHCP on every connection.
+    NETWORK_IP_MODE_STATIC_CACHED,  ///< Reuse the last leased configuration as a static one, skipping DHCP.
+} network_ip_mode_e;
+
+/**
+ * @brief Check whether station credentials are stored in NVS.
+ *
+ * Can be called before the network task is started.
+ *
+ * @return true if both the SSID and the password are stored.
+ */
+bool network_has_stored_credentials(void);
+
+/**
+ * @brief Enable or disable the provisioning Access Point.
+ *
+ * Must be called before the network task is started. Without the Access
+ * Point, Wi-Fi runs in station mode only and the stored credentials are the
+ * only way to join a network.
+ *
+ * @param[in] enabled true to let the Access Point be started when needed.
+ */
+void network_set_access_point_enabled(bool enabled);
+
+/**
+ * @brief Bring up the provisioning Access Point, e.g. on a button press.
+ *
+ * The Access Point is started by the network task and taken down again once
+ * the station is connected. Safe to call from any task, not from an ISR.
+ */
+void network_start_provisioning(void);
+
 /**
  * @brief Set Wi-Fi credentials for connecting to a station.
  *
  * This function stores the provided SSID and password for connecting the ESP32
- * to a Wi-Fi network in station mode.
+ * to a Wi-Fi network in station mode, and wakes the network task so the
+ * first connection attempt starts immediately. The credentials are persisted
+ * in NVS and used again after a reboot.
  *
  * @param[in] ssid     Pointer to the SSID string.
  * @param[in] password Pointer to the password string.
@@ -30,6 +92,43 @@ typedef struct network_status_s {
  */
 esp_err_t network_set_credentials(const char *ssid, const char *password);
 
+/**
+ * @brief Get how the station obtains its IP configuration.
+ *
+ * Reads the mode persisted in NVS, so it can be called before the network
+ * task is started.
+ *
+ * @return IP configuration mode, `NETWORK_IP_MODE_DHCP` if none is stored.
+ */
+network_ip_mode_e network_get_ip_mode(void);
+
+/**
+ * @brief Set how the station obtains its IP configuration.
+ *
+ * The mode is persisted in NVS and applies from the next connection attempt.
+ * With `NETWORK_IP_MODE_STATIC_CACHED`, DHCP is only used until a first lease
+ * has been obtained on the current network; the network administrator must
+ * then keep that address reserved for the device. When the broker cannot be
+ * reached shortly after connecting with the cached configuration, the
+ * station reconnects with DHCP and caches the new lease.
+ *
+ * @param[in] mode IP configuration mode.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on an unknown mode, or an NVS error code.
+ */
+esp_err_t network_set_ip_mode(network_ip_mode_e mode);
+
+/**
+ * @brief Get a snapshot of the station connection.
+ *
+ * Every change is also signaled with `NETWORK_STATUS_CHANGED`.
+ *
+ * @param[out] info Snapshot of the station connection.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if info is NULL.
+ */
+esp_err_t network_get_sta_info(network_sta_info_st *info);
+
 /**
  * @brief Main execution function for network management.
  *
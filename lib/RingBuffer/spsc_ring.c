@@ -0,0 +1,156 @@
+/**
+ * @file spsc_ring.c
+ * @brief Implementation of the lock-free single-producer/single-consumer ring.
+ */
+
+#include "spsc_ring.h"
+
+#include <string.h>
+
+/**
+ * @brief Copy one element into the ring. Producer only.
+ *
+ * @param[in,out] ring    Ring to push to.
+ * @param[in]     element Element to copy, `element_size` bytes.
+ *
+ * @return true on success, false if the ring is full.
+ */
+bool spsc_ring_push(spsc_ring_st *ring, const void *element) {
+    if ((ring == NULL) || (element == NULL)) {
+        return false;
+    }
+
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if ((head - tail) >= ring->capacity) {
+        return false;
+    }
+
+    memcpy(&ring->storage[(head & (ring->capacity - 1)) * ring->element_size], element, ring->element_size);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    size_t pending = head + 1 - tail;
+    if (pending > atomic_load_explicit(&ring->high_water_mark, memory_order_relaxed)) {
+        atomic_store_explicit(&ring->high_water_mark, pending, memory_order_relaxed);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Get the contiguous span of pending elements at the tail. Consumer only.
+ *
+ * The span may be shorter than the number of pending elements when they wrap
+ * around the end of the storage; the rest is returned once the span is
+ * consumed.
+ *
+ * @param[in,out] ring      Ring to read from.
+ * @param[out]    elements  Set to the first pending element, or NULL if the ring is empty.
+ * @param[in]     max_count Largest number of elements wanted.
+ *
+ * @return Number of elements in the span.
+ */
+size_t spsc_ring_peek(spsc_ring_st *ring, const void **elements, size_t max_count) {
+    return spsc_ring_peek_at(ring, 0, elements, max_count);
+}
+
+/**
+ * @brief Get a contiguous span of pending elements, past the first `offset` ones. Consumer only.
+ *
+ * Like `spsc_ring_peek()`, but the span starts `offset` elements after the
+ * tail, which gives access to the elements after a wrap-around without
+ * releasing the ones before it.
+ *
+ * @param[in,out] ring      Ring to read from.
+ * @param[in]     offset    Number of pending elements to skip.
+ * @param[out]    elements  Set to the first element of the span, or NULL if no element is pending past `offset`.
+ * @param[in]     max_count Largest number of elements wanted.
+ *
+ * @return Number of elements in the span.
+ */
+size_t spsc_ring_peek_at(spsc_ring_st *ring, size_t offset, const void **elements, size_t max_count) {
+    if ((ring == NULL) || (elements == NULL)) {
+        return 0;
+    }
+
+    size_t tail    = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head    = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t pending = head - tail;
+
+    if (offset >= pending) {
+        *elements = NULL;
+        return 0;
+    }
+
+    size_t index = (tail + offset) & (ring->capacity - 1);
+    size_t span  = ring->capacity - index;
+
+    pending -= offset;
+
+    if (span > pending) {
+        span = pending;
+    }
+    if (span > max_count) {
+        span = max_count;
+    }
+
+    *elements = (span > 0) ? &ring->storage[index * ring->element_size] : NULL;
+
+    return span;
+}
+
+/**
+ * @brief Release elements returned by `spsc_ring_peek()`. Consumer only.
+ *
+ * @param[in,out] ring  Ring to release from.
+ * @param[in]     count Number of elements to release, at most the number pending.
+ */
+void spsc_ring_consume(spsc_ring_st *ring, size_t count) {
+    if (ring == NULL) {
+        return;
+    }
+
+    size_t tail    = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t pending = atomic_load_explicit(&ring->head, memory_order_acquire) - tail;
+
+    if (count > pending) {
+        count = pending;
+    }
+
+    // Release so the producer cannot overwrite the slots before they are read.
+    atomic_store_explicit(&ring->tail, tail + count, memory_order_release);
+}
+
+/**
+ * @brief Get the number of pending elements.
+ *
+ * @param[in] ring Ring to check.
+ *
+ * @return Number of elements pushed and not consumed yet.
+ */
+size_t spsc_ring_count(spsc_ring_st *ring) {
+    if (ring == NULL) {
+        return 0;
+    }
+
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    return head - tail;
+}
+
+/**
+ * @brief Get the highest number of pending elements observed since boot.
+ *
+ * @param[in] ring Ring to check.
+ *
+ * @return High-water mark, `capacity` if the ring has been full.
+ */
+size_t spsc_ring_high_water_mark(spsc_ring_st *ring) {
+    if (ring == NULL) {
+        return 0;
+    }
+
+    return atomic_load_explicit(&ring->high_water_mark, memory_order_relaxed);
+}
@@ -0,0 +1,123 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file spsc_ring.h
+ * @brief Lock-free single-producer/single-consumer ring of fixed-size elements.
+ *
+ * The producer only writes `head` and the consumer only writes `tail`; both
+ * indices run freely and are masked on access, so the capacity must be a power
+ * of two. Publishing an index with release semantics after the elements have
+ * been copied makes them visible to the other side without any lock, critical
+ * section or system call, including across the two cores of the ESP32.
+ *
+ * The consumer reads elements in place: `spsc_ring_peek()` returns the
+ * contiguous span of pending elements starting at the tail, which stays valid
+ * until it is released with `spsc_ring_consume()`. `spsc_ring_peek_at()`
+ * reaches the elements past the first span, so the consumer can look at
+ * every pending element before releasing any.
+ *
+ * Exactly one task may push and exactly one task may peek and consume.
+ */
+
+/**
+ * @brief State of a ring.
+ */
+typedef struct spsc_ring_s {
+    uint8_t *storage;               ///< Element storage, `capacity * element_size` bytes owned by the caller.
+    size_t element_size;            ///< Size of one element, in bytes.
+    size_t capacity;                ///< Number of elements, a power of two.
+    atomic_size_t head;             ///< Number of elements pushed so far, written by the producer.
+    atomic_size_t tail;             ///< Number of elements consumed so far, written by the consumer.
+    atomic_size_t high_water_mark;  ///< Highest number of pending elements observed by the producer.
+} spsc_ring_st;
+
+/**
+ * @brief Static initializer of a ring over an array.
+ *
+ * @param storage_  Array holding the elements.
+ * @param capacity_ Number of elements of the array, a power of two.
+ */
+#define SPSC_RING_STATIC_INIT(storage_, capacity_)    \
+    {                                                 \
+        .storage         = (uint8_t *)(storage_),     \
+        .element_size    = sizeof((storage_)[0]),     \
+        .capacity        = (capacity_),               \
+        .head            = 0,                         \
+        .tail            = 0,                         \
+        .high_water_mark = 0,                         \
+    }
+
+/**
+ * @brief Copy one element into the ring. Producer only.
+ *
+ * @param[in,out] ring    Ring to push to.
+ * @param[in]     element Element to copy, `element_size` bytes.
+ *
+ * @return true on success, false if the ring is full.
+ */
+bool spsc_ring_push(spsc_ring_st *ring, const void *element);
+
+/**
+ * @brief Get the contiguous span of pending elements at the tail. Consumer only.
+ *
+ * The span may be shorter than the number of pending elements when they wrap
+ * around the end of the storage; the rest is returned once the span is
+ * consumed.
+ *
+ * @param[in,out] ring      Ring to read from.
+ * @param[out]    elements  Set to the first pending element, or NULL if the ring is empty.
+ * @param[in]     max_count Largest number of elements wanted.
+ *
+ * @return Number of elements in the span.
+ */
+size_t spsc_ring_peek(spsc_ring_st *ring, const void **elements, size_t max_count);
+
+/**
+ * @brief Get a contiguous span of pending elements, past the first `offset` ones. Consumer only.
+ *
+ * Like `spsc_ring_peek()`, but the span starts `offset` elements after the
+ * tail, which gives access to the elements after a wrap-around without
+ * releasing the ones before it.
+ *
+ * @param[in,out] ring      Ring to read from.
+ * @param[in]     offset    Number of pending elements to skip.
+ * @param[out]    elements  Set to the first element of the span, or NULL if no element is pending past `offset`.
+ * @param[in]     max_count Largest number of elements wanted.
+ *
+ * @return Number of elements in the span.
+ */
+size_t spsc_ring_peek_at(spsc_ring_st *ring, size_t offset, const void **elements, size_t max_count);
+
+/**
+ * @brief Release elements returned by `spsc_ring_peek()`. Consumer only.
+ *
+ * @param[in,out] ring  Ring to release from.
+ * @param[in]     count Number of elements to release, at most the number pending.
+ */
+void spsc_ring_consume(spsc_ring_st *ring, size_t count);
+
+/**
+ * @brief Get the number of pending elements.
+ *
+ * @param[in] ring Ring to check.
+ *
+ * @return Number of elements pushed and not consumed yet.
+ */
+size_t spsc_ring_count(spsc_ring_st *ring);
+
+/**
+ * @brief Get the highest number of pending elements observed since boot.
+ *
+ * @param[in] ring Ring to check.
+ *
+ * @return High-water mark, `capacity` if the ring has been full.
+ */
+size_t spsc_ring_high_water_mark(spsc_ring_st *ring);
+
+#endif /* SPSC_RING_H */
@@ -7,13 +7,37 @@
  * functions for initializing SNTP, retrieving time from an NTP server, and
  * signaling successful synchronization via an event group. This task ensures
  * that the system clock is accurately synchronized for time-dependent operations.
+ *
+ * The SNTP client keeps polling the server every `SNTP_SYNC_INTERVAL_MS` and
+ * slews the clock with adjtime() instead of stepping it, so timestamps stay
+ * monotonic. Each synchronization is recorded in RTC memory together with the
+ * measured drift of the local clock. The system time survives every reset but
+ * power-on, so after a reboot the clock is corrected by the expected drift and
+ * `TIME_SYNCED` is set immediately, without waiting for the network.
  */
 
 #include "sntp_task.h"
 #include "events_definition.h"
+#include "metrics.h"
+
+#include <stddef.h>
+#include <string.h>
+#include <sys/time.h>
 
+#include "esp_attr.h"
 #include "esp_log.h"
-#include "lwip/apps/sntp.h"
+#include "esp_rom_crc.h"
+#include "esp_sntp.h"
+
+/**
+ * @brief Clock state kept in RTC memory across resets.
+ */
+typedef struct sntp_rtc_state_s {
+    uint32_t magic;          ///< `SNTP_RTC_MAGIC` once the state has been written.
+    int32_t drift_ppb;       ///< Drift of the local clock, in parts per billion, positive when it runs fast.
+    int64_t last_sync_us;    ///< Server time of the last synchronization, in microseconds since the epoch.
+    uint32_t crc;            ///< CRC32 of the fields above.
+} sntp_rtc_state_st;
 
 /**
  * @brief Event group for signaling system status and events.
@@ -26,48 +50,147 @@
  */
 static EventGroupHandle_t *firmware_event_group = NULL;
 
-static const char *TAG          = "SNTP Task";  ///< Tag for logging
-static bool is_sntp_initialized = false;        ///< Tracks if SNTP has been initialized
-static bool is_sntp_synced      = false;        ///< Tracks if time synchronization is successful
+static const char *TAG                       = "SNTP Task";    ///< Tag for logging
+static const char *SNTP_SERVER               = "pool.ntp.org"; ///< NTP server polled by the client.
+static const uint32_t SNTP_SYNC_INTERVAL_MS  = 3600000;        ///< Interval between two synchronizations, in milliseconds.
+static const uint32_t SNTP_CHECK_INTERVAL_MS = 10000;          ///< Interval between two checks of the link, in milliseconds.
+static const uint32_t SNTP_RTC_MAGIC         = 0x534E5450;     ///< Marks a valid RTC state ("SNTP").
+static const int64_t MAX_DRIFT_PPB           = 500000;         ///< Largest drift accepted as a measurement, 500 ppm.
+static const int64_t MIN_DRIFT_PERIOD_US     = 600000000;      ///< Shortest period drift is measured over, 10 minutes.
+static const int64_t MIN_VALID_EPOCH_S       = 1577836800;     ///< Times before 2020-01-01 mean the clock was never set.
+static bool is_sntp_initialized              = false;          ///< Tracks if SNTP has been initialized
+
+RTC_NOINIT_ATTR static sntp_rtc_state_st rtc_state;  ///< Clock state of the last synchronization.
 
 /**
- * @brief Initialize SNTP and attempt to synchronize time with the server.
+ * @brief Get the current system time.
  *
- * This function configures the SNTP client, initializes it if not already done, and
- * retrieves the current time. If the time is successfully synchronized, an event
- * bit (TIME_SYNCED) is set in the event group.
+ * @return System time, in microseconds since the epoch.
  */
-static void sntp_task_sync_time_obtain_time(void) {
-    time_t now         = 0;
-    struct tm timeinfo = {0};
+static int64_t sntp_task_get_time_us(void) {
+    struct timeval now = {0};
+    gettimeofday(&now, NULL);
 
-    time(&now);
-    localtime_r(&now, &timeinfo);
+    return ((int64_t)now.tv_sec * 1000000) + now.tv_usec;
+}
 
-    if (!is_sntp_initialized) {
-        sntp_setoperatingmode(SNTP_OPMODE_POLL);
-        sntp_setservername(0, "pool.ntp.org");
-        sntp_init();
+/**
+ * @brief Computes the CRC protecting the RTC state.
+ *
+ * @param[in] state RTC state.
+ *
+ * @return CRC32 of every field but the CRC itself.
+ */
+static uint32_t sntp_task_rtc_crc(const sntp_rtc_state_st *state) {
+    return esp_rom_crc32_le(0, (const uint8_t *)state, offsetof(sntp_rtc_state_st, crc));
+}
 
-        setenv("TZ", "GMT+3", 1);
-        tzset();
-        is_sntp_initialized = true;
+/**
+ * @brief Records a synchronization in RTC memory.
+ *
+ * The drift is measured from the error the local clock accumulated since the
+ * previous synchronization, when that one is recent enough to be trusted and
+ * old enough to give a meaningful measure.
+ *
+ * @param[in] server_us Server time, in microseconds since the epoch.
+ * @param[in] local_us  Local time when the server time was received.
+ */
+static void sntp_task_record_sync(int64_t server_us, int64_t local_us) {
+    bool is_valid     = (rtc_state.magic == SNTP_RTC_MAGIC) && (rtc_state.crc == sntp_task_rtc_crc(&rtc_state));
+    int64_t period_us = server_us - rtc_state.last_sync_us;
+
+    if (!is_valid) {
+        rtc_state.drift_ppb = 0;
+    } else if ((period_us >= MIN_DRIFT_PERIOD_US) && (period_us <= 4 * (int64_t)SNTP_SYNC_INTERVAL_MS * 1000)) {
+        // The clock was slewed to the server at the previous sync, the error is what it drifted since.
+        int64_t drift_ppb = ((local_us - server_us) * 1000000000) / period_us;
+        if ((drift_ppb > -MAX_DRIFT_PPB) && (drift_ppb < MAX_DRIFT_PPB)) {
+            rtc_state.drift_ppb = (int32_t)drift_ppb;
+        }
     }
 
-    if (timeinfo.tm_year < (2020 - 1900)) {
-        xEventGroupClearBits(*firmware_event_group, TIME_SYNCED);
-    } else {
-        xEventGroupSetBits(*firmware_event_group, TIME_SYNCED);
-        is_sntp_synced = true;
+    rtc_state.magic        = SNTP_RTC_MAGIC;
+    rtc_state.last_sync_us = server_us;
+    rtc_state.crc          = sntp_task_rtc_crc(&rtc_state);
+}
+
+/**
+ * @brief Callback of the SNTP client, called on every synchronization.
+ *
+ * Runs in the lwIP task. In smooth mode the system time has not been slewed
+ * yet, so its distance to the received time is the accumulated error.
+ *
+ * @param[in] tv Time received from the server.
+ */
+static void sntp_task_on_time_sync(struct timeval *tv) {
+    int64_t server_us = ((int64_t)tv->tv_sec * 1000000) + tv->tv_usec;
+    int64_t local_us  = sntp_task_get_time_us();
+
+    sntp_task_record_sync(server_us, local_us);
+    xEventGroupSetBits(*firmware_event_group, TIME_SYNCED);
+
+    ESP_LOGI(TAG, "Time synchronized, local clock off by %lld ms, drift %ld ppb",
+             (long long)((local_us - server_us) / 1000), (long)rtc_state.drift_ppb);
+}
+
+/**
+ * @brief Restores a trusted time after a reset.
+ *
+ * The system time survives every reset but power-on. When it is still valid
+ * and a synchronization was recorded, the drift accumulated since then is
+ * corrected and the time is trusted right away. Otherwise publishing waits
+ * for the first synchronization.
+ */
+static void sntp_task_restore_time(void) {
+    int64_t now_us = sntp_task_get_time_us();
+
+    if ((rtc_state.magic != SNTP_RTC_MAGIC) || (rtc_state.crc != sntp_task_rtc_crc(&rtc_state)) ||
+        (now_us < (MIN_VALID_EPOCH_S * 1000000)) || (now_us < rtc_state.last_sync_us)) {
+        ESP_LOGI(TAG, "No time to restore, waiting for the first synchronization");
+        return;
+    }
+
+    int64_t correction_us = -((now_us - rtc_state.last_sync_us) * rtc_state.drift_ppb) / 1000000000;
+    struct timeval delta  = {
+         .tv_sec  = correction_us / 1000000,
+         .tv_usec = correction_us % 1000000,
+    };
+    adjtime(&delta, NULL);
+
+    xEventGroupSetBits(*firmware_event_group, TIME_SYNCED);
+    ESP_LOGI(TAG, "Time restored, last synchronized %lld s ago, correcting %lld ms",
+             (long long)((now_us - rtc_state.last_sync_us) / 1000000), (long long)(correction_us / 1000));
+}
+
+/**
+ * @brief Initialize the SNTP client.
+ *
+ * The client polls the server periodically on its own and slews the clock
+ * smoothly; every synchronization is reported to `sntp_task_on_time_sync()`.
+ */
+static void sntp_task_initialize(void) {
+    if (is_sntp_initialized) {
+        return;
     }
+
+    esp_sntp_setoperatingmode(ESP_SNTP_OPMODE_POLL);
+    esp_sntp_setservername(0, SNTP_SERVER);
+    sntp_set_sync_mode(SNTP_SYNC_MODE_SMOOTH);
+    sntp_set_sync_interval(SNTP_SYNC_INTERVAL_MS);
+    sntp_set_time_sync_notification_cb(sntp_task_on_time_sync);
+    esp_sntp_init();
+
+    is_sntp_initialized = true;
 }
 
 /**
  * @brief Task to manage SNTP time synchronization.
  *
- * This task waits for the system to connect to the Wi-Fi network and then
- * attempts to synchronize the system time with an SNTP server. The task
- * exits once synchronization is successful.
+ * This task restores the time kept across resets, waits for the system to
+ * connect to the Wi-Fi network and then starts the SNTP client, which keeps
+ * the time synchronized in the background. The task then watches the link
+ * and requests a synchronization as soon as it comes back after an outage
+ * longer than the synchronization interval.
  *
  * @param pvParameters Pointer to the event group handle for synchronization.
  */
@@ -80,27 +203,31 @@ void sntp_task_execute(void *pvParameters) {
         vTaskDelete(NULL);
     }
 
-    ESP_LOGI(TAG, "Waiting for Wi-Fi connection...");
-    EventBits_t firmware_event_bits = xEventGroupWaitBits(*firmware_event_group,
-                                                          WIFI_CONNECTED_STA,
-                                                          pdFALSE,
-                                                          pdFALSE,
-                                                          portMAX_DELAY);
+    metrics_register_task();
+
+    setenv("TZ", "GMT+3", 1);
+    tzset();
+
+    sntp_task_restore_time();
+
+    bool was_connected = false;
 
     while (1) {
-        if (firmware_event_bits & WIFI_CONNECTED_STA) {
+        EventBits_t firmware_event_bits = xEventGroupGetBits(*firmware_event_group);
+        bool is_connected               = (firmware_event_bits & WIFI_CONNECTED_STA) != 0;
+
+        if (is_connected && !is_sntp_initialized) {
             ESP_LOGI(TAG, "Trying to synchronize time...");
-            sntp_task_sync_time_obtain_time();
+            sntp_task_initialize();
+        } else if (is_connected && !was_connected) {
+            int64_t since_sync_us = sntp_task_get_time_us() - rtc_state.last_sync_us;
+            if (since_sync_us >= ((int64_t)SNTP_SYNC_INTERVAL_MS * 1000)) {
+                ESP_LOGI(TAG, "Link restored, resynchronizing time...");
+                esp_sntp_restart();
+            }
         }
+        was_connected = is_connected;
 
-        vTaskDelay(pdMS_TO_TICKS(1000));
-
-        if (is_sntp_synced) {
-            ESP_LOGI(TAG, "Time synchronization successful. Exiting SNTP task.");
-            break;
-        }
+        vTaskDelay(pdMS_TO_TICKS(SNTP_CHECK_INTERVAL_MS));
     }
-
-    ESP_LOGI(TAG, "SNTP task completed. Deleting task...");
-    vTaskDelete(NULL);
-}
\ No newline at end of file
+}
@@ -15,9 +15,11 @@
 /**
  * @brief Task to manage SNTP time synchronization.
  *
- * This task waits for the system to connect to the Wi-Fi network and then
- * attempts to synchronize the system time with an SNTP server. The task
- * exits once synchronization is successful.
+ * This task restores the time kept across resets, waits for the system to
+ * connect to the Wi-Fi network and then starts the SNTP client, which keeps
+ * the time synchronized in the background. The task then watches the link
+ * and requests a synchronization as soon as it comes back after an outage
+ * longer than the synchronization interval.
  *
  * @param pvParameters Pointer to the event group handle for synchronization.
  */
@@ -0,0 +1,503 @@
+/**
+ * @file telemetry_store.c
+ * @brief Implementation of the flash ring log used to buffer samples while offline.
+ *
+ * Every sector of the partition starts with a 16-byte header holding a magic
+ * number and a sequence number incremented each time a sector is recycled; the
+ * sector with the highest sequence number is the head of the ring. The header
+ * is followed by fixed 36-byte records:
+ *
+ * | Offset | Size | Field                                                           |
+ * |--------|------|-----------------------------------------------------------------|
+ * | 0      | 1    | State (erased, valid or consumed)                               |
+ * | 1      | 1    | Sensor identifier                                               |
+ * | 2      | 2    | CRC16 of byte 1 and bytes 4 to 35                               |
+ * | 4      | 8    | Timestamp, epoch milliseconds (int64)                           |
+ * | 12     | 2    | Number of readings aggregated (uint16)                          |
+ * | 14     | 8    | Temperature mean, min, max, stddev, centi-degrees C (4 x int16) |
+ * | 22     | 8    | Humidity mean, min, max, stddev, centi-percent (4 x uint16)     |
+ * | 30     | 4    | Sequence number of the sample (uint32)                          |
+ * | 34     | 2    | Reserved, always 0xFFFF                                         |
+ *
+ * A record goes from erased to valid when it is written and from valid to
+ * consumed once replayed, both transitions only clearing bits so no erase is
+ * needed. This requires the partition not to be encrypted.
+ */
+
+#include "telemetry_store.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+
+#define STORE_SECTOR_SIZE 4096  ///< Flash sector size, in bytes.
+#define STORE_HEADER_SIZE 16    ///< Size of a sector header, in bytes.
+#define STORE_STATS_COUNT 4     ///< Statistics stored per quantity: mean, minimum, maximum, standard deviation.
+#define STORE_RECORD_SIZE 36    ///< Size of a record, in bytes.
+
+/** @brief Number of records held by a sector. */
+#define STORE_RECORDS_PER_SECTOR ((STORE_SECTOR_SIZE - STORE_HEADER_SIZE) / STORE_RECORD_SIZE)
+
+static const char *TAG                             = "Telemetry Store";  ///< Tag for logging.
+static const char *STORE_PARTITION_LABEL           = "telemetry";        ///< Label of the partition holding the log.
+static const esp_partition_subtype_t STORE_SUBTYPE = 0x40;               ///< Custom data subtype of the partition.
+static const uint32_t STORE_SECTOR_MAGIC           = 0x544C5334;         ///< Sector header magic ("TLS4").
+static const uint8_t RECORD_STATE_ERASED           = 0xFF;               ///< Record slot never written.
+static const uint8_t RECORD_STATE_VALID            = 0x5A;               ///< Record written and pending replay.
+static const uint8_t RECORD_STATE_CONSUMED         = 0x00;               ///< Record already replayed.
+
+/**
+ * @brief Position of a record slot in the ring.
+ */
+typedef struct store_position_s {
+    uint32_t sector;  ///< Sector index inside the partition.
+    uint32_t record;  ///< Record index inside the sector, `STORE_RECORDS_PER_SECTOR` when past the end.
+} store_position_st;
+
+static const esp_partition_t *partition = NULL;  ///< Partition holding the log, NULL when not mounted.
+static uint32_t sector_count            = 0;     ///< Number of sectors in the partition.
+static uint32_t head_sequence           = 0;     ///< Sequence number of the head sector.
+static store_position_st head           = {0};   ///< Next slot to be written.
+static store_position_st tail           = {0};   ///< Oldest slot that may hold a pending record.
+
+/**
+ * @brief Compute the partition offset of a record slot.
+ */
+static size_t record_offset(const store_position_st *position) {
+    return (position->sector * STORE_SECTOR_SIZE) + STORE_HEADER_SIZE + (position->record * STORE_RECORD_SIZE);
+}
+
+/**
+ * @brief Check whether two positions designate the same slot.
+ */
+static bool is_same_position(const store_position_st *a, const store_position_st *b) {
+    return (a->sector == b->sector) && (a->record == b->record);
+}
+
+/**
+ * @brief Move a position to the next slot, wrapping to the next sector.
+ *
+ * Positions in the head sector are allowed to sit past its last record, which
+ * means the head sector is full.
+ */
+static void advance_position(store_position_st *position) {
+    position->record++;
+    if ((position->record >= STORE_RECORDS_PER_SECTOR) && (position->sector != head.sector)) {
+        position->sector = (position->sector + 1) % sector_count;
+        position->record = 0;
+    }
+}
+
+/**
+ * @brief Read the header of a sector.
+ *
+ * @param[in]  sector   Sector index.
+ * @param[out] sequence Sequence number of the sector.
+ *
+ * @return true if the sector holds a valid header.
+ */
+static bool read_sector_header(uint32_t sector, uint32_t *sequence) {
+    uint32_t header[2] = {0};
+
+    if (esp_partition_read(partition, sector * STORE_SECTOR_SIZE, header, sizeof(header)) != ESP_OK) {
+        return false;
+    }
+    *sequence = header[1];
+
+    return header[0] == STORE_SECTOR_MAGIC;
+}
+
+/**
+ * @brief Erase a sector and write a fresh header with the given sequence number.
+ */
+static esp_err_t format_sector(uint32_t sector, uint32_t sequence) {
+    uint32_t header[STORE_HEADER_SIZE / sizeof(uint32_t)] = {STORE_SECTOR_MAGIC, sequence, UINT32_MAX, UINT32_MAX};
+
+    esp_err_t result = esp_partition_erase_range(partition, sector * STORE_SECTOR_SIZE, STORE_SECTOR_SIZE);
+    if (result == ESP_OK) {
+        result = esp_partition_write(partition, sector * STORE_SECTOR_SIZE, header, sizeof(header));
+    }
+
+    return result;
+}
+
+/**
+ * @brief Read the state byte of a record slot.
+ */
+static uint8_t read_record_state(const store_position_st *position) {
+    uint8_t state = RECORD_STATE_ERASED;
+    esp_partition_read(partition, record_offset(position), &state, sizeof(state));
+    return state;
+}
+
+/**
+ * @brief Store a 16-bit value in little-endian order.
+ */
+static void put_le16(uint8_t *buffer, uint16_t value) {
+    buffer[0] = (uint8_t)(value);
+    buffer[1] = (uint8_t)(value >> 8);
+}
+
+/**
+ * @brief Store a 32-bit value in little-endian order.
+ */
+static void put_le32(uint8_t *buffer, uint32_t value) {
+    put_le16(&buffer[0], (uint16_t)value);
+    put_le16(&buffer[2], (uint16_t)(value >> 16));
+}
+
+/**
+ * @brief Load a 16-bit value stored in little-endian order.
+ */
+static uint16_t get_le16(const uint8_t *buffer) {
+    return (uint16_t)buffer[0] | ((uint16_t)buffer[1] << 8);
+}
+
+/**
+ * @brief Load a 32-bit value stored in little-endian order.
+ */
+static uint32_t get_le32(const uint8_t *buffer) {
+    return (uint32_t)get_le16(&buffer[0]) | ((uint32_t)get_le16(&buffer[2]) << 16);
+}
+
+/**
+ * @brief Compute the CRC of a raw record, covering the sensor identifier and the payload.
+ *
+ * @param[in] raw Raw record of `STORE_RECORD_SIZE` bytes.
+ *
+ * @return The CRC16 stored in bytes 2 and 3 of the record.
+ */
+static uint16_t record_crc(const uint8_t *raw) {
+    uint16_t crc = esp_rom_crc16_le(0, &raw[1], 1);
+    return esp_rom_crc16_le(crc, &raw[4], STORE_RECORD_SIZE - 4);
+}
+
+/**
+ * @brief Read and decode a record slot.
+ *
+ * @param[in]  position Slot to read.
+ * @param[out] record   Decoded sample.
+ *
+ * @return true if the slot holds a valid, pending record.
+ */
+static bool read_record(const store_position_st *position, telemetry_store_record_st *record) {
+    uint8_t raw[STORE_RECORD_SIZE] = {0};
+
+    if (esp_partition_read(partition, record_offset(position), raw, sizeof(raw)) != ESP_OK) {
+        return false;
+    }
+
+    if (raw[0] != RECORD_STATE_VALID) {
+        return false;
+    }
+
+    uint16_t crc = get_le16(&raw[2]);
+    if (record_crc(raw) != crc) {
+        return false;
+    }
+
+    uint64_t timestamp = 0;
+    for (uint8_t i = 0; i < 8; i++) {
+        timestamp |= (uint64_t)raw[4 + i] << (8 * i);
+    }
+
+    uint16_t temperatures[STORE_STATS_COUNT] = {0};
+    uint16_t humidities[STORE_STATS_COUNT]   = {0};
+    for (uint8_t i = 0; i < STORE_STATS_COUNT; i++) {
+        temperatures[i] = get_le16(&raw[14 + 2 * i]);
+        humidities[i]   = get_le16(&raw[22 + 2 * i]);
+    }
+
+    record->timestamp_ms              = (int64_t)timestamp;
+    record->sample.sensor_id          = raw[1];
+    record->sample.sequence           = get_le32(&raw[30]);
+    record->sample.sample_count       = get_le16(&raw[12]);
+    record->sample.temperature        = (int16_t)temperatures[0];
+    record->sample.temperature_min    = (int16_t)temperatures[1];
+    record->sample.temperature_max    = (int16_t)temperatures[2];
+    record->sample.temperature_stddev = temperatures[3];
+    record->sample.humidity           = humidities[0];
+    record->sample.humidity_min       = humidities[1];
+    record->sample.humidity_max       = humidities[2];
+    record->sample.humidity_stddev    = humidities[3];
+
+    return true;
+}
+
+/**
+ * @brief Move the tail past the slots that hold no intact record.
+ *
+ * Leaves the tail on the oldest record `telemetry_store_peek()` returns, so a
+ * log holding only torn or consumed records reads as empty. The skipped slots
+ * are left as they are in flash and skipped again after a reboot.
+ */
+static void skip_unreadable_records(void) {
+    telemetry_store_record_st record = {0};
+
+    while (!is_same_position(&tail, &head) && !read_record(&tail, &record)) {
+        advance_position(&tail);
+    }
+}
+
+/**
+ * @brief Find the oldest pending record, starting from the sector after the head.
+ *
+ * Records are consumed in order, so a sector whose last record is not pending
+ * holds nothing to replay and is skipped without scanning it.
+ */
+static void recover_tail(void) {
+    tail = head;
+
+    for (uint32_t i = 1; i <= sector_count; i++) {
+        store_position_st position = {.sector = (head.sector + i) % sector_count, .record = 0};
+        uint32_t sequence          = 0;
+
+        if (!read_sector_header(position.sector, &sequence)) {
+            continue;
+        }
+
+        uint32_t last_record = (position.sector == head.sector) ? head.record : STORE_RECORDS_PER_SECTOR;
+        if (last_record == 0) {
+            continue;
+        }
+
+        store_position_st last = {.sector = position.sector, .record = last_record - 1};
+        if ((position.sector != head.sector) && (read_record_state(&last) != RECORD_STATE_VALID)) {
+            continue;
+        }
+
+        for (; position.record < last_record; position.record++) {
+            if (read_record_state(&position) == RECORD_STATE_VALID) {
+                tail = position;
+                return;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Mount the telemetry log.
+ *
+ * Locates the "telemetry" partition and recovers the write and replay
+ * positions from the records already in flash. The partition is formatted
+ * if it holds no valid sector. Mounting an already mounted log does nothing.
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the partition does not exist,
+ *         or an error code from the flash driver.
+ */
+esp_err_t telemetry_store_init(void) {
+    if (partition != NULL) {
+        return ESP_OK;
+    }
+
+    const esp_partition_t *found = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, STORE_SUBTYPE, STORE_PARTITION_LABEL);
+    if (found == NULL) {
+        ESP_LOGE(TAG, "Partition \"%s\" not found", STORE_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    partition    = found;
+    sector_count = partition->size / STORE_SECTOR_SIZE;
+    if (sector_count < 2) {
+        ESP_LOGE(TAG, "Partition too small: %lu bytes", (unsigned long)partition->size);
+        partition = NULL;
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    bool is_formatted = false;
+    for (uint32_t sector = 0; sector < sector_count; sector++) {
+        uint32_t sequence = 0;
+        if (read_sector_header(sector, &sequence) && (!is_formatted || (sequence > head_sequence))) {
+            head.sector   = sector;
+            head_sequence = sequence;
+            is_formatted  = true;
+        }
+    }
+
+    if (!is_formatted) {
+        ESP_LOGI(TAG, "Formatting partition \"%s\"", STORE_PARTITION_LABEL);
+        head.sector      = 0;
+        head_sequence    = 0;
+        esp_err_t result = format_sector(head.sector, head_sequence);
+        if (result != ESP_OK) {
+            partition = NULL;
+            return result;
+        }
+    }
+
+    for (head.record = 0; head.record < STORE_RECORDS_PER_SECTOR; head.record++) {
+        if (read_record_state(&head) == RECORD_STATE_ERASED) {
+            break;
+        }
+    }
+
+    recover_tail();
+    skip_unreadable_records();
+
+    ESP_LOGI(TAG, "Mounted %lu sectors, head at %lu:%lu, tail at %lu:%lu",
+             (unsigned long)sector_count,
+             (unsigned long)head.sector, (unsigned long)head.record,
+             (unsigned long)tail.sector, (unsigned long)tail.record);
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Append a sample to the log.
+ *
+ * May erase a sector (tens of milliseconds) when the current one is full.
+ *
+ * @param[in] record Sample to append.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if `record` is NULL,
+ *         ESP_ERR_INVALID_STATE if the store is not mounted, or an error
+ *         code from the flash driver.
+ */
+esp_err_t telemetry_store_append(const telemetry_store_record_st *record) {
+    if (record == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (partition == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (head.record >= STORE_RECORDS_PER_SECTOR) {
+        uint32_t next_sector = (head.sector + 1) % sector_count;
+        bool was_empty       = telemetry_store_is_empty();
+
+        esp_err_t result = format_sector(next_sector, head_sequence + 1);
+        if (result != ESP_OK) {
+            return result;
+        }
+
+        if (!was_empty && (tail.sector == next_sector)) {
+            ESP_LOGW(TAG, "Log full, dropping the oldest sector");
+            tail.sector = (next_sector + 1) % sector_count;
+            tail.record = 0;
+        }
+
+        head.sector = next_sector;
+        head.record = 0;
+        head_sequence++;
+
+        if (was_empty) {
+            tail = head;
+        }
+    }
+
+    const uint16_t temperatures[] = {(uint16_t)record->sample.temperature, (uint16_t)record->sample.temperature_min,
+                                     (uint16_t)record->sample.temperature_max, record->sample.temperature_stddev};
+    const uint16_t humidities[]   = {record->sample.humidity, record->sample.humidity_min,
+                                     record->sample.humidity_max, record->sample.humidity_stddev};
+    uint64_t timestamp            = (uint64_t)record->timestamp_ms;
+    uint8_t raw[STORE_RECORD_SIZE];
+
+    raw[0] = RECORD_STATE_VALID;
+    raw[1] = record->sample.sensor_id;
+    for (uint8_t i = 0; i < 8; i++) {
+        raw[4 + i] = (uint8_t)(timestamp >> (8 * i));
+    }
+    put_le16(&raw[12], record->sample.sample_count);
+    for (uint8_t i = 0; i < STORE_STATS_COUNT; i++) {
+        put_le16(&raw[14 + 2 * i], temperatures[i]);
+        put_le16(&raw[22 + 2 * i], humidities[i]);
+    }
+    put_le32(&raw[30], record->sample.sequence);
+    put_le16(&raw[34], UINT16_MAX);
+
+    put_le16(&raw[2], record_crc(raw));
+
+    esp_err_t result = esp_partition_write(partition, record_offset(&head), raw, sizeof(raw));
+    // The slot is used even if the write failed, a partial record fails its CRC.
+    head.record++;
+    if (result != ESP_OK) {
+        skip_unreadable_records();
+    }
+
+    return result;
+}
+
+/**
+ * @brief Read the oldest pending samples without removing them from the log.
+ *
+ * @param[out] records   Array receiving the samples, oldest first.
+ * @param[in]  max_count Capacity of `records`.
+ * @param[out] count     Number of samples read.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid parameters,
+ *         ESP_ERR_INVALID_STATE if the store is not mounted.
+ */
+esp_err_t telemetry_store_peek(telemetry_store_record_st *records, size_t max_count, size_t *count) {
+    if ((records == NULL) || (count == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *count = 0;
+    if (partition == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    store_position_st position = tail;
+    while ((*count < max_count) && !is_same_position(&position, &head)) {
+        if (read_record(&position, &records[*count])) {
+            (*count)++;
+        }
+        advance_position(&position);
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Remove the oldest pending samples from the log.
+ *
+ * Records failing their CRC, such as torn writes, are passed over and marked
+ * consumed without being counted, since `telemetry_store_peek()` skips them.
+ * Those following the last removed sample are passed over as well, so the log
+ * reads as empty once every intact sample has been removed.
+ *
+ * @param[in] count Number of samples to remove, as returned by `telemetry_store_peek()`.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if the store is not mounted,
+ *         or an error code from the flash driver.
+ */
+esp_err_t telemetry_store_consume(size_t count) {
+    if (partition == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    telemetry_store_record_st record = {0};
+    esp_err_t result                 = ESP_OK;
+
+    while ((count > 0) && !is_same_position(&tail, &head)) {
+        if (read_record_state(&tail) == RECORD_STATE_VALID) {
+            bool is_intact = read_record(&tail, &record);
+            result         = esp_partition_write(partition, record_offset(&tail), &RECORD_STATE_CONSUMED, sizeof(RECORD_STATE_CONSUMED));
+            if (result != ESP_OK) {
+                break;
+            }
+            if (is_intact) {
+                count--;
+            }
+        }
+        advance_position(&tail);
+    }
+
+    if (result == ESP_OK) {
+        skip_unreadable_records();
+    }
+
+    return result;
+}
+
+/**
+ * @brief Check whether the log holds pending samples.
+ *
+ * @return true if there is nothing to replay or the store is not mounted.
+ */
+bool telemetry_store_is_empty(void) {
+    return (partition == NULL) || is_same_position(&tail, &head);
+}
@@ -0,0 +1,95 @@
+#ifndef TELEMETRY_STORE_H
+#define TELEMETRY_STORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "temperature_monitor_task.h"
+
+/**
+ * @file telemetry_store.h
+ * @brief Persistent store-and-forward log for samples produced while offline.
+ *
+ * Samples are appended as compact fixed-size records to the "telemetry" data
+ * partition, which is used as a ring of flash sectors. Records are only ever
+ * appended inside the current sector; once it is full the next sector is
+ * erased and becomes the new head, so every sector of the partition is erased
+ * in turn and wear is spread evenly. When the ring is full the oldest sector is
+ * recycled.
+ *
+ * Replayed records are marked as consumed in place, which keeps the replay
+ * position across reboots without a separate index. The store is not thread
+ * safe and is meant to be used by the MQTT task only.
+ */
+
+/**
+ * @brief Sample stored in the telemetry log.
+ */
+typedef struct telemetry_store_record_s {
+    int64_t timestamp_ms;        ///< Time the sample was acquired, in milliseconds since the epoch.
+    temperature_data_st sample;  ///< Stored sample, its monotonic timestamp is not kept across reboots.
+} telemetry_store_record_st;
+
+/**
+ * @brief Mount the telemetry log.
+ *
+ * Locates the "telemetry" partition and recovers the write and replay
+ * positions from the records already in flash. The partition is formatted
+ * if it holds no valid sector. Mounting an already mounted log does nothing.
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the partition does not exist,
+ *         or an error code from the flash driver.
+ */
+esp_err_t telemetry_store_init(void);
+
+/**
+ * @brief Append a sample to the log.
+ *
+ * May erase a sector (tens of milliseconds) when the current one is full.
+ *
+ * @param[in] record Sample to append.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if `record` is NULL,
+ *         ESP_ERR_INVALID_STATE if the store is not mounted, or an error
+ *         code from the flash driver.
+ */
+esp_err_t telemetry_store_append(const telemetry_store_record_st *record);
+
+/**
+ * @brief Read the oldest pending samples without removing them from the log.
+ *
+ * @param[out] records   Array receiving the samples, oldest first.
+ * @param[in]  max_count Capacity of `records`.
+ * @param[out] count     Number of samples read.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid parameters,
+ *         ESP_ERR_INVALID_STATE if the store is not mounted, or an error
+ *         code from the flash driver.
+ */
+esp_err_t telemetry_store_peek(telemetry_store_record_st *records, size_t max_count, size_t *count);
+
+/**
+ * @brief Remove the oldest pending samples from the log.
+ *
+ * Records failing their CRC, such as torn writes, are passed over and marked
+ * consumed without being counted, since `telemetry_store_peek()` skips them.
+ * Those following the last removed sample are passed over as well, so the log
+ * reads as empty once every intact sample has been removed.
+ *
+ * @param[in] count Number of samples to remove, as returned by `telemetry_store_peek()`.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if the store is not mounted,
+ *         or an error code from the flash driver.
+ */
+esp_err_t telemetry_store_consume(size_t count);
+
+/**
+ * @brief Check whether the log holds pending samples.
+ *
+ * @return true if there is nothing to replay or the store is not mounted.
+ */
+bool telemetry_store_is_empty(void);
+
+#endif /* TELEMETRY_STORE_H */
@@ -2,207 +2,372 @@
  * @file aht10.c
  * @brief Driver for AHT10 temperature and humidity sensor.
  *
- * This file contains functions and configurations to interface with the AHT10
- * sensor over I2C. It supports initializing the sensor, triggering measurements,
- * and reading temperature and humidity data. The I2C master configuration is also
- * included for communication with the sensor.
+ * This file contains functions and configurations to interface with AHT10 and
+ * AHT20 sensors over I2C. It supports initializing the sensors, triggering
+ * measurements, and reading temperature and humidity data. Sensors are addressed
+ * through device handles and may sit behind a TCA9548A multiplexer, whose
+ * channel is selected transparently before each access.
  */
 
 #include "aht10.h"
+#include "deferred_log.h"
 #include "driver/i2c.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "metrics.h"
+
+#define AHT10_CMD_LINK_SIZE I2C_LINK_RECOMMENDED_SIZE(3)  ///< Size of a statically allocated I2C command link.
+
+static const size_t I2C_MASTER_TX_BUF_DISABLE = 0;                    ///< Disable I2C TX buffer
+static const size_t I2C_MASTER_RX_BUF_DISABLE = 0;                    ///< Disable I2C RX buffer
+static const uint8_t AHT10_CMD_INIT           = 0xE1;                 ///< AHT10 initialization command
+static const uint8_t AHT20_CMD_INIT           = 0xBE;                 ///< AHT20 initialization command
+static const uint8_t AHT20_CMD_INIT_CONFIG    = 0x08;                 ///< Calibration enable byte for the AHT20 initialization command
+static const uint8_t AHT10_CMD_TRIGGER        = 0xAC;                 ///< AHT10 trigger measurement command
+static const uint8_t AHT10_CMD_TRIGGER_CONFIG = 0x33;                 ///< Configuration byte for the trigger command
+static const uint8_t AHT10_CMD_RESERVED       = 0x00;                 ///< Reserved byte for the trigger command
+static const uint8_t AHT10_STATUS_BUSY        = 0x80;                 ///< Status bit set while a measurement is in progress
+static const uint8_t TCA9548A_MAX_CHANNEL     = 7;                    ///< Highest channel of the TCA9548A multiplexer
+static const TickType_t AHT10_I2C_TIMEOUT     = pdMS_TO_TICKS(1000);  ///< Timeout of a single I2C transaction
+static const char* TAG                        = "AHT10";              ///< Tag for logging.
 
-static const gpio_num_t I2C_MASTER_SCL_IO     = GPIO_NUM_22;  ///< GPIO pin for I2C SCL
-static const gpio_num_t I2C_MASTER_SDA_IO     = GPIO_NUM_21;  ///< GPIO pin for I2C SDA
-static const i2c_port_t I2C_MASTER_NUM        = I2C_NUM_0;    ///< I2C port number
-static const uint32_t I2C_MASTER_FREQ_HZ      = 100000;       ///< I2C clock frequency (100kHz standard)
-static const size_t I2C_MASTER_TX_BUF_DISABLE = 0;            ///< Disable I2C TX buffer
-static const size_t I2C_MASTER_RX_BUF_DISABLE = 0;            ///< Disable I2C RX buffer
-static const uint8_t AHT10_SENSOR_ADDR        = 0x38;         ///< AHT10 sensor I2C address
-static const uint8_t AHT10_CMD_INIT           = 0xE1;         ///< AHT10 initialization command
-static const uint8_t AHT10_CMD_TRIGGER        = 0xAC;         ///< AHT10 trigger measurement command
-static const uint8_t AHT10_CMD_TRIGGER_CONFIG = 0x33;         ///< Configuration byte for the trigger command
-static const uint8_t AHT10_CMD_RESERVED       = 0x00;         ///< Reserved byte for the trigger command
-static const char* TAG                        = "AHT10";      ///< Tag for logging.
+/**
+ * @brief Multiplexer channel routed on an I2C port.
+ */
+typedef struct aht10_mux_selection_s {
+    uint8_t mux_address;  ///< Multiplexer with an open channel, or `AHT10_NO_MUX`.
+    uint8_t mux_channel;  ///< Open channel of that multiplexer.
+} aht10_mux_selection_st;
 
 /**
- * @brief Initializes the I2C master interface for communication with the AHT10 sensor.
+ * @brief Multiplexer channel currently routed on each I2C port.
  *
- * This function configures the I2C bus parameters, including the SDA and SCL pins,
- * clock speed, and pull-up resistors. It also installs the I2C driver for communication.
+ * Selecting a channel costs an I2C transaction, so the last selection is
+ * cached and only changed when the next sensor sits behind another channel.
+ */
+static aht10_mux_selection_st selected_mux[I2C_NUM_MAX] = {0};
+
+/**
+ * @brief Executes an I2C command link and records its duration.
+ *
+ * @param[in] port   I2C port to execute the command on.
+ * @param[in] handle Command link to execute.
  *
- * @return ESP_OK on success, ESP_FAIL or other error codes if initialization fails.
+ * @return ESP_OK on success, or an error code if the I2C communication fails.
  */
-static esp_err_t aht10_i2c_master_init() {
-    i2c_config_t config     = {};
-    config.mode             = I2C_MODE_MASTER;
-    config.sda_io_num       = I2C_MASTER_SDA_IO;
-    config.scl_io_num       = I2C_MASTER_SCL_IO;
-    config.sda_pullup_en    = GPIO_PULLUP_ENABLE;
-    config.scl_pullup_en    = GPIO_PULLUP_ENABLE;
-    config.master.clk_speed = I2C_MASTER_FREQ_HZ;
-
-    ESP_ERROR_CHECK(i2c_param_config(I2C_MASTER_NUM, &config));
-    return i2c_driver_install(I2C_MASTER_NUM, config.mode, I2C_MASTER_TX_BUF_DISABLE, I2C_MASTER_RX_BUF_DISABLE, 0);
+static esp_err_t aht10_i2c_execute(i2c_port_t port, i2c_cmd_handle_t handle) {
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t result = i2c_master_cmd_begin(port, handle, AHT10_I2C_TIMEOUT);
+
+    metrics_histogram_record(METRICS_HISTOGRAM_I2C_TRANSACTION_US, (uint32_t)(esp_timer_get_time() - start_us));
+    if (result != ESP_OK) {
+        metrics_counter_add(METRICS_COUNTER_I2C_ERRORS, 1);
+    }
+
+    return result;
 }
 
 /**
- * @brief Sends a single command byte to the AHT10 sensor over I2C.
+ * @brief Writes raw bytes to a device over I2C.
  *
- * This function is used to send a command byte to the AHT10 sensor to trigger its operation.
+ * The I2C command link is built in a buffer on the stack, so no heap
+ * allocation takes place.
  *
- * @param[in] cmd The command byte to send to the sensor.
+ * @param[in] port     I2C port of the device.
+ * @param[in] address  I2C address of the device.
+ * @param[in] data     Pointer to the bytes to write.
+ * @param[in] data_size Number of bytes to write.
  *
  * @return ESP_OK on success, or an error code if the I2C communication fails.
  */
-static esp_err_t aht10_send_cmd(uint8_t cmd) {
-    i2c_cmd_handle_t handle = i2c_cmd_link_create();
+static esp_err_t aht10_i2c_write(i2c_port_t port, uint8_t address, const uint8_t* data, uint8_t data_size) {
+    uint8_t link_buffer[AHT10_CMD_LINK_SIZE] = {0};
+    esp_err_t result                         = ESP_OK;
+
+    if (data == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (data_size == 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    i2c_cmd_handle_t handle = i2c_cmd_link_create_static(link_buffer, sizeof(link_buffer));
+    if (handle == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
 
-    i2c_master_start(handle);
-    i2c_master_write_byte(handle, (AHT10_SENSOR_ADDR << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(handle, cmd, true);
-    i2c_master_stop(handle);
+    result += i2c_master_start(handle);
+    result += i2c_master_write_byte(handle, (address << 1) | I2C_MASTER_WRITE, true);
+    result += i2c_master_write(handle, data, data_size, true);
+    result += i2c_master_stop(handle);
 
-    esp_err_t result = i2c_master_cmd_begin(I2C_MASTER_NUM, handle, pdMS_TO_TICKS(1000));
-    i2c_cmd_link_delete(handle);
+    if (result == ESP_OK) {
+        result = aht10_i2c_execute(port, handle);
+    }
+    i2c_cmd_link_delete_static(handle);
 
     return result;
 }
 
 /**
- * @brief Sends multiple command bytes to the AHT10 sensor over I2C.
+ * @brief Routes the bus to the multiplexer channel of a sensor.
  *
- * This function is used to send an array of command bytes to the AHT10 sensor to trigger
- * its operation.
+ * When the sensor is behind another multiplexer, or wired directly to the bus,
+ * the previously opened multiplexer is closed first so that sensors sharing an
+ * address never answer at the same time.
  *
- * @param[in] cmds Pointer to an array of command bytes to send to the sensor.
- * @param[in] cmd_size The size of the command array.
+ * @param[in] device Sensor about to be accessed.
  *
- * @return ESP_OK on success, or an error code if the I2C communication fails.
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on an invalid handle, or an
+ *         error code if the I2C communication fails.
  */
-static esp_err_t aht10_send_cmds(uint8_t* cmds, uint8_t cmd_size) {
-    esp_err_t result        = ESP_FAIL;
-    i2c_cmd_handle_t handle = i2c_cmd_link_create();
+static esp_err_t aht10_select_channel(const aht10_device_st* device) {
+    esp_err_t result = ESP_OK;
+
+    if ((device->port < 0) || (device->port >= I2C_NUM_MAX) || (device->mux_channel > TCA9548A_MAX_CHANNEL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t current_mux     = selected_mux[device->port].mux_address;
+    uint8_t current_channel = selected_mux[device->port].mux_channel;
+
+    if ((current_mux == device->mux_address) && ((current_mux == AHT10_NO_MUX) || (current_channel == device->mux_channel))) {
+        return ESP_OK;
+    }
 
     do {
-        if (cmd_size == 0) {
-            result = ESP_ERR_INVALID_SIZE;
-            break;
+        if ((current_mux != AHT10_NO_MUX) && (current_mux != device->mux_address)) {
+            const uint8_t none = 0;
+            result             = aht10_i2c_write(device->port, current_mux, &none, sizeof(none));
+            if (result != ESP_OK) {
+                break;
+            }
+            selected_mux[device->port].mux_address = AHT10_NO_MUX;
         }
 
-        if (cmds == NULL) {
-            result = ESP_ERR_INVALID_ARG;
-            break;
+        if (device->mux_address != AHT10_NO_MUX) {
+            const uint8_t mask = (uint8_t)(1 << device->mux_channel);
+            result             = aht10_i2c_write(device->port, device->mux_address, &mask, sizeof(mask));
+            if (result != ESP_OK) {
+                // The state of the multiplexer is unknown, force a selection next time.
+                selected_mux[device->port].mux_address = AHT10_NO_MUX;
+                break;
+            }
         }
 
-        i2c_master_start(handle);
-        i2c_master_write_byte(handle, (AHT10_SENSOR_ADDR << 1) | I2C_MASTER_WRITE, true);
-        i2c_master_write(handle, cmds, cmd_size, true);
-        i2c_master_stop(handle);
-
-        result = i2c_master_cmd_begin(I2C_MASTER_NUM, handle, pdMS_TO_TICKS(1000));
-        i2c_cmd_link_delete(handle);
+        selected_mux[device->port].mux_address = device->mux_address;
+        selected_mux[device->port].mux_channel = device->mux_channel;
     } while (0);
 
     return result;
 }
 
+/**
+ * @brief Sends multiple command bytes to a sensor over I2C.
+ *
+ * This function is used to send an array of command bytes to the sensor to trigger
+ * its operation. The multiplexer channel of the sensor is selected first.
+ *
+ * @param[in] device Sensor to address.
+ * @param[in] cmds Pointer to an array of command bytes to send to the sensor.
+ * @param[in] cmd_size The size of the command array.
+ *
+ * @return ESP_OK on success, or an error code if the I2C communication fails.
+ */
+static esp_err_t aht10_send_cmds(const aht10_device_st* device, const uint8_t* cmds, uint8_t cmd_size) {
+    esp_err_t result = aht10_select_channel(device);
+    if (result != ESP_OK) {
+        return result;
+    }
+
+    return aht10_i2c_write(device->port, device->address, cmds, cmd_size);
+}
 
 /**
- * @brief Reads data from the AHT10 sensor over I2C.
+ * @brief Reads data from a sensor over I2C.
  *
- * This function reads a specified number of bytes from the AHT10 sensor, which may contain
- * temperature and humidity data or other sensor information.
+ * This function reads a specified number of bytes from the sensor, which may contain
+ * temperature and humidity data or other sensor information. The I2C command link is
+ * built in a buffer on the stack, so no heap allocation takes place.
  *
+ * @param[in] device Sensor to read.
  * @param[out] data Pointer to a buffer where the sensor data will be stored.
  * @param[in] data_size The number of bytes to read from the sensor.
  *
  * @return ESP_OK on success, or an error code if the I2C communication fails.
  */
-static esp_err_t aht10_read_data(uint8_t* data, uint8_t data_size) {
-    esp_err_t result = ESP_FAIL;
+static esp_err_t aht10_read_data(const aht10_device_st* device, uint8_t* data, uint8_t data_size) {
+    uint8_t link_buffer[AHT10_CMD_LINK_SIZE] = {0};
+    esp_err_t result                         = ESP_OK;
+
+    if (data == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (data_size == 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    result = aht10_select_channel(device);
+    if (result != ESP_OK) {
+        return result;
+    }
+
+    i2c_cmd_handle_t handle = i2c_cmd_link_create_static(link_buffer, sizeof(link_buffer));
+    if (handle == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    result += i2c_master_start(handle);
+    result += i2c_master_write_byte(handle, (device->address << 1) | I2C_MASTER_READ, true);
+    result += i2c_master_read(handle, data, data_size, I2C_MASTER_LAST_NACK);
+    result += i2c_master_stop(handle);
+
+    if (result == ESP_OK) {
+        result = aht10_i2c_execute(device->port, handle);
+    }
+    i2c_cmd_link_delete_static(handle);
 
-    do {
-        if (data == NULL) {
-            result = ESP_ERR_INVALID_ARG;
-            break;
-        }
+    return result;
+}
 
-        if (data_size == 0) {
-            result = ESP_ERR_INVALID_SIZE;
-            break;
-        }
+/**
+ * @brief Initializes an I2C bus in master mode.
+ *
+ * This function configures the I2C bus parameters, including the SDA and SCL pins,
+ * clock speed, and pull-up resistors. It also installs the I2C driver for communication.
+ *
+ * @param[in] config Configuration of the bus.
+ *
+ * @return ESP_OK on success, or an error code if the initialization fails.
+ */
+esp_err_t aht10_bus_init(const aht10_bus_config_st* config) {
+    i2c_config_t i2c_config = {};
+    esp_err_t result        = ESP_OK;
 
-        i2c_cmd_handle_t handle = i2c_cmd_link_create();
-        i2c_master_start(handle);
-        i2c_master_write_byte(handle, (AHT10_SENSOR_ADDR << 1) | I2C_MASTER_READ, true);
-        i2c_master_read(handle, data, data_size, I2C_MASTER_LAST_NACK);
-        i2c_master_stop(handle);
-        result = i2c_master_cmd_begin(I2C_MASTER_NUM, handle, pdMS_TO_TICKS(1000));
-        i2c_cmd_link_delete(handle);
+    if ((config == NULL) || (config->port < 0) || (config->port >= I2C_NUM_MAX)) {
+        return ESP_ERR_INVALID_ARG;
+    }
 
-    } while (0);
+    i2c_config.mode             = I2C_MODE_MASTER;
+    i2c_config.sda_io_num       = config->sda_io_num;
+    i2c_config.scl_io_num       = config->scl_io_num;
+    i2c_config.sda_pullup_en    = GPIO_PULLUP_ENABLE;
+    i2c_config.scl_pullup_en    = GPIO_PULLUP_ENABLE;
+    i2c_config.master.clk_speed = config->frequency_hz;
 
-    return result;
+    result = i2c_param_config(config->port, &i2c_config);
+    if (result != ESP_OK) {
+        return result;
+    }
+
+    selected_mux[config->port].mux_address = AHT10_NO_MUX;
+
+    return i2c_driver_install(config->port, i2c_config.mode, I2C_MASTER_TX_BUF_DISABLE, I2C_MASTER_RX_BUF_DISABLE, 0);
 }
 
 /**
- * @brief Initializes the AHT10 sensor by sending the initialization command.
+ * @brief Initializes a sensor.
  *
- * This function triggers the initialization process for the AHT10 sensor by sending
- * the initialization command over I2C.
+ * This function sends the initialization command matching the sensor model.
+ * The bus of the sensor must have been initialized with `aht10_bus_init()`.
+ * Nothing is logged, the caller retrying a missing sensor logs its state.
  *
- * @return ESP_OK on success, ESP_FAIL or other error codes if initialization fails.
+ * @param[in] device Sensor to initialize.
+ *
+ * @return ESP_OK on success, or an error code if the initialization fails.
  */
-esp_err_t aht10_init() {
-    esp_err_t result = ESP_FAIL;
+esp_err_t aht10_init(const aht10_device_st* device) {
+    const uint8_t aht10_cmds[] = {AHT10_CMD_INIT};
+    const uint8_t aht20_cmds[] = {AHT20_CMD_INIT, AHT20_CMD_INIT_CONFIG, AHT10_CMD_RESERVED};
 
-    result = ESP_ERROR_CHECK_WITHOUT_ABORT(aht10_i2c_master_init());
+    if (device == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
 
-    ESP_LOGI(TAG, "Initializing AHT10 sensor...");
-    result = ESP_ERROR_CHECK_WITHOUT_ABORT(aht10_send_cmd(AHT10_CMD_INIT));
+    if (device->model == AHT10_MODEL_AHT20) {
+        return aht10_send_cmds(device, aht20_cmds, sizeof(aht20_cmds));
+    }
 
-    return result;
+    return aht10_send_cmds(device, aht10_cmds, sizeof(aht10_cmds));
 }
 
 /**
- * @brief Retrieves the temperature and humidity data from the AHT10 sensor.
+ * @brief Triggers a new measurement on a sensor.
  *
- * This function sends the trigger command to the AHT10 sensor, waits for the measurement
- * to complete, and reads the temperature and humidity data.
+ * This function only sends the trigger command and returns immediately. The
+ * measurement is complete once `aht10_is_busy()` reports false, after about
+ * `AHT10_CONVERSION_TIME_MS`.
  *
- * @param[out] aht10_data Pointer to a structure where the retrieved sensor data will be stored.
+ * @param[in] device Sensor to trigger.
  *
- * @return ESP_OK on success, or an error code if reading the data fails.
+ * @return ESP_OK on success, or an error code if the I2C communication fails.
  */
-esp_err_t aht10_get_temperature_humidity(aht10_data_st* aht10_data) {
-    esp_err_t result = ESP_FAIL;
-    uint8_t cmds[]   = {AHT10_CMD_TRIGGER, AHT10_CMD_TRIGGER_CONFIG, AHT10_CMD_RESERVED};
-    uint8_t data[6]  = {0};
+esp_err_t aht10_start_measurement(const aht10_device_st* device) {
+    const uint8_t cmds[] = {AHT10_CMD_TRIGGER, AHT10_CMD_TRIGGER_CONFIG, AHT10_CMD_RESERVED};
 
-    do {
-        if (aht10_data == NULL) {
-            result = ESP_ERR_INVALID_ARG;
-            break;
-        }
+    if (device == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
 
-        result = ESP_ERROR_CHECK_WITHOUT_ABORT(aht10_send_cmds(cmds, sizeof(cmds)));
+    return aht10_send_cmds(device, cmds, sizeof(cmds));
+}
 
-        vTaskDelay(pdMS_TO_TICKS(100));
+/**
+ * @brief Checks whether a sensor is still running a measurement.
+ *
+ * This function reads the status byte of the sensor and checks its busy bit.
+ *
+ * @param[in]  device  Sensor to check.
+ * @param[out] is_busy Set to true while the measurement is in progress.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on NULL parameters, or an
+ *         error code if the I2C communication fails.
+ */
+esp_err_t aht10_is_busy(const aht10_device_st* device, bool* is_busy) {
+    uint8_t status = 0;
 
-        if (result != ESP_OK) {
-            break;
-        }
-        result = ESP_ERROR_CHECK_WITHOUT_ABORT(aht10_read_data(data, sizeof(data)));
+    if ((device == NULL) || (is_busy == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
 
-        if (result != ESP_OK) {
-            break;
-        }
+    esp_err_t result = aht10_read_data(device, &status, sizeof(status));
+    if (result == ESP_OK) {
+        *is_busy = (status & AHT10_STATUS_BUSY) != 0;
+    }
 
-        aht10_data->raw_humidity    = ((uint32_t)data[1] << 12) | ((uint32_t)data[2] << 4) | (data[3] >> 4);
-        aht10_data->raw_temperature = (((uint32_t)data[3] & 0x0F) << 16) | ((uint32_t)data[4] << 8) | data[5];
+    return result;
+}
 
-    } while (0);
+/**
+ * @brief Fetches the result of the last measurement from a sensor.
+ *
+ * @param[in]  device     Sensor to read.
+ * @param[out] aht10_data Pointer to a structure where the retrieved sensor data will be stored.
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_FINISHED if the measurement is still in
+ *         progress, ESP_ERR_INVALID_ARG on NULL parameters, or an error code if
+ *         the I2C communication fails.
+ */
+esp_err_t aht10_fetch_measurement(const aht10_device_st* device, aht10_data_st* aht10_data) {
+    uint8_t data[6] = {0};
 
-    return result;
+    if ((device == NULL) || (aht10_data == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t result = aht10_read_data(device, data, sizeof(data));
+    if (result != ESP_OK) {
+        return result;
+    }
+
+    if (data[0] & AHT10_STATUS_BUSY) {
+        return ESP_ERR_NOT_FINISHED;
+    }
+
+    aht10_data->raw_humidity    = ((uint32_t)data[1] << 12) | ((uint32_t)data[2] << 4) | (data[3] >> 4);
+    aht10_data->raw_temperature = (((uint32_t)data[3] & 0x0F) << 16) | ((uint32_t)data[4] << 8) | data[5];
+
+    return ESP_OK;
 }
@@ -1,16 +1,55 @@
 #ifndef AHT10_H
 #define AHT10_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "driver/i2c.h"
 #include "esp_err.h"
 
 /**
  * @file aht10.h
  * @brief Interface for interacting with the AHT10 temperature and humidity sensor.
  *
- * This module provides functions to initialize the AHT10 sensor and retrieve
+ * This module provides functions to initialize AHT10/AHT20 sensors and retrieve
  * temperature and humidity data. It uses I2C communication to interface with
- * the sensor.
+ * the sensors. Each sensor is described by a device handle, so several sensors
+ * can share a bus, sit on both I2C ports, or be reached through a TCA9548A
+ * I2C multiplexer.
+ */
+
+#define AHT10_CONVERSION_TIME_MS 75  ///< Typical duration of a measurement, in milliseconds.
+#define AHT10_DEFAULT_ADDR 0x38      ///< Default I2C address of AHT10 and AHT20 sensors.
+#define AHT10_NO_MUX 0x00            ///< Multiplexer address of a sensor wired directly to the bus.
+
+/**
+ * @brief Sensor models handled by the driver.
+ */
+typedef enum aht10_model_t {
+    AHT10_MODEL_AHT10 = 0,  ///< AHT10 sensor.
+    AHT10_MODEL_AHT20,      ///< AHT20 sensor, which uses a different initialization command.
+} aht10_model_e;
+
+/**
+ * @brief Configuration of an I2C bus hosting sensors.
  */
+typedef struct aht10_bus_config_s {
+    i2c_port_t port;        ///< I2C port number.
+    int sda_io_num;         ///< GPIO pin for I2C SDA.
+    int scl_io_num;         ///< GPIO pin for I2C SCL.
+    uint32_t frequency_hz;  ///< I2C clock frequency.
+} aht10_bus_config_st;
+
+/**
+ * @brief Handle describing how to reach one sensor.
+ */
+typedef struct aht10_device_s {
+    i2c_port_t port;      ///< I2C port the sensor is wired to.
+    uint8_t address;      ///< I2C address of the sensor.
+    aht10_model_e model;  ///< Sensor model.
+    uint8_t mux_address;  ///< I2C address of the TCA9548A in front of the sensor, or `AHT10_NO_MUX`.
+    uint8_t mux_channel;  ///< Multiplexer channel of the sensor (0 to 7).
+} aht10_device_st;
 
 /**
  * @brief Struct representing raw temperature and humidity data from the AHT10 sensor.
@@ -24,26 +63,65 @@ typedef struct aht10_data_t {
 } aht10_data_st;
 
 /**
- * @brief Initializes the AHT10 sensor.
+ * @brief Initializes an I2C bus in master mode.
+ *
+ * This function configures the I2C bus parameters, including the SDA and SCL pins,
+ * clock speed, and pull-up resistors. It also installs the I2C driver for communication.
+ *
+ * @param[in] config Configuration of the bus.
+ *
+ * @return ESP_OK on success, or an error code if the initialization fails.
+ */
+esp_err_t aht10_bus_init(const aht10_bus_config_st* config);
+
+/**
+ * @brief Initializes a sensor.
+ *
+ * This function sends the initialization command matching the sensor model.
+ * The bus of the sensor must have been initialized with `aht10_bus_init()`.
  *
- * This function initializes the AHT10 sensor by configuring the necessary I2C
- * communication and sending the required initialization commands to the sensor.
+ * @param[in] device Sensor to initialize.
  *
  * @return ESP_OK on success, or an error code if the initialization fails.
  */
-esp_err_t aht10_init();
+esp_err_t aht10_init(const aht10_device_st* device);
 
 /**
- * @brief Retrieves temperature and humidity data from the AHT10 sensor.
+ * @brief Triggers a new measurement on a sensor.
  *
- * This function triggers a measurement on the AHT10 sensor and retrieves the
- * raw temperature and humidity data. The retrieved data is stored in the
- * provided `aht10_data` structure.
+ * This function only sends the trigger command and returns immediately. The
+ * measurement is complete once `aht10_is_busy()` reports false, after about
+ * `AHT10_CONVERSION_TIME_MS`.
+ *
+ * @param[in] device Sensor to trigger.
+ *
+ * @return ESP_OK on success, or an error code if the I2C communication fails.
+ */
+esp_err_t aht10_start_measurement(const aht10_device_st* device);
+
+/**
+ * @brief Checks whether a sensor is still running a measurement.
+ *
+ * This function reads the status byte of the sensor and checks its busy bit.
+ *
+ * @param[in]  device  Sensor to check.
+ * @param[out] is_busy Set to true while the measurement is in progress.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on NULL parameters, or an
+ *         error code if the I2C communication fails.
+ */
+esp_err_t aht10_is_busy(const aht10_device_st* device, bool* is_busy);
+
+/**
+ * @brief Fetches the result of the last measurement from a sensor.
  *
+ * @param[in]  device     Sensor to read.
  * @param[out] aht10_data Pointer to a structure where the retrieved sensor data will be stored.
  *
- * @return ESP_OK on success, or an error code if the data retrieval fails.
+ * @return ESP_OK on success, ESP_ERR_NOT_FINISHED if the measurement is still in
+ *         progress, ESP_ERR_INVALID_ARG on NULL parameters, or an error code if
+ *         the I2C communication fails.
  */
-esp_err_t aht10_get_temperature_humidity(aht10_data_st* aht10_data);
+esp_err_t aht10_fetch_measurement(const aht10_device_st* device, aht10_data_st* aht10_data);
 
 #endif  // AHT10_H
@@ -0,0 +1,34 @@
+/**
+ * @file aht10_conversion.c
+ * @brief Fixed-point conversions of the raw AHT10/AHT20 measurements.
+ */
+
+#include "aht10_conversion.h"
+
+/**
+ * @brief Converts a raw temperature to centi-degrees Celsius.
+ *
+ * T = raw / 2^20 * 200 - 50 degrees, i.e. raw * 625 / 2^15 - 5000 hundredths,
+ * rounded to nearest. The product fits 32 bits for every 20-bit reading.
+ *
+ * @param[in] raw Raw 20-bit temperature from the sensor.
+ *
+ * @return Temperature, in centi-degrees Celsius.
+ */
+int16_t aht10_to_centi_celsius(uint32_t raw) {
+    return (int16_t)((int32_t)(((raw * 625) + (1UL << 14)) >> 15) - 5000);
+}
+
+/**
+ * @brief Converts a raw relative humidity to centi-percent.
+ *
+ * RH = raw / 2^20 * 100 percent, i.e. raw * 625 / 2^16 hundredths, rounded
+ * to nearest.
+ *
+ * @param[in] raw Raw 20-bit relative humidity from the sensor.
+ *
+ * @return Relative humidity, in centi-percent.
+ */
+uint16_t aht10_to_centi_percent(uint32_t raw) {
+    return (uint16_t)(((raw * 625) + (1UL << 15)) >> 16);
+}
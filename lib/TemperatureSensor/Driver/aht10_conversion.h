@@ -0,0 +1,40 @@
+#ifndef AHT10_CONVERSION_H
+#define AHT10_CONVERSION_H
+
+#include <stdint.h>
+
+/**
+ * @file aht10_conversion.h
+ * @brief Fixed-point conversions of the raw AHT10/AHT20 measurements.
+ *
+ * Raw counts are converted to centi-degrees Celsius and centi-percent with
+ * integer multiplications and shifts, so the per-reading path never touches
+ * floating point. The conversions do not depend on the I2C driver and are
+ * unit tested on the host.
+ */
+
+/**
+ * @brief Converts a raw temperature to centi-degrees Celsius.
+ *
+ * T = raw / 2^20 * 200 - 50 degrees, i.e. raw * 625 / 2^15 - 5000 hundredths,
+ * rounded to nearest. The product fits 32 bits for every 20-bit reading.
+ *
+ * @param[in] raw Raw 20-bit temperature from the sensor.
+ *
+ * @return Temperature, in centi-degrees Celsius.
+ */
+int16_t aht10_to_centi_celsius(uint32_t raw);
+
+/**
+ * @brief Converts a raw relative humidity to centi-percent.
+ *
+ * RH = raw / 2^20 * 100 percent, i.e. raw * 625 / 2^16 hundredths, rounded
+ * to nearest.
+ *
+ * @param[in] raw Raw 20-bit relative humidity from the sensor.
+ *
+ * @return Relative humidity, in centi-percent.
+ */
+uint16_t aht10_to_centi_percent(uint32_t raw);
+
+#endif  // AHT10_CONVERSION_H
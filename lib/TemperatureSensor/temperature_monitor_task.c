@@ -1,64 +1,579 @@
 #include "temperature_monitor_task.h"
 #include "Driver/aht10.h"
+#include "Driver/aht10_conversion.h"
+#include "deferred_log.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "events_definition.h"
+#include "metrics.h"
 
 #include "esp_err.h"
 
+#include <math.h>
+#include <stdatomic.h>
+
 /**
  * @file temperature_monitor.c
  * @brief Temperature monitoring and logging for temperature and humidity data.
  *
- * This module interfaces with the AHT10 temperature and humidity sensor,
- * reads the data, and logs the temperature and humidity values periodically.
- * It provides functions to initialize the sensor, execute continuous readings,
- * and log the results.
+ * This module interfaces with the AHT10/AHT20 temperature and humidity sensors
+ * listed in `SENSORS`, reads the data, and queues the temperature and humidity
+ * values periodically. Each sweep triggers every sensor first and reads them
+ * all afterwards, so the conversion times overlap and a sweep costs about one
+ * conversion time whatever the number of sensors.
+ *
+ * Raw counts are converted to centi-degrees Celsius and centi-percent by
+ * `aht10_conversion.h` with integer multiplications and shifts, so the
+ * per-reading path never touches floating point. Readings are not forwarded
+ * one by one: each sensor accumulates integer running sums over an
+ * aggregation window, and a single sample holding the mean, minimum, maximum
+ * and standard deviation is queued when the window closes. The sums are
+ * exact, so they do not lose precision like a naive floating point variance
+ * would. This keeps constant memory per sensor whatever the window length
+ * and lets the sensors be sampled fast without flooding the broker.
+ *
+ * The latest reading of each sensor is also published in a sequence-locked
+ * slot, for consumers such as the live WebSocket stream that need the current
+ * value with low latency rather than every aggregate.
+ */
+
+#define SENSOR_COUNT (sizeof(SENSORS) / sizeof(SENSORS[0]))  ///< Number of sensors monitored.
+#define SENSOR_RING_CAPACITY 128                              ///< Number of samples the ring can hold, a power of two.
+
+/**
+ * @brief I2C buses hosting sensors.
+ */
+static const aht10_bus_config_st BUSES[] = {
+    {.port = I2C_NUM_0, .sda_io_num = GPIO_NUM_21, .scl_io_num = GPIO_NUM_22, .frequency_hz = 100000},
+};
+
+/**
+ * @brief Sensors monitored, the index of a sensor in this table is its identifier.
+ *
+ * Up to 8 sensors sharing the default address can be reached through a
+ * TCA9548A, e.g. `{.port = I2C_NUM_0, .address = AHT10_DEFAULT_ADDR,
+ * .model = AHT10_MODEL_AHT20, .mux_address = 0x70, .mux_channel = 3}`. Sensors
+ * on the second I2C port also need an entry in `BUSES`.
+ */
+static const aht10_device_st SENSORS[] = {
+    {.port = I2C_NUM_0, .address = AHT10_DEFAULT_ADDR, .model = AHT10_MODEL_AHT10, .mux_address = AHT10_NO_MUX, .mux_channel = 0},
+};
+
+/**
+ * @brief Running statistics of one measured quantity.
+ */
+typedef struct aggregate_channel_s {
+    int32_t sum;           ///< Sum of the readings so far.
+    uint64_t sum_squares;  ///< Sum of the squared readings so far.
+    int32_t min;           ///< Lowest reading so far.
+    int32_t max;           ///< Highest reading so far.
+} aggregate_channel_st;
+
+/**
+ * @brief Aggregation window of one sensor.
+ */
+typedef struct sensor_aggregate_s {
+    uint16_t count;                    ///< Number of readings in the window.
+    uint32_t sequence;                 ///< Number of windows of the sensor closed so far.
+    int64_t last_reading_us;           ///< Uptime of the last reading in the window, in microseconds.
+    aggregate_channel_st temperature;  ///< Temperature statistics, in centi-degrees Celsius.
+    aggregate_channel_st humidity;     ///< Humidity statistics, in centi-percent.
+} sensor_aggregate_st;
+
+/**
+ * @brief Latest reading of one sensor, guarded by a sequence lock.
+ *
+ * The sequence is odd while the monitor updates the sample; readers retry
+ * until they copy the sample with the same even sequence before and after.
+ */
+typedef struct live_slot_s {
+    atomic_uint sequence;        ///< Update counter, odd during an update.
+    temperature_data_st sample;  ///< Latest reading.
+} live_slot_st;
+
+static bool is_sensor_ready[SENSOR_COUNT]                  = {0};  ///< Whether each sensor answered its initialization.
+static bool is_sensor_triggered[SENSOR_COUNT]              = {0};  ///< Whether each sensor was triggered in the current sweep.
+static uint16_t retry_backoff[SENSOR_COUNT]                = {0};  ///< Sweeps between two initializations of each missing sensor, 0 until it fails.
+static uint16_t retry_delay[SENSOR_COUNT]                  = {0};  ///< Sweeps left before the next initialization of each missing sensor.
+static sensor_aggregate_st sensor_aggregates[SENSOR_COUNT] = {0};  ///< Aggregation window of each sensor.
+static live_slot_st live_slots[SENSOR_COUNT]               = {0};  ///< Latest reading of each sensor.
+static atomic_uint sample_period_ms                        = 0;    ///< Sample period set at runtime, 0 for `SAMPLE_PERIOD_MS`.
+static atomic_uint window_period_ms                        = 0;    ///< Window length set at runtime, 0 for `WINDOW_PERIOD_MS`.
+
+static const char* TAG                 = "Temperature Monitor Task";  ///< Tag used for logging.
+static const uint32_t SAMPLE_PERIOD_MS = 250;                         ///< Period between two sweeps, in milliseconds.
+static const uint32_t WINDOW_PERIOD_MS = 30000;                       ///< Default length of an aggregation window, in milliseconds.
+static const uint32_t POLL_INTERVAL_MS = 10;                          ///< Interval between two reads of a busy sensor, one tick at 100 Hz.
+static const uint32_t SWEEP_TIMEOUT_MS = 200;                         ///< Longest time a sweep waits for the conversions, in milliseconds.
+static const uint16_t MAX_RETRY_SWEEPS = 240;                         ///< Longest wait between two initializations of a missing sensor, in sweeps.
+
+static temperature_data_st sensor_ring_storage[SENSOR_RING_CAPACITY] = {0};  ///< Storage of the sample ring.
+
+_Static_assert((SENSOR_RING_CAPACITY & (SENSOR_RING_CAPACITY - 1)) == 0, "Ring capacity must be a power of two");
+
+spsc_ring_st sensor_data_ring = SPSC_RING_STATIC_INIT(sensor_ring_storage, SENSOR_RING_CAPACITY);
+
+/**
+ * @brief Event group for signaling system status and events.
+ *
+ * This event group is used to communicate various system events and states between
+ * different tasks. The temperature monitor sets `SENSOR_DATA_READY` whenever a new
+ * sample is queued so the consumers can sleep until data is available.
  */
+static EventGroupHandle_t* firmware_event_group = NULL;
 
-static aht10_data_st aht10_data             = {0};                         ///< Structure to hold the temperature and humidity data.
-static temperature_data_st temperature_data = {0};                         ///< Structure to hold the temperature and humidity data for external use.
-static const char* TAG                      = "Temperature Monitor Task";  ///< Tag used for logging.
+/**
+ * @brief Records the outcome of an initialization or a trigger of a sensor.
+ *
+ * Only changes of state are logged, so a missing sensor does not flood the
+ * deferred log. Every failure in a row doubles the number of sweeps skipped
+ * before the next initialization, up to `MAX_RETRY_SWEEPS`.
+ *
+ * @param[in] sensor_id Identifier of the sensor.
+ * @param[in] result    Result of the initialization or of the trigger.
+ */
+static void temperature_monitor_set_sensor_state(size_t sensor_id, esp_err_t result) {
+    bool was_ready = is_sensor_ready[sensor_id];
 
-QueueHandle_t sensor_data_queue = NULL;
+    is_sensor_ready[sensor_id] = (result == ESP_OK);
+
+    if (result == ESP_OK) {
+        if (!was_ready) {
+            DEFERRED_LOGI(TAG, "Sensor %u ready", (unsigned)sensor_id);
+        }
+        retry_backoff[sensor_id] = 0;
+        return;
+    }
+
+    if (retry_backoff[sensor_id] == 0) {
+        DEFERRED_LOGW(TAG, "Sensor %u not responding: %s, retrying", (unsigned)sensor_id, esp_err_to_name(result));
+    }
+    retry_backoff[sensor_id] = (retry_backoff[sensor_id] == 0) ? 1 : retry_backoff[sensor_id] * 2;
+    if (retry_backoff[sensor_id] > MAX_RETRY_SWEEPS) {
+        retry_backoff[sensor_id] = MAX_RETRY_SWEEPS;
+    }
+    retry_delay[sensor_id] = retry_backoff[sensor_id];
+}
 
 /**
  * @brief Initializes the temperature monitor.
  *
- * This function calls the `aht10_init` function to initialize the AHT10
- * temperature and humidity sensor. If initialization fails, the task
- * will be deleted.
+ * This function initializes the I2C buses and every sensor of `SENSORS`. A
+ * sensor failing to initialize is retried on later sweeps, less and less
+ * often while it stays missing. If no bus can be initialized, the task will
+ * be deleted.
  *
  * @return ESP_OK on successful initialization, ESP_FAIL on failure.
  */
 static esp_err_t temperature_monitor_task_initialize(void) {
-    sensor_data_queue = xQueueCreate(100, sizeof(temperature_data_st));
-    return aht10_init();
+    size_t bus_count = 0;
+
+    for (size_t i = 0; i < sizeof(BUSES) / sizeof(BUSES[0]); i++) {
+        if (ESP_ERROR_CHECK_WITHOUT_ABORT(aht10_bus_init(&BUSES[i])) == ESP_OK) {
+            bus_count++;
+        }
+    }
+
+    for (size_t i = 0; i < SENSOR_COUNT; i++) {
+        temperature_monitor_set_sensor_state(i, aht10_init(&SENSORS[i]));
+    }
+
+    return (bus_count > 0) ? ESP_OK : ESP_FAIL;
+}
+
+/**
+ * @brief Triggers a measurement on every sensor.
+ *
+ * Sensors that failed to initialize are initialized again instead once their
+ * retry delay has elapsed, and will be measured from the next sweep on.
+ *
+ * @return Number of sensors triggered.
+ */
+static size_t temperature_monitor_trigger_all(void) {
+    size_t triggered = 0;
+
+    for (size_t i = 0; i < SENSOR_COUNT; i++) {
+        is_sensor_triggered[i] = false;
+
+        if (!is_sensor_ready[i]) {
+            if (retry_delay[i] > 0) {
+                retry_delay[i]--;
+            } else {
+                temperature_monitor_set_sensor_state(i, aht10_init(&SENSORS[i]));
+            }
+            continue;
+        }
+
+        esp_err_t result = aht10_start_measurement(&SENSORS[i]);
+        temperature_monitor_set_sensor_state(i, result);
+        if (result == ESP_OK) {
+            is_sensor_triggered[i] = true;
+            triggered++;
+        }
+    }
+
+    return triggered;
+}
+
+/**
+ * @brief Adds a reading to running statistics.
+ *
+ * @param[in,out] channel Statistics to update.
+ * @param[in]     count   Number of readings including this one.
+ * @param[in]     value   New reading.
+ */
+static void aggregate_channel_add(aggregate_channel_st* channel, uint16_t count, int32_t value) {
+    uint64_t square = (uint64_t)((int64_t)value * value);
+
+    if (count == 1) {
+        channel->sum         = value;
+        channel->sum_squares = square;
+        channel->min         = value;
+        channel->max         = value;
+        return;
+    }
+
+    channel->sum         += value;
+    channel->sum_squares += square;
+    channel->min          = (value < channel->min) ? value : channel->min;
+    channel->max          = (value > channel->max) ? value : channel->max;
+}
+
+/**
+ * @brief Computes the mean of running statistics, rounded to nearest.
+ *
+ * @param[in] channel Statistics of the window.
+ * @param[in] count   Number of readings in the window, not 0.
+ *
+ * @return Mean of the readings.
+ */
+static int32_t aggregate_channel_mean(const aggregate_channel_st* channel, uint16_t count) {
+    int32_t half = (channel->sum >= 0) ? (count / 2) : -(count / 2);
+
+    return (channel->sum + half) / count;
+}
+
+/**
+ * @brief Computes the population standard deviation of running statistics.
+ *
+ * The variance is exact in integers, only the square root, taken once per
+ * window, uses the single precision FPU.
+ *
+ * @param[in] channel Statistics of the window.
+ * @param[in] count   Number of readings in the window, not 0.
+ *
+ * @return Standard deviation of the readings, rounded to nearest.
+ */
+static uint16_t aggregate_channel_stddev(const aggregate_channel_st* channel, uint16_t count) {
+    // count^2 * variance = count * sum(x^2) - sum(x)^2, at most about 1e18 for a full window.
+    int64_t scaled_variance = ((int64_t)count * (int64_t)channel->sum_squares) - ((int64_t)channel->sum * channel->sum);
+    if (scaled_variance <= 0) {
+        return 0;
+    }
+
+    return (uint16_t)((sqrtf((float)scaled_variance) / count) + 0.5f);
+}
+
+/**
+ * @brief Publishes the latest reading of a sensor.
+ *
+ * @param[in] sensor_id    Identifier of the sensor.
+ * @param[in] timestamp_us Uptime of the reading, in microseconds.
+ * @param[in] temperature  Reading, in centi-degrees Celsius.
+ * @param[in] humidity     Reading, in centi-percent.
+ */
+static void temperature_monitor_publish_live(uint8_t sensor_id, int64_t timestamp_us, int16_t temperature, uint16_t humidity) {
+    live_slot_st* slot = &live_slots[sensor_id];
+    unsigned sequence  = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+
+    atomic_store_explicit(&slot->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    slot->sample.sensor_id          = sensor_id;
+    slot->sample.timestamp_us       = timestamp_us;
+    slot->sample.sequence           = sequence / 2;
+    slot->sample.sample_count       = 1;
+    slot->sample.temperature        = temperature;
+    slot->sample.temperature_min    = temperature;
+    slot->sample.temperature_max    = temperature;
+    slot->sample.temperature_stddev = 0;
+    slot->sample.humidity           = humidity;
+    slot->sample.humidity_min       = humidity;
+    slot->sample.humidity_max       = humidity;
+    slot->sample.humidity_stddev    = 0;
+
+    atomic_store_explicit(&slot->sequence, sequence + 2, memory_order_release);
+}
+
+/**
+ * @brief Converts a measurement and adds it to the window of its sensor.
+ *
+ * @param[in] sensor_id  Identifier of the sensor that took the measurement.
+ * @param[in] aht10_data Raw measurement.
+ */
+static void temperature_monitor_add_reading(uint8_t sensor_id, const aht10_data_st* aht10_data) {
+    sensor_aggregate_st* aggregate = &sensor_aggregates[sensor_id];
+    uint16_t humidity              = aht10_to_centi_percent(aht10_data->raw_humidity);
+    int16_t temperature            = aht10_to_centi_celsius(aht10_data->raw_temperature);
+    int64_t timestamp_us           = esp_timer_get_time();
+
+    temperature_monitor_publish_live(sensor_id, timestamp_us, temperature, humidity);
+
+    if (aggregate->count == UINT16_MAX) {
+        return;
+    }
+
+    aggregate->count++;
+    aggregate->last_reading_us = timestamp_us;
+    aggregate_channel_add(&aggregate->temperature, aggregate->count, temperature);
+    aggregate_channel_add(&aggregate->humidity, aggregate->count, humidity);
+}
+
+/**
+ * @brief Closes the window of every sensor and queues the aggregates for the consumers.
+ *
+ * Sensors without any reading in the window are skipped.
+ */
+static void temperature_monitor_flush_windows(void) {
+    temperature_data_st temperature_data = {0};
+    bool is_queued                       = false;
+
+    for (size_t i = 0; i < SENSOR_COUNT; i++) {
+        sensor_aggregate_st* aggregate = &sensor_aggregates[i];
+        if (aggregate->count == 0) {
+            continue;
+        }
+
+        temperature_data.sensor_id          = (uint8_t)i;
+        temperature_data.timestamp_us       = aggregate->last_reading_us;
+        temperature_data.sequence           = aggregate->sequence++;
+        temperature_data.sample_count       = aggregate->count;
+        temperature_data.temperature        = (int16_t)aggregate_channel_mean(&aggregate->temperature, aggregate->count);
+        temperature_data.temperature_min    = (int16_t)aggregate->temperature.min;
+        temperature_data.temperature_max    = (int16_t)aggregate->temperature.max;
+        temperature_data.temperature_stddev = aggregate_channel_stddev(&aggregate->temperature, aggregate->count);
+        temperature_data.humidity           = (uint16_t)aggregate_channel_mean(&aggregate->humidity, aggregate->count);
+        temperature_data.humidity_min       = (uint16_t)aggregate->humidity.min;
+        temperature_data.humidity_max       = (uint16_t)aggregate->humidity.max;
+        temperature_data.humidity_stddev    = aggregate_channel_stddev(&aggregate->humidity, aggregate->count);
+        aggregate->count                    = 0;
+
+        if (spsc_ring_push(&sensor_data_ring, &temperature_data)) {
+            is_queued = true;
+        } else {
+            metrics_counter_add(METRICS_COUNTER_SAMPLES_DROPPED, 1);
+            DEFERRED_LOGW(TAG, "Sample ring full, dropping sample of sensor %u", (unsigned)i);
+        }
+    }
+
+    if (is_queued) {
+        xEventGroupSetBits(*firmware_event_group, SENSOR_DATA_READY);
+    }
+}
+
+/**
+ * @brief Reads every sensor triggered by `temperature_monitor_trigger_all()`.
+ *
+ * Sensors still converting are polled until the sweep timeout, so a slow or
+ * missing sensor delays the sweep by at most `SWEEP_TIMEOUT_MS`.
+ *
+ * @param[in] triggered Number of sensors triggered.
+ */
+static void temperature_monitor_read_all(size_t triggered) {
+    aht10_data_st aht10_data = {0};
+    uint32_t waited_ms       = AHT10_CONVERSION_TIME_MS;
+
+    while (triggered > 0) {
+        for (size_t i = 0; i < SENSOR_COUNT; i++) {
+            if (!is_sensor_triggered[i]) {
+                continue;
+            }
+
+            esp_err_t result = aht10_fetch_measurement(&SENSORS[i], &aht10_data);
+            if (result == ESP_ERR_NOT_FINISHED) {
+                continue;
+            }
+
+            if (result == ESP_OK) {
+                temperature_monitor_add_reading((uint8_t)i, &aht10_data);
+            } else {
+                metrics_counter_add(METRICS_COUNTER_SENSOR_READ_ERRORS, 1);
+                DEFERRED_LOGE(TAG, "Failed to read sensor %u: %s", (unsigned)i, esp_err_to_name(result));
+            }
+            is_sensor_triggered[i] = false;
+            triggered--;
+        }
+
+        if (triggered == 0) {
+            break;
+        }
+
+        if (waited_ms >= SWEEP_TIMEOUT_MS) {
+            DEFERRED_LOGW(TAG, "%u sensor(s) did not complete the measurement in time", (unsigned)triggered);
+            break;
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(POLL_INTERVAL_MS));
+        waited_ms += POLL_INTERVAL_MS;
+    }
+}
+
+/**
+ * @brief Get the latest reading of a sensor.
+ *
+ * Readings are published after every sweep, before aggregation, for consumers
+ * that only care about the current value. The returned sample covers a single
+ * reading. Safe to call from any task; a reader never blocks the monitor.
+ *
+ * @param[in]  sensor_id Identifier of the sensor.
+ * @param[out] sample    Latest reading of the sensor.
+ * @param[out] sequence  Number of readings published for this sensor so far,
+ *                       which changes whenever a new reading is available.
+ *
+ * @return true if the sensor exists and has published a reading.
+ */
+bool temperature_monitor_get_latest(uint8_t sensor_id, temperature_data_st* sample, uint32_t* sequence) {
+    if ((sensor_id >= SENSOR_COUNT) || (sample == NULL) || (sequence == NULL)) {
+        return false;
+    }
+
+    live_slot_st* slot = &live_slots[sensor_id];
+    unsigned before    = 0;
+    unsigned after     = 0;
+
+    do {
+        before = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        *sample = slot->sample;
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+    } while ((before & 1) || (before != after));
+
+    *sequence = before / 2;
+
+    return before != 0;
+}
+
+/**
+ * @brief Take a single reading of every sensor, without the monitor task.
+ *
+ * Initializes the buses and the sensors, runs one sweep and returns the
+ * reading of every sensor that answered, as samples of a single reading
+ * stamped with the uptime. Meant for a short wake from deep sleep: must be
+ * called at most once per boot, and never while the monitor task runs.
+ *
+ * @param[out] samples Buffer receiving one sample per sensor read.
+ * @param[in]  size    Number of samples the buffer can hold.
+ * @param[out] count   Number of samples written.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid parameters, or
+ *         ESP_FAIL if no bus could be initialized.
+ */
+esp_err_t temperature_monitor_read_once(temperature_data_st* samples, size_t size, size_t* count) {
+    uint32_t sequence = 0;
+
+    if ((samples == NULL) || (count == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *count = 0;
+
+    if (temperature_monitor_task_initialize() != ESP_OK) {
+        return ESP_FAIL;
+    }
+
+    size_t triggered = temperature_monitor_trigger_all();
+    if (triggered > 0) {
+        vTaskDelay(pdMS_TO_TICKS(AHT10_CONVERSION_TIME_MS));
+        temperature_monitor_read_all(triggered);
+    }
+
+    // Readings are published to the live slots before aggregation.
+    for (uint8_t i = 0; (i < SENSOR_COUNT) && (*count < size); i++) {
+        if (temperature_monitor_get_latest(i, &samples[*count], &sequence)) {
+            (*count)++;
+        }
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Set the period between two sweeps of the sensors.
+ *
+ * Takes effect from the next sweep. Safe to call from any task.
+ *
+ * @param[in] period_ms Sample period, in milliseconds, 0 for the default `SAMPLE_PERIOD_MS`.
+ */
+void temperature_monitor_set_sample_period(uint32_t period_ms) {
+    atomic_store(&sample_period_ms, period_ms);
+}
+
+/**
+ * @brief Set the length of the aggregation windows.
+ *
+ * Takes effect when the current window closes. A window holds at most
+ * `UINT16_MAX` readings, later readings of a longer window are dropped. Safe
+ * to call from any task.
+ *
+ * @param[in] period_ms Window length, in milliseconds, 0 for the default `WINDOW_PERIOD_MS`.
+ */
+void temperature_monitor_set_window_period(uint32_t period_ms) {
+    atomic_store(&window_period_ms, period_ms);
+}
+
+/**
+ * @brief Get the number of sensors handled by the temperature monitor.
+ *
+ * @return Number of sensors, identifiers run from 0 to this value minus one.
+ */
+uint8_t temperature_monitor_get_sensor_count(void) {
+    return (uint8_t)SENSOR_COUNT;
 }
 
 /**
  * @brief Main execution function for the temperature monitor.
  *
  * This function is responsible for executing the temperature monitor's tasks.
- * It continuously monitors the sensor and performs any required actions
+ * It continuously monitors the sensors and performs any required actions
  * such as reading the sensor data, logging the results, or triggering
  * events based on specific conditions.
  *
- * @param[in] pvParameters Pointer to task parameters (TaskHandle_t).
+ * @param[in] pvParameters Pointer to the firmware event group handle.
  */
 void temperature_monitor_task_execute(void* pvParameters) {
-    if (temperature_monitor_task_initialize() != ESP_OK) {
+    firmware_event_group = (EventGroupHandle_t*)pvParameters;
+    if ((firmware_event_group == NULL) || (temperature_monitor_task_initialize() != ESP_OK)) {
         vTaskDelete(NULL);
     }
 
-    while (1) {
-        aht10_get_temperature_humidity(&aht10_data);
+    metrics_register_task();
+
+    TickType_t last_wake_time    = xTaskGetTickCount();
+    TickType_t window_start_time = last_wake_time;
 
-        temperature_data.humidity    = ((float)aht10_data.raw_humidity / 1048576.0) * 100.0;
-        temperature_data.temperature = ((float)aht10_data.raw_temperature / 1048576.0) * 200.0 - 50.0;
+    while (1) {
+        size_t triggered = temperature_monitor_trigger_all();
+        if (triggered > 0) {
+            vTaskDelay(pdMS_TO_TICKS(AHT10_CONVERSION_TIME_MS));
+            temperature_monitor_read_all(triggered);
+            xEventGroupSetBits(*firmware_event_group, LIVE_DATA_READY);
+        }
 
-        if (xQueueSend(sensor_data_queue, &temperature_data, pdMS_TO_TICKS(100)) != pdPASS) {
-            ESP_LOGW(TAG, "Failed to send data to queue");
+        uint32_t window_ms      = atomic_load(&window_period_ms);
+        TickType_t window_ticks = pdMS_TO_TICKS((window_ms != 0) ? window_ms : WINDOW_PERIOD_MS);
+        if ((xTaskGetTickCount() - window_start_time) >= window_ticks) {
+            temperature_monitor_flush_windows();
+            window_start_time += window_ticks;
+            // After the window was shortened the start lags by several windows, restart from now.
+            if ((xTaskGetTickCount() - window_start_time) >= window_ticks) {
+                window_start_time = xTaskGetTickCount();
+            }
         }
 
-        vTaskDelay(pdMS_TO_TICKS(1500));
+        // Keep a fixed cadence regardless of how long the sweep took.
+        uint32_t period_ms = atomic_load(&sample_period_ms);
+        xTaskDelayUntil(&last_wake_time, pdMS_TO_TICKS((period_ms != 0) ? period_ms : SAMPLE_PERIOD_MS));
     }
 }
@@ -3,29 +3,45 @@
 
 #include "esp_err.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/queue.h"
 #include "freertos/task.h"
+#include "spsc_ring.h"
 
 /**
- * @brief External handle for the sensor data queue.
+ * @brief Ring carrying the samples from the temperature monitor to the MQTT task.
  *
- * This queue is used to store and retrieve temperature and humidity data
- * captured from the sensors. It acts as a communication mechanism between
- * tasks producing sensor data and tasks consuming it for processing or
- * transmission.
+ * The temperature monitor is the only producer and the MQTT task the only
+ * consumer. Elements are `temperature_data_st` and are read in place with
+ * `spsc_ring_peek()` / `spsc_ring_consume()`. New elements are signaled with
+ * `SENSOR_DATA_READY`.
  */
-extern QueueHandle_t sensor_data_queue;
+extern spsc_ring_st sensor_data_ring;
 
 /**
  * @brief Data structure to hold temperature and humidity information.
  *
  * This structure is designed to encapsulate environmental data read from a
- * temperature and humidity sensor. It contains fields for temperature and
- * relative humidity values.
+ * temperature and humidity sensor. Readings are aggregated over a window, so
+ * it holds the mean, minimum, maximum and standard deviation of the
+ * temperature and relative humidity values over `sample_count` readings, and
+ * identifies the sensor they come from. Values are fixed-point hundredths, so
+ * producing and encoding a sample needs no floating point. The sample is
+ * stamped with the monotonic time of its last reading; consumers convert it
+ * to wall-clock time with monotonic_to_epoch_ms() when they send it. Samples
+ * of a sensor are numbered, so consumers can tell when some were dropped.
  */
 typedef struct temperature_data_t {
-    float temperature; ///< Temperature reading from the sensor in degrees Celsius.
-    float humidity;    ///< Humidity reading from the sensor in percentage (%).
+    int64_t timestamp_us;        ///< Uptime of the last reading, in microseconds, from esp_timer_get_time().
+    uint32_t sequence;           ///< Number of samples of the sensor produced before this one.
+    int16_t temperature;         ///< Mean temperature over the window, in centi-degrees Celsius.
+    int16_t temperature_min;     ///< Lowest temperature over the window, in centi-degrees Celsius.
+    int16_t temperature_max;     ///< Highest temperature over the window, in centi-degrees Celsius.
+    uint16_t temperature_stddev; ///< Standard deviation of the temperature over the window, in centi-degrees Celsius.
+    uint16_t humidity;           ///< Mean humidity over the window, in centi-percent.
+    uint16_t humidity_min;       ///< Lowest humidity over the window, in centi-percent.
+    uint16_t humidity_max;       ///< Highest humidity over the window, in centi-percent.
+    uint16_t humidity_stddev;    ///< Standard deviation of the humidity over the window, in centi-percent.
+    uint16_t sample_count;       ///< Number of readings aggregated.
+    uint8_t sensor_id;           ///< Index of the sensor in the monitor's sensor table.
 } temperature_data_st;
 
 /**
@@ -45,8 +61,68 @@ typedef struct temperature_data_t {
  * such as reading the sensor data, logging the results, or triggering
  * events based on specific conditions.
  *
- * @param[in] pvParameters Pointer to task parameters (TaskHandle_t).
+ * @param[in] pvParameters Pointer to the firmware event group handle.
  */
 void temperature_monitor_task_execute(void *pvParameters);
 
+/**
+ * @brief Get the latest reading of a sensor.
+ *
+ * Readings are published after every sweep, before aggregation, for consumers
+ * that only care about the current value. The returned sample covers a single
+ * reading. Safe to call from any task; a reader never blocks the monitor.
+ *
+ * @param[in]  sensor_id Identifier of the sensor.
+ * @param[out] sample    Latest reading of the sensor.
+ * @param[out] sequence  Number of readings published for this sensor so far,
+ *                       which changes whenever a new reading is available.
+ *
+ * @return true if the sensor exists and has published a reading.
+ */
+bool temperature_monitor_get_latest(uint8_t sensor_id, temperature_data_st *sample, uint32_t *sequence);
+
+/**
+ * @brief Take a single reading of every sensor, without the monitor task.
+ *
+ * Initializes the buses and the sensors, runs one sweep and returns the
+ * reading of every sensor that answered, as samples of a single reading
+ * stamped with the uptime. Meant for a short wake from deep sleep: must be
+ * called at most once per boot, and never while the monitor task runs.
+ *
+ * @param[out] samples Buffer receiving one sample per sensor read.
+ * @param[in]  size    Number of samples the buffer can hold.
+ * @param[out] count   Number of samples written.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid parameters, or
+ *         ESP_FAIL if no bus could be initialized.
+ */
+esp_err_t temperature_monitor_read_once(temperature_data_st *samples, size_t size, size_t *count);
+
+/**
+ * @brief Set the period between two sweeps of the sensors.
+ *
+ * Takes effect from the next sweep. Safe to call from any task.
+ *
+ * @param[in] period_ms Sample period, in milliseconds, 0 for the default `SAMPLE_PERIOD_MS`.
+ */
+void temperature_monitor_set_sample_period(uint32_t period_ms);
+
+/**
+ * @brief Set the length of the aggregation windows.
+ *
+ * Takes effect when the current window closes. A window holds at most
+ * `UINT16_MAX` readings, later readings of a longer window are dropped. Safe
+ * to call from any task.
+ *
+ * @param[in] period_ms Window length, in milliseconds, 0 for the default `WINDOW_PERIOD_MS`.
+ */
+void temperature_monitor_set_window_period(uint32_t period_ms);
+
+/**
+ * @brief Get the number of sensors handled by the temperature monitor.
+ *
+ * @return Number of sensors, identifiers run from 0 to this value minus one.
+ */
+uint8_t temperature_monitor_get_sensor_count(void);
+
 #endif /* TEMPERATURE_MONITOR_TASK_H */
@@ -1,11 +1,15 @@
 #include "utils.h"
 
 #include <time.h>
+#include <stdarg.h>
+#include <stdio.h>
 #include <string.h>
+#include <sys/time.h>
 #include "esp_err.h"
 #include "esp_system.h"
 #include "esp_mac.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 /**
  * @brief Retrieve a unique identifier for the ESP32 based on its MAC address.
@@ -41,31 +45,26 @@ void get_unique_id(char *unique_id, size_t max_len) {
 }
 
 /**
- * @brief Get the current timestamp in ISO 8601 format.
+ * @brief Format a timestamp in ISO 8601 format.
  *
- * This function retrieves the current system time and formats it
+ * This function converts the given time to local time and formats it
  * as an ISO 8601 string (e.g., "2024-12-24T15:30:45").
  *
+ * @param[in]  timestamp   Time to format, in seconds since the epoch.
  * @param[out] buffer      Pointer to the buffer where the formatted timestamp will be stored.
  * @param[in]  buffer_size Size of the buffer.
  *
  * @return ESP_OK on success, or an appropriate error code on failure:
  *         - ESP_ERR_INVALID_ARG if the buffer is NULL or the size is zero.
- *         - ESP_ERR_INVALID_STATE if the system time is not set.
  *         - ESP_FAIL if time formatting fails.
  */
-esp_err_t get_timestamp_in_iso_format(char* buffer, size_t buffer_size) {
+esp_err_t format_timestamp_in_iso_format(time_t timestamp, char* buffer, size_t buffer_size) {
     if (buffer == NULL || buffer_size == 0) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    time_t now = time(NULL);
-    if (now == (time_t)(-1)) {
-        return ESP_ERR_INVALID_STATE;
-    }
-
     struct tm timeinfo;
-    if (localtime_r(&now, &timeinfo) == NULL) {
+    if (localtime_r(&timestamp, &timeinfo) == NULL) {
         return ESP_FAIL;
     }
 
@@ -74,4 +73,123 @@ esp_err_t get_timestamp_in_iso_format(char* buffer, size_t buffer_size) {
     }
 
     return ESP_OK;
+}
+
+/**
+ * @brief Format a fixed-point hundredths value as a decimal number (e.g. "-3.05").
+ *
+ * @param[out] buffer Buffer receiving the number.
+ * @param[in]  size   Size of the buffer, in bytes.
+ * @param[in]  centi  Value in hundredths.
+ *
+ * @return Number of characters that would have been written, as `snprintf`.
+ */
+int format_centi(char* buffer, size_t size, int32_t centi) {
+    uint32_t magnitude = (centi < 0) ? (uint32_t)(-centi) : (uint32_t)centi;
+    return snprintf(buffer, size, "%s%lu.%02lu",
+                    (centi < 0) ? "-" : "",
+                    (unsigned long)(magnitude / 100),
+                    (unsigned long)(magnitude % 100));
+}
+
+/**
+ * @brief Append formatted text to a document.
+ *
+ * Nothing is appended if the whole text does not fit, the document stays
+ * NUL-terminated either way.
+ *
+ * @param[out]    buffer Buffer holding the document.
+ * @param[in]     size   Size of the buffer, in bytes.
+ * @param[in,out] length Length of the document, in bytes.
+ * @param[in]     format printf-style format of the text.
+ *
+ * @return true if the text fits in the buffer.
+ */
+bool format_append(char* buffer, size_t size, size_t* length, const char* format, ...) {
+    va_list args;
+
+    if (*length >= size) {
+        return false;
+    }
+
+    va_start(args, format);
+    int written = vsnprintf(&buffer[*length], size - *length, format, args);
+    va_end(args);
+
+    if ((written < 0) || ((size_t)written >= size - *length)) {
+        buffer[*length] = '\0';
+        return false;
+    }
+    *length += written;
+
+    return true;
+}
+
+/**
+ * @brief Get the current time in milliseconds since the epoch.
+ *
+ * @return The current system time, in milliseconds since the epoch.
+ */
+int64_t get_epoch_time_ms(void) {
+    struct timeval now = {0};
+    gettimeofday(&now, NULL);
+
+    return ((int64_t)now.tv_sec * 1000) + (now.tv_usec / 1000);
+}
+
+/**
+ * @brief Get the offset of the system clock from the monotonic uptime.
+ *
+ * Adding the offset to a monotonic timestamp gives the corresponding system
+ * time. Callers converting many timestamps read it once for all of them.
+ *
+ * @return System time minus uptime, in microseconds.
+ */
+int64_t get_epoch_offset_us(void) {
+    struct timeval now = {0};
+    gettimeofday(&now, NULL);
+
+    return ((int64_t)now.tv_sec * 1000000) + now.tv_usec - esp_timer_get_time();
+}
+
+/**
+ * @brief Convert a monotonic timestamp to milliseconds since the epoch.
+ *
+ * Samples are stamped with the monotonic uptime when they are acquired and
+ * converted with the current offset of the system clock when they are sent,
+ * so the time they were taken is kept however late they are published.
+ *
+ * @param[in] monotonic_us Uptime, in microseconds, as returned by esp_timer_get_time().
+ *
+ * @return The corresponding system time, in milliseconds since the epoch.
+ */
+int64_t monotonic_to_epoch_ms(int64_t monotonic_us) {
+    return (monotonic_us + get_epoch_offset_us()) / 1000;
+}
+
+/**
+ * @brief Get the current timestamp in ISO 8601 format.
+ *
+ * This function retrieves the current system time and formats it
+ * as an ISO 8601 string (e.g., "2024-12-24T15:30:45").
+ *
+ * @param[out] buffer      Pointer to the buffer where the formatted timestamp will be stored.
+ * @param[in]  buffer_size Size of the buffer.
+ *
+ * @return ESP_OK on success, or an appropriate error code on failure:
+ *         - ESP_ERR_INVALID_ARG if the buffer is NULL or the size is zero.
+ *         - ESP_ERR_INVALID_STATE if the system time is not set.
+ *         - ESP_FAIL if time formatting fails.
+ */
+esp_err_t get_timestamp_in_iso_format(char* buffer, size_t buffer_size) {
+    if (buffer == NULL || buffer_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    time_t now = time(NULL);
+    if (now == (time_t)(-1)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    return format_timestamp_in_iso_format(now, buffer, buffer_size);
 }
\ No newline at end of file
@@ -11,8 +11,85 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
 #include "esp_err.h"
 
+/**
+ * @brief Format a timestamp in ISO 8601 format.
+ *
+ * This function converts the given time to local time and formats it
+ * as an ISO 8601 string (e.g., "2024-12-24T15:30:45").
+ *
+ * @param[in]  timestamp   Time to format, in seconds since the epoch.
+ * @param[out] buffer      Pointer to the buffer where the formatted timestamp will be stored.
+ * @param[in]  buffer_size Size of the buffer.
+ *
+ * @return ESP_OK on success, or an appropriate error code on failure:
+ *         - ESP_ERR_INVALID_ARG if the buffer is NULL or the size is zero.
+ *         - ESP_FAIL if time formatting fails.
+ */
+esp_err_t format_timestamp_in_iso_format(time_t timestamp, char* buffer, size_t buffer_size);
+
+/**
+ * @brief Format a fixed-point hundredths value as a decimal number (e.g. "-3.05").
+ *
+ * @param[out] buffer Buffer receiving the number.
+ * @param[in]  size   Size of the buffer, in bytes.
+ * @param[in]  centi  Value in hundredths.
+ *
+ * @return Number of characters that would have been written, as `snprintf`.
+ */
+int format_centi(char* buffer, size_t size, int32_t centi);
+
+/**
+ * @brief Append formatted text to a document.
+ *
+ * Nothing is appended if the whole text does not fit, the document stays
+ * NUL-terminated either way.
+ *
+ * @param[out]    buffer Buffer holding the document.
+ * @param[in]     size   Size of the buffer, in bytes.
+ * @param[in,out] length Length of the document, in bytes.
+ * @param[in]     format printf-style format of the text.
+ *
+ * @return true if the text fits in the buffer.
+ */
+bool format_append(char* buffer, size_t size, size_t* length, const char* format, ...) __attribute__((format(printf, 4, 5)));
+
+/**
+ * @brief Get the current time in milliseconds since the epoch.
+ *
+ * @return The current system time, in milliseconds since the epoch.
+ */
+int64_t get_epoch_time_ms(void);
+
+/**
+ * @brief Get the offset of the system clock from the monotonic uptime.
+ *
+ * Adding the offset to a monotonic timestamp gives the corresponding system
+ * time. Callers converting many timestamps read it once for all of them.
+ *
+ * @return System time minus uptime, in microseconds.
+ */
+int64_t get_epoch_offset_us(void);
+
+/**
+ * @brief Convert a monotonic timestamp to milliseconds since the epoch.
+ *
+ * Samples are stamped with the monotonic uptime when they are acquired and
+ * converted with the current offset of the system clock when they are sent,
+ * so the time they were taken is kept however late they are published.
+ *
+ * @param[in] monotonic_us Uptime, in microseconds, as returned by esp_timer_get_time().
+ *
+ * @return The corresponding system time, in milliseconds since the epoch.
+ */
+int64_t monotonic_to_epoch_ms(int64_t monotonic_us);
+
 /**
  * @brief Get the current timestamp in ISO 8601 format.
  *
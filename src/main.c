@@ -1,15 +1,33 @@
 #include "network_task.h"
+#include "deferred_log.h"
 #include "http_server_task.h"
+#include "low_power.h"
 #include "mqtt_client_task.h"
 #include "temperature_monitor_task.h"
 #include "sntp_task.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/timers.h"
 
+#include "driver/gpio.h"
+#include "esp_attr.h"
 #include "esp_log.h"
 #include "nvs_flash.h"
 
+// Provisional stack sizes, estimated from the call paths and not yet measured on a board, see `TASKS`.
+#define NETWORK_TASK_STACK_SIZE 4096      ///< Stack of the network task, in bytes.
+#define HTTP_SERVER_TASK_STACK_SIZE 4096  ///< Stack of the HTTP server task, in bytes.
+#define MONITOR_TASK_STACK_SIZE 3072      ///< Stack of the temperature monitoring task, in bytes.
+#define MQTT_TASK_STACK_SIZE 6144         ///< Stack of the MQTT task, in bytes.
+#define SNTP_TASK_STACK_SIZE 3072         ///< Stack of the SNTP task, in bytes.
+#define LOG_TASK_STACK_SIZE 3072          ///< Stack of the deferred log task, in bytes.
+
+#define PROVISIONING_BUTTON_GPIO GPIO_NUM_0  ///< BOOT button of the board, low while pressed.
+
+#define NETWORK_CORE 0                        ///< Protocol core, running the networking tasks alongside Wi-Fi and lwIP.
+#define SENSOR_CORE (portNUM_PROCESSORS - 1)  ///< Application core running the sampling, the only core on single-core targets.
+
 /**
  * @brief Event group for signaling system status and events.
  *
@@ -21,6 +39,102 @@
  */
 EventGroupHandle_t firmware_event_group = {0};
 
+/**
+ * @brief Creation parameters of a firmware task.
+ */
+typedef struct task_config_s {
+    TaskFunction_t function;  ///< Entry point, called with the firmware event group.
+    const char *name;         ///< Name of the task.
+    uint32_t stack_size;      ///< Size of the stack, in bytes.
+    UBaseType_t priority;     ///< Priority of the task.
+    BaseType_t core;          ///< Core the task is pinned to.
+    StackType_t *stack;       ///< Statically allocated stack of `stack_size` bytes, NULL to allocate it on the heap.
+    StaticTask_t *buffer;     ///< Statically allocated control block, used with `stack`.
+    bool is_flush_task;       ///< Whether the task also runs on the flush wakes of the low-power mode.
+} task_config_st;
+
+static const char *TAG = "Main";  ///< Tag for logging.
+
+static StackType_t monitor_task_stack[MONITOR_TASK_STACK_SIZE] = {0};  ///< Stack of the temperature monitoring task.
+static StaticTask_t monitor_task_buffer                        = {0};  ///< Control block of the temperature monitoring task.
+static StackType_t mqtt_task_stack[MQTT_TASK_STACK_SIZE]       = {0};  ///< Stack of the MQTT task.
+static StaticTask_t mqtt_task_buffer                           = {0};  ///< Control block of the MQTT task.
+
+/**
+ * @brief Tasks of the firmware, created in this order.
+ *
+ * Sampling runs alone on the application core at the highest priority, so
+ * its cadence does not depend on the network. Every networking task shares
+ * the protocol core with the Wi-Fi and lwIP tasks, below their priorities.
+ * The stacks of the two always-busy tasks are allocated statically, so they
+ * are accounted for at link time and never fragment the heap.
+ *
+ * The stack sizes are provisional: they were estimated from the deepest call
+ * path of each task read in the sources, not measured on a board. The
+ * printf-style formatting, the TLS handshake and the HTTP handlers are the
+ * least certain. Before relying on them, run each mode (provisioning, normal
+ * with an mqtts broker, low-power flush) for a while, read `stack_free` in
+ * the runtime metrics and resize each task to its watermark plus about 1 KB
+ * of headroom.
+ *
+ * On the flush wakes of the low-power mode, only the tasks needed to deliver
+ * the buffered samples are created. The deferred log task formats the log
+ * entries of the hot paths at the lowest priority, so it only runs when
+ * the protocol core is otherwise idle.
+ */
+static const task_config_st TASKS[] = {
+    {
+        .function      = temperature_monitor_task_execute,
+        .name          = "Temperature Monitoring Task",
+        .stack_size    = MONITOR_TASK_STACK_SIZE,
+        .priority      = 6,
+        .core          = SENSOR_CORE,
+        .stack         = monitor_task_stack,
+        .buffer        = &monitor_task_buffer,
+    },
+    {
+        .function      = network_task_execute,
+        .name          = "Network Task",
+        .stack_size    = NETWORK_TASK_STACK_SIZE,
+        .priority      = 4,
+        .core          = NETWORK_CORE,
+        .is_flush_task = true,
+    },
+    {
+        .function      = mqtt_client_task_execute,
+        .name          = "MQTT Task",
+        .stack_size    = MQTT_TASK_STACK_SIZE,
+        .priority      = 3,
+        .core          = NETWORK_CORE,
+        .stack         = mqtt_task_stack,
+        .buffer        = &mqtt_task_buffer,
+        .is_flush_task = true,
+    },
+    {
+        .function      = http_server_task_execute,
+        .name          = "HTTP Server Task",
+        .stack_size    = HTTP_SERVER_TASK_STACK_SIZE,
+        .priority      = 2,
+        .core          = NETWORK_CORE,
+    },
+    {
+        .function      = sntp_task_execute,
+        .name          = "SNTP Task",
+        .stack_size    = SNTP_TASK_STACK_SIZE,
+        .priority      = 1,
+        .core          = NETWORK_CORE,
+        .is_flush_task = true,
+    },
+    {
+        .function      = deferred_log_task_execute,
+        .name          = "Log Task",
+        .stack_size    = LOG_TASK_STACK_SIZE,
+        .priority      = 1,
+        .core          = NETWORK_CORE,
+        .is_flush_task = true,
+    },
+};
+
 /*
  * @brief Initialize the Non-Volatile Storage (NVS) for the device.
  *
@@ -29,6 +143,10 @@ EventGroupHandle_t firmware_event_group = {0};
  * to no free pages or a new version of NVS being found, it will erase the existing NVS data
  * and reinitialize it.
  *
+ * NVS holds the Wi-Fi credentials. When `CONFIG_NVS_ENCRYPTION` is enabled (it requires
+ * flash encryption), `nvs_flash_init()` encrypts the partition with the keys kept in the
+ * `nvs_key` partition, generating them on first boot.
+ *
  * @return 
  * - ESP_OK on successful initialization.
  * - Other error codes from `nvs_flash_init()` in case of failure.
@@ -42,49 +160,91 @@ esp_err_t initialize_nvs(void) {
     return result;
 }
 
+/**
+ * @brief Bring up the provisioning Access Point, deferred from the button interrupt.
+ *
+ * Runs in the FreeRTOS timer task.
+ *
+ * @param[in] parameter1 Unused.
+ * @param[in] parameter2 Unused.
+ */
+static void start_provisioning(void *parameter1, uint32_t parameter2) {
+    network_start_provisioning();
+}
+
+/**
+ * @brief Interrupt handler of the provisioning button.
+ *
+ * The network task cannot be notified from here, so the request is handed to
+ * the timer task. Bounces only queue the same request again.
+ *
+ * @param[in] arg Unused.
+ */
+static void IRAM_ATTR provisioning_button_isr(void *arg) {
+    BaseType_t is_higher_priority_task_woken = pdFALSE;
+
+    xTimerPendFunctionCallFromISR(start_provisioning, NULL, 0, &is_higher_priority_task_woken);
+    portYIELD_FROM_ISR(is_higher_priority_task_woken);
+}
+
+/**
+ * @brief Let a press on the BOOT button bring up the provisioning Access Point.
+ *
+ * Moves a provisioned device to another network without erasing its flash.
+ *
+ * @return ESP_OK on success, or a GPIO error code.
+ */
+esp_err_t initialize_provisioning_button(void) {
+    esp_err_t result = ESP_OK;
+
+    gpio_config_t button_config = {
+        .pin_bit_mask = 1ULL << PROVISIONING_BUTTON_GPIO,
+        .mode         = GPIO_MODE_INPUT,
+        .pull_up_en   = GPIO_PULLUP_ENABLE,
+        .intr_type    = GPIO_INTR_NEGEDGE,
+    };
+
+    result += gpio_config(&button_config);
+    result += gpio_install_isr_service(0);
+    result += gpio_isr_handler_add(PROVISIONING_BUTTON_GPIO, provisioning_button_isr, NULL);
+
+    return result;
+}
+
 void app_main() {
 
     ESP_ERROR_CHECK(initialize_nvs());
 
+    low_power_mode_e power_mode = low_power_begin();
+    if (power_mode == LOW_POWER_MODE_FLUSH) {
+        network_set_access_point_enabled(false);
+    } else {
+        ESP_ERROR_CHECK_WITHOUT_ABORT(initialize_provisioning_button());
+    }
+
     firmware_event_group = xEventGroupCreate();
-    
-    xTaskCreate(
-        network_task_execute,
-        "Network Task",
-        2048 * 10,
-        (void *)&firmware_event_group,
-        tskIDLE_PRIORITY,
-        NULL);
-
-    xTaskCreate(
-        http_server_task_execute,
-        "HTTP Server Task",
-        2048 * 10,
-        (void *)&firmware_event_group,
-        tskIDLE_PRIORITY,
-        NULL);
-
-    xTaskCreate(
-        temperature_monitor_task_execute,
-        "Temperature Monitoring Task",
-        2048 * 10,
-        NULL,
-        tskIDLE_PRIORITY,
-        NULL);       
-
-    xTaskCreate(
-        mqtt_client_task_execute,
-        "MQTT Task",
-        2048 * 10,
-        (void *)&firmware_event_group,
-        tskIDLE_PRIORITY,
-        NULL);       
-
-    xTaskCreate(
-        sntp_task_execute,
-        "SNTP Task",
-        2048 * 10,
-        (void *)&firmware_event_group,
-        tskIDLE_PRIORITY,
-        NULL);       
-}
\ No newline at end of file
+
+    for (size_t i = 0; i < sizeof(TASKS) / sizeof(TASKS[0]); i++) {
+        const task_config_st* task = &TASKS[i];
+        TaskHandle_t handle        = NULL;
+
+        if ((power_mode == LOW_POWER_MODE_FLUSH) && !task->is_flush_task) {
+            continue;
+        }
+
+        if (task->stack != NULL) {
+            handle = xTaskCreateStaticPinnedToCore(task->function, task->name, task->stack_size,
+                                                   (void *)&firmware_event_group, task->priority,
+                                                   task->stack, task->buffer, task->core);
+        } else {
+            xTaskCreatePinnedToCore(task->function, task->name, task->stack_size,
+                                    (void *)&firmware_event_group, task->priority, &handle, task->core);
+        }
+
+        if (handle == NULL) {
+            ESP_LOGE(TAG, "Failed to create %s", task->name);
+        }
+    }
+
+    low_power_finish(power_mode);
+}
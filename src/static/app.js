@@ -1,18 +1,48 @@
 var button = document.getElementById("connectionButton");
+var statusLabel = document.getElementById("connectionStatus");
 
-button.addEventListener("click", function() {
-    ssid = $("#connected_ssid").val()
-    pwd = $("#connected_pwd").val()
+function showStatus(status) {
+    if (status.state === "connected") {
+        statusLabel.textContent = "Connected to " + status.ssid + " (" + status.ip + ", " + status.rssi + " dBm)";
+    } else if (status.state === "connecting") {
+        statusLabel.textContent = "Connecting to " + status.ssid + (status.attempt > 0 ? " (attempt " + status.attempt + ")" : "") + "...";
+    } else if (status.state === "failed") {
+        statusLabel.textContent = "Could not connect to " + status.ssid + " (reason " + status.reason + "), retrying...";
+    } else {
+        statusLabel.textContent = "";
+    }
+}
+
+// The device answers as soon as the status moves past the given version, so
+// each response is shown without polling delays.
+function followStatus(status) {
+    showStatus(status);
+    if ((status.state !== "connecting") && (status.state !== "failed")) {
+        return;
+    }
 
-    console.log(ssid)
-    console.log(pwd)
+    fetch("/status.json?version=" + status.version, {cache: "no-store"})
+        .then(function(response) {
+            return response.json();
+        })
+        .then(followStatus)
+        .catch(function(error) {
+            console.log(error);
+        });
+}
+
+button.addEventListener("click", function() {
+    var ssid = document.getElementById("connected_ssid").value;
+    var pwd = document.getElementById("connected_pwd").value;
 
-    $.ajax ({
-        url: "/wifiCredentials.json",
-        dataType: "json",
+    fetch("/wifiCredentials.json", {
         method: "POST",
-        cache: false,
+        cache: "no-store",
         headers: {"my-connected-ssid": ssid, "my-connected-pwd": pwd},
-        data: {"timestamp": Date.now()}
+        body: JSON.stringify({"timestamp": Date.now()})
+    }).then(function(response) {
+        return response.json();
+    }).then(followStatus).catch(function(error) {
+        console.log(error);
     });
-});
\ No newline at end of file
+});
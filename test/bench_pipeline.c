@@ -0,0 +1,225 @@
+/**
+ * @file bench_pipeline.c
+ * @brief Host benchmark of the sample ring and the telemetry encoders.
+ *
+ * Samples go through the path of the batch publishing mode of the MQTT task:
+ * pushed to a `spsc_ring_st`, read in place, encoded into a payload buffer of
+ * the size the task uses and released from the ring. A sample that does not
+ * fit closes the payload and starts the next one, as a full batch does. For
+ * each format and batch size, the benchmark reports the payload bytes per
+ * sample, the payloads per batch and the encoding throughput; the ring alone
+ * is measured at the same batch sizes.
+ *
+ * Run with `cmake --build <dir> --target bench`, or with a number of rounds
+ * as argument. Figures are for the host CPU: they compare formats and batch
+ * sizes with each other, not with the ESP32.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "spsc_ring.h"
+#include "telemetry_encoder.h"
+
+#define BENCH_RING_CAPACITY 64   ///< Capacity of the ring, a power of two above the largest batch.
+#define BENCH_PAYLOAD_SIZE 2048  ///< Size of the payload buffer, as `MQTT_BATCH_PAYLOAD_SIZE` of the MQTT task.
+#define BENCH_SAMPLES 200000     ///< Samples encoded per round, format and batch size.
+#define BENCH_DEFAULT_ROUNDS 5   ///< Rounds run without argument, the best one is reported.
+
+static const size_t BATCH_SIZES[]       = {1, 4, 8, 16, 32};  ///< Batch sizes measured, up to `DEVICE_CONFIG_MAX_BATCH_SIZE`.
+static const int64_t BATCH_TIMESTAMP_MS = 1700000000000;      ///< Timestamp of the first sample.
+static const int64_t SAMPLE_INTERVAL_MS = 30000;              ///< Time between two samples, the default window length.
+
+static temperature_data_st ring_storage[BENCH_RING_CAPACITY] = {0};  ///< Storage of the ring.
+static uint8_t payload[BENCH_PAYLOAD_SIZE]                   = {0};  ///< Payload buffer.
+static volatile size_t sink                                  = 0;    ///< Keeps the compiler from dropping the measured work.
+
+/**
+ * @brief Figures of one measurement.
+ */
+typedef struct bench_result_s {
+    double seconds;   ///< Time taken by the fastest round.
+    size_t bytes;     ///< Payload bytes produced in a round.
+    size_t payloads;  ///< Payloads produced in a round.
+} bench_result_st;
+
+/**
+ * @brief Read the monotonic clock.
+ *
+ * @return Time in seconds.
+ */
+static double now_seconds(void) {
+    struct timespec time = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (double)time.tv_sec + ((double)time.tv_nsec / 1e9);
+}
+
+/**
+ * @brief Build a synthetic aggregated sample.
+ *
+ * Values move from sample to sample so the JSON numbers have realistic widths.
+ *
+ * @param[in] index Number of the sample.
+ *
+ * @return The sample.
+ */
+static temperature_data_st make_sample(size_t index) {
+    int16_t temperature = (int16_t)(2000 + (int)(index % 700) - 350);
+    uint16_t humidity   = (uint16_t)(4000 + (index % 1500));
+
+    return (temperature_data_st){
+        .timestamp_us       = (int64_t)index * SAMPLE_INTERVAL_MS * 1000,
+        .sequence           = (uint32_t)index,
+        .temperature        = temperature,
+        .temperature_min    = (int16_t)(temperature - 12),
+        .temperature_max    = (int16_t)(temperature + 17),
+        .temperature_stddev = (uint16_t)(index % 40),
+        .humidity           = humidity,
+        .humidity_min       = (uint16_t)(humidity - 35),
+        .humidity_max       = (uint16_t)(humidity + 22),
+        .humidity_stddev    = (uint16_t)(index % 60),
+        .sensor_id          = (uint8_t)(index % 4),
+        .sample_count       = 120,
+    };
+}
+
+/**
+ * @brief Push samples through the ring and the encoder, as the batch publishing mode does.
+ *
+ * @param[in]  format     Format of the payloads.
+ * @param[in]  batch_size Number of samples pushed to the ring between two flushes.
+ * @param[out] result     Bytes and payloads produced, the time is left untouched.
+ */
+static void run_encoding(telemetry_format_e format, size_t batch_size, bench_result_st *result) {
+    spsc_ring_st ring                  = SPSC_RING_STATIC_INIT(ring_storage, BENCH_RING_CAPACITY);
+    const temperature_data_st *samples = NULL;
+    telemetry_encoder_st encoder       = {0};
+    size_t length                      = 0;
+
+    result->bytes    = 0;
+    result->payloads = 0;
+
+    for (size_t index = 0; index < BENCH_SAMPLES;) {
+        for (size_t i = 0; (i < batch_size) && (index < BENCH_SAMPLES); i++, index++) {
+            temperature_data_st sample = make_sample(index);
+            spsc_ring_push(&ring, &sample);
+        }
+
+        while (spsc_ring_peek(&ring, (const void **)&samples, 1) > 0) {
+            size_t examined = 0;
+            size_t span     = 0;
+
+            telemetry_encoder_begin(&encoder, format, payload, sizeof(payload),
+                                    BATCH_TIMESTAMP_MS + (samples[0].timestamp_us / 1000));
+            while ((span = spsc_ring_peek_at(&ring, examined, (const void **)&samples, SIZE_MAX)) > 0) {
+                size_t used = 0;
+                while ((used < span) &&
+                       (telemetry_encoder_append(&encoder, &samples[used],
+                                                 BATCH_TIMESTAMP_MS + (samples[used].timestamp_us / 1000)) == ESP_OK)) {
+                    used++;
+                }
+                examined += used;
+                if (used < span) {
+                    break;
+                }
+            }
+            telemetry_encoder_finish(&encoder, &length);
+            spsc_ring_consume(&ring, examined);
+
+            result->bytes += length;
+            result->payloads++;
+        }
+    }
+
+    sink += result->bytes;
+}
+
+/**
+ * @brief Push samples through the ring alone, in batches.
+ *
+ * @param[in] batch_size Number of samples pushed between two reads.
+ */
+static void run_ring(size_t batch_size) {
+    spsc_ring_st ring                  = SPSC_RING_STATIC_INIT(ring_storage, BENCH_RING_CAPACITY);
+    const temperature_data_st *samples = NULL;
+    temperature_data_st sample         = make_sample(0);
+    size_t total                       = 0;
+
+    for (size_t index = 0; index < BENCH_SAMPLES;) {
+        for (size_t i = 0; (i < batch_size) && (index < BENCH_SAMPLES); i++, index++) {
+            sample.sequence = (uint32_t)index;
+            spsc_ring_push(&ring, &sample);
+        }
+
+        size_t span = 0;
+        while ((span = spsc_ring_peek(&ring, (const void **)&samples, SIZE_MAX)) > 0) {
+            total += samples[span - 1].sequence;
+            spsc_ring_consume(&ring, span);
+        }
+    }
+
+    sink += total;
+}
+
+int main(int argc, char **argv) {
+    static const telemetry_format_e FORMATS[] = {TELEMETRY_FORMAT_JSON, TELEMETRY_FORMAT_BINARY};
+    static const char *FORMAT_NAMES[]         = {"json", "binary v4"};
+
+    int rounds = (argc > 1) ? atoi(argv[1]) : BENCH_DEFAULT_ROUNDS;
+    if (rounds < 1) {
+        fprintf(stderr, "usage: %s [rounds]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    setenv("TZ", "UTC0", 1);
+    tzset();
+
+    printf("%d sample(s) per round, best of %d round(s), payload buffer of %d bytes\n\n",
+           BENCH_SAMPLES, rounds, BENCH_PAYLOAD_SIZE);
+    printf("%-10s %6s %14s %18s %16s %10s\n", "format", "batch", "bytes/sample", "payloads/batch", "samples/s", "MB/s");
+
+    for (size_t f = 0; f < sizeof(FORMATS) / sizeof(FORMATS[0]); f++) {
+        for (size_t b = 0; b < sizeof(BATCH_SIZES) / sizeof(BATCH_SIZES[0]); b++) {
+            bench_result_st result = {.seconds = 0.0};
+
+            for (int round = 0; round < rounds; round++) {
+                double start   = now_seconds();
+                run_encoding(FORMATS[f], BATCH_SIZES[b], &result);
+                double elapsed = now_seconds() - start;
+                if ((round == 0) || (elapsed < result.seconds)) {
+                    result.seconds = elapsed;
+                }
+            }
+
+            double batches = (double)BENCH_SAMPLES / (double)BATCH_SIZES[b];
+            printf("%-10s %6zu %14.1f %18.2f %16.0f %10.1f\n",
+                   FORMAT_NAMES[f], BATCH_SIZES[b],
+                   (double)result.bytes / BENCH_SAMPLES,
+                   (double)result.payloads / batches,
+                   BENCH_SAMPLES / result.seconds,
+                   (double)result.bytes / result.seconds / 1e6);
+        }
+    }
+
+    printf("\n%-10s %6s %16s\n", "ring", "batch", "samples/s");
+    for (size_t b = 0; b < sizeof(BATCH_SIZES) / sizeof(BATCH_SIZES[0]); b++) {
+        double best = 0.0;
+
+        for (int round = 0; round < rounds; round++) {
+            double start   = now_seconds();
+            run_ring(BATCH_SIZES[b]);
+            double elapsed = now_seconds() - start;
+            if ((round == 0) || (elapsed < best)) {
+                best = elapsed;
+            }
+        }
+
+        printf("%-10s %6zu %16.0f\n", "", BATCH_SIZES[b], BENCH_SAMPLES / best);
+    }
+
+    return EXIT_SUCCESS;
+}
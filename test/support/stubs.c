@@ -0,0 +1,337 @@
+/**
+ * @file stubs.c
+ * @brief Host implementations of the ESP-IDF and firmware functions the tested modules call.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "network_task.h"
+#include "nvs.h"
+
+#define NVS_STUB_CAPACITY 64      ///< Largest number of entries the NVS table holds.
+#define NVS_STUB_NAME_SIZE 16     ///< Size of a namespace or key, including the terminator, as in ESP-IDF.
+#define NVS_STUB_STRING_SIZE 128  ///< Size of the largest string value, including the terminator.
+
+/**
+ * @brief Kind of value held by an NVS entry.
+ */
+typedef enum nvs_stub_type_t {
+    NVS_STUB_TYPE_U8 = 0,  ///< 8-bit unsigned integer.
+    NVS_STUB_TYPE_U16,     ///< 16-bit unsigned integer.
+    NVS_STUB_TYPE_U32,     ///< 32-bit unsigned integer.
+    NVS_STUB_TYPE_STR,     ///< NUL-terminated string.
+} nvs_stub_type_e;
+
+/**
+ * @brief One key of the NVS table.
+ */
+typedef struct nvs_stub_entry_s {
+    bool is_used;                         ///< Whether the entry holds a key.
+    char name_space[NVS_STUB_NAME_SIZE];  ///< Namespace of the key.
+    char key[NVS_STUB_NAME_SIZE];         ///< Name of the key.
+    nvs_stub_type_e type;                 ///< Kind of value.
+    uint32_t value;                       ///< Integer value.
+    char string[NVS_STUB_STRING_SIZE];    ///< String value.
+} nvs_stub_entry_st;
+
+static nvs_stub_entry_st nvs_entries[NVS_STUB_CAPACITY]           = {0};                   ///< Every key stored.
+static char nvs_namespaces[NVS_STUB_CAPACITY][NVS_STUB_NAME_SIZE] = {{0}};                 ///< Namespace of each open handle, indexed by the handle minus one.
+static network_ip_mode_e ip_mode                                  = NETWORK_IP_MODE_DHCP;  ///< IP configuration mode kept by `network_set_ip_mode()`.
+static uint8_t partition_flash[ESP_PARTITION_STUB_SIZE]           = {0};                   ///< Content of the partition.
+static bool is_partition_erased                                   = false;                 ///< Whether the partition was erased once.
+
+/** @brief The only partition found. */
+static const esp_partition_t PARTITION = {
+    .type    = ESP_PARTITION_TYPE_DATA,
+    .subtype = 0x40,
+    .size    = ESP_PARTITION_STUB_SIZE,
+    .label   = "telemetry",
+};
+
+// Platform functions, only as far as the tested modules rely on them.
+
+const char *esp_err_to_name(esp_err_t code) {
+    return (code == ESP_OK) ? "ESP_OK" : "ERROR";
+}
+
+void esp_log_discard(const char *tag, const char *format, ...) {
+    (void)tag;
+    (void)format;
+}
+
+esp_err_t esp_efuse_mac_get_default(uint8_t *mac) {
+    static const uint8_t MAC[] = {0x24, 0xA1, 0x60, 0xFF, 0xEE, 0x01};
+
+    memcpy(mac, MAC, sizeof(MAC));
+
+    return ESP_OK;
+}
+
+int64_t esp_timer_get_time(void) {
+    return 0;
+}
+
+uint16_t esp_rom_crc16_le(uint16_t crc, const uint8_t *buf, uint32_t len) {
+    // CRC-16/CCITT, reflected, with the input and output inversions of the ROM routine.
+    crc = (uint16_t)~crc;
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (uint16_t)((crc >> 1) ^ 0x8408) : (uint16_t)(crc >> 1);
+        }
+    }
+
+    return (uint16_t)~crc;
+}
+
+// A single partition, erased as a whole the first time it is found.
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char *label) {
+    (void)type;
+    (void)subtype;
+    (void)label;
+
+    if (!is_partition_erased) {
+        memset(partition_flash, 0xFF, sizeof(partition_flash));
+        is_partition_erased = true;
+    }
+
+    return &PARTITION;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size) {
+    if ((partition != &PARTITION) || (src_offset + size > PARTITION.size)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(dst, &partition_flash[src_offset], size);
+
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size) {
+    if ((partition != &PARTITION) || (dst_offset + size > PARTITION.size)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Programming flash only clears bits.
+    for (size_t i = 0; i < size; i++) {
+        partition_flash[dst_offset + i] &= ((const uint8_t *)src)[i];
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size) {
+    if ((partition != &PARTITION) || (offset + size > PARTITION.size)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(&partition_flash[offset], 0xFF, size);
+
+    return ESP_OK;
+}
+
+// The IP configuration mode is kept by the network task, which is not built on the host.
+
+network_ip_mode_e network_get_ip_mode(void) {
+    return ip_mode;
+}
+
+esp_err_t network_set_ip_mode(network_ip_mode_e mode) {
+    ip_mode = mode;
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Find a key of an open namespace.
+ *
+ * @param[in] handle Handle of the namespace.
+ * @param[in] key    Name of the key.
+ * @param[in] create Whether to add the key if it is missing.
+ *
+ * @return The entry, or NULL if the key is missing and not created.
+ */
+static nvs_stub_entry_st *nvs_stub_find(nvs_handle_t handle, const char *key, bool create) {
+    const char *name_space        = nvs_namespaces[handle - 1];
+    nvs_stub_entry_st *free_entry = NULL;
+
+    for (size_t i = 0; i < NVS_STUB_CAPACITY; i++) {
+        nvs_stub_entry_st *entry = &nvs_entries[i];
+        if (!entry->is_used) {
+            free_entry = (free_entry == NULL) ? entry : free_entry;
+        } else if ((strcmp(entry->name_space, name_space) == 0) && (strcmp(entry->key, key) == 0)) {
+            return entry;
+        }
+    }
+
+    if (!create || (free_entry == NULL)) {
+        return NULL;
+    }
+
+    free_entry->is_used = true;
+    strncpy(free_entry->name_space, name_space, NVS_STUB_NAME_SIZE - 1);
+    strncpy(free_entry->key, key, NVS_STUB_NAME_SIZE - 1);
+
+    return free_entry;
+}
+
+/**
+ * @brief Read an integer key.
+ *
+ * @param[in]  handle Handle of the namespace.
+ * @param[in]  key    Name of the key.
+ * @param[in]  type   Kind of value expected.
+ * @param[out] value  Value read.
+ *
+ * @return ESP_OK on success, ESP_ERR_NVS_NOT_FOUND if the key is missing or of another kind.
+ */
+static esp_err_t nvs_stub_get(nvs_handle_t handle, const char *key, nvs_stub_type_e type, uint32_t *value) {
+    const nvs_stub_entry_st *entry = nvs_stub_find(handle, key, false);
+    if ((entry == NULL) || (entry->type != type)) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    *value = entry->value;
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Write an integer key.
+ *
+ * @param[in] handle Handle of the namespace.
+ * @param[in] key    Name of the key.
+ * @param[in] type   Kind of value.
+ * @param[in] value  Value to write.
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the table is full.
+ */
+static esp_err_t nvs_stub_set(nvs_handle_t handle, const char *key, nvs_stub_type_e type, uint32_t value) {
+    nvs_stub_entry_st *entry = nvs_stub_find(handle, key, true);
+    if (entry == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    entry->type  = type;
+    entry->value = value;
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Remove every key, and reset the IP configuration mode kept alongside.
+ */
+void nvs_stub_erase_all(void) {
+    memset(nvs_entries, 0, sizeof(nvs_entries));
+    ip_mode = NETWORK_IP_MODE_DHCP;
+}
+
+// NVS API, over the table above.
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle) {
+    bool is_present = false;
+
+    for (size_t i = 0; i < NVS_STUB_CAPACITY; i++) {
+        is_present = is_present || (nvs_entries[i].is_used && (strcmp(nvs_entries[i].name_space, name) == 0));
+    }
+    // As on the device, a namespace never written cannot be opened read-only.
+    if ((open_mode == NVS_READONLY) && !is_present) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+
+    for (size_t i = 0; i < NVS_STUB_CAPACITY; i++) {
+        if (nvs_namespaces[i][0] == '\0') {
+            strncpy(nvs_namespaces[i], name, NVS_STUB_NAME_SIZE - 1);
+            *out_handle = (nvs_handle_t)(i + 1);
+            return ESP_OK;
+        }
+    }
+
+    return ESP_ERR_NO_MEM;
+}
+
+void nvs_close(nvs_handle_t handle) {
+    nvs_namespaces[handle - 1][0] = '\0';
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    (void)handle;
+
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char *key, uint8_t *out_value) {
+    uint32_t value   = 0;
+    esp_err_t result = nvs_stub_get(handle, key, NVS_STUB_TYPE_U8, &value);
+    if (result == ESP_OK) {
+        *out_value = (uint8_t)value;
+    }
+
+    return result;
+}
+
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char *key, uint8_t value) {
+    return nvs_stub_set(handle, key, NVS_STUB_TYPE_U8, value);
+}
+
+esp_err_t nvs_get_u16(nvs_handle_t handle, const char *key, uint16_t *out_value) {
+    uint32_t value   = 0;
+    esp_err_t result = nvs_stub_get(handle, key, NVS_STUB_TYPE_U16, &value);
+    if (result == ESP_OK) {
+        *out_value = (uint16_t)value;
+    }
+
+    return result;
+}
+
+esp_err_t nvs_set_u16(nvs_handle_t handle, const char *key, uint16_t value) {
+    return nvs_stub_set(handle, key, NVS_STUB_TYPE_U16, value);
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char *key, uint32_t *out_value) {
+    return nvs_stub_get(handle, key, NVS_STUB_TYPE_U32, out_value);
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char *key, uint32_t value) {
+    return nvs_stub_set(handle, key, NVS_STUB_TYPE_U32, value);
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char *key, char *out_value, size_t *length) {
+    const nvs_stub_entry_st *entry = nvs_stub_find(handle, key, false);
+    if ((entry == NULL) || (entry->type != NVS_STUB_TYPE_STR)) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+
+    size_t required = strlen(entry->string) + 1;
+    if (out_value == NULL) {
+        *length = required;
+        return ESP_OK;
+    }
+    if (*length < required) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(out_value, entry->string, required);
+    *length = required;
+
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char *key, const char *value) {
+    if (strlen(value) >= NVS_STUB_STRING_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    nvs_stub_entry_st *entry = nvs_stub_find(handle, key, true);
+    if (entry == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    entry->type = NVS_STUB_TYPE_STR;
+    strcpy(entry->string, value);
+
+    return ESP_OK;
+}
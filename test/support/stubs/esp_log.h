@@ -0,0 +1,20 @@
+#ifndef ESP_LOG_H
+#define ESP_LOG_H
+
+#include "esp_err.h"
+
+/**
+ * @file esp_log.h
+ * @brief Host stand-in for the ESP-IDF logging macros, which discard the messages.
+ *
+ * The arguments are still checked against the format string.
+ */
+
+void esp_log_discard(const char *tag, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+#define ESP_LOGE(tag, format, ...) esp_log_discard(tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) esp_log_discard(tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) esp_log_discard(tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) esp_log_discard(tag, format, ##__VA_ARGS__)
+
+#endif /* ESP_LOG_H */
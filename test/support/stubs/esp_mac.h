@@ -0,0 +1,15 @@
+#ifndef ESP_MAC_H
+#define ESP_MAC_H
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+/**
+ * @file esp_mac.h
+ * @brief Host stand-in for the ESP-IDF MAC address API.
+ */
+
+esp_err_t esp_efuse_mac_get_default(uint8_t *mac);
+
+#endif /* ESP_MAC_H */
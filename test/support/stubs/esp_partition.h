@@ -0,0 +1,40 @@
+#ifndef ESP_PARTITION_H
+#define ESP_PARTITION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+/**
+ * @file esp_partition.h
+ * @brief Host stand-in for the ESP-IDF partition API, backed by a buffer in RAM.
+ *
+ * A single data partition of `ESP_PARTITION_STUB_SIZE` bytes is found,
+ * whatever the type, subtype and label asked for. As in NOR flash, erasing
+ * sets every bit and writing only clears bits.
+ */
+
+#define ESP_PARTITION_STUB_SIZE (4 * 4096)  ///< Size of the partition, in bytes.
+
+typedef enum esp_partition_type_t {
+    ESP_PARTITION_TYPE_APP  = 0x00,
+    ESP_PARTITION_TYPE_DATA = 0x01,
+} esp_partition_type_t;
+
+typedef int esp_partition_subtype_t;
+
+typedef struct esp_partition_s {
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    uint32_t address;
+    uint32_t size;
+    char label[17];
+} esp_partition_t;
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char *label);
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size);
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size);
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size);
+
+#endif /* ESP_PARTITION_H */
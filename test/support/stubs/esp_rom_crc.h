@@ -0,0 +1,13 @@
+#ifndef ESP_ROM_CRC_H
+#define ESP_ROM_CRC_H
+
+#include <stdint.h>
+
+/**
+ * @file esp_rom_crc.h
+ * @brief Host stand-in for the CRC routines of the ESP32 ROM.
+ */
+
+uint16_t esp_rom_crc16_le(uint16_t crc, const uint8_t *buf, uint32_t len);
+
+#endif /* ESP_ROM_CRC_H */
@@ -0,0 +1,11 @@
+#ifndef ESP_SYSTEM_H
+#define ESP_SYSTEM_H
+
+/**
+ * @file esp_system.h
+ * @brief Host stand-in for the ESP-IDF system API, unused by the tested functions.
+ */
+
+#include "esp_err.h"
+
+#endif /* ESP_SYSTEM_H */
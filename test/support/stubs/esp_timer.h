@@ -0,0 +1,13 @@
+#ifndef ESP_TIMER_H
+#define ESP_TIMER_H
+
+#include <stdint.h>
+
+/**
+ * @file esp_timer.h
+ * @brief Host stand-in for the ESP-IDF high-resolution timer.
+ */
+
+int64_t esp_timer_get_time(void);
+
+#endif /* ESP_TIMER_H */
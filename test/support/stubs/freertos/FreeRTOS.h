@@ -0,0 +1,15 @@
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdint.h>
+
+/**
+ * @file FreeRTOS.h
+ * @brief Host stand-in for the FreeRTOS types named by the headers under test.
+ */
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#endif /* FREERTOS_H */
@@ -0,0 +1,13 @@
+#ifndef FREERTOS_TASK_H
+#define FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+/**
+ * @file task.h
+ * @brief Host stand-in for the FreeRTOS task API, the task functions are not tested.
+ */
+
+typedef void *TaskHandle_t;
+
+#endif /* FREERTOS_TASK_H */
@@ -0,0 +1,17 @@
+#ifndef SDKCONFIG_H
+#define SDKCONFIG_H
+
+/**
+ * @file sdkconfig.h
+ * @brief Host stand-in for the generated configuration, with the Kconfig defaults of src/Kconfig.projbuild.
+ */
+
+#define CONFIG_TITANIUM_MQTT_BROKER_URI "mqtt://mqtt.eclipseprojects.io"
+#define CONFIG_TITANIUM_MQTT_OUTBOX_LIMIT 16384
+#define CONFIG_TITANIUM_MQTT_MAX_IN_FLIGHT 4
+#define CONFIG_TITANIUM_MQTT_QOS_RAW 0
+#define CONFIG_TITANIUM_MQTT_QOS_AGGREGATE 1
+#define CONFIG_TITANIUM_MQTT_QOS_REPLAY 1
+#define CONFIG_TITANIUM_MQTT_QOS_METRICS 0
+
+#endif /* SDKCONFIG_H */
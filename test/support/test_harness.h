@@ -0,0 +1,86 @@
+#ifndef TEST_HARNESS_H
+#define TEST_HARNESS_H
+
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @file test_harness.h
+ * @brief Minimal assertions for the host unit tests.
+ *
+ * Every test file builds into one executable registered with CTest. A failed
+ * assertion prints its location and returns from the test case, the other
+ * cases still run. `TEST_END()` makes the executable fail if any case did.
+ * The names follow Unity, so the cases can move to the PlatformIO test
+ * runner unchanged.
+ */
+
+static int test_failures = 0;  ///< Number of test cases that failed so far.
+
+/** @brief Record a failed assertion and leave the test case. */
+#define TEST_FAIL_MESSAGE(...)                 \
+    do {                                       \
+        printf("%s:%d: ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__);                   \
+        printf("\n");                          \
+        test_failures++;                       \
+        return;                                \
+    } while (0)
+
+/** @brief Check that a condition holds. */
+#define TEST_ASSERT_TRUE(condition)                       \
+    do {                                                  \
+        if (!(condition)) {                               \
+            TEST_FAIL_MESSAGE("%s is false", #condition); \
+        }                                                 \
+    } while (0)
+
+/** @brief Check that a condition does not hold. */
+#define TEST_ASSERT_FALSE(condition) TEST_ASSERT_TRUE(!(condition))
+
+/** @brief Check that a pointer is NULL. */
+#define TEST_ASSERT_NULL(pointer) TEST_ASSERT_TRUE((pointer) == NULL)
+
+/** @brief Check that a pointer is not NULL. */
+#define TEST_ASSERT_NOT_NULL(pointer) TEST_ASSERT_TRUE((pointer) != NULL)
+
+/** @brief Check that two integers are equal. */
+#define TEST_ASSERT_EQUAL_INT(expected, actual)                                          \
+    do {                                                                                 \
+        long long expected_ = (long long)(expected);                                     \
+        long long actual_   = (long long)(actual);                                       \
+        if (expected_ != actual_) {                                                      \
+            TEST_FAIL_MESSAGE("%s is %lld, expected %lld", #actual, actual_, expected_); \
+        }                                                                                \
+    } while (0)
+
+/** @brief Check that two NUL-terminated strings are equal. */
+#define TEST_ASSERT_EQUAL_STRING(expected, actual)                                           \
+    do {                                                                                     \
+        const char *expected_ = (expected);                                                  \
+        const char *actual_   = (actual);                                                    \
+        if (strcmp(expected_, actual_) != 0) {                                               \
+            TEST_FAIL_MESSAGE("%s is \"%s\", expected \"%s\"", #actual, actual_, expected_); \
+        }                                                                                    \
+    } while (0)
+
+/** @brief Check that two buffers hold the same bytes. */
+#define TEST_ASSERT_EQUAL_MEMORY(expected, actual, length)               \
+    do {                                                                 \
+        if (memcmp((expected), (actual), (length)) != 0) {               \
+            TEST_FAIL_MESSAGE("%s differs from %s", #actual, #expected); \
+        }                                                                \
+    } while (0)
+
+/** @brief Run one test case and report its outcome. */
+#define RUN_TEST(test_case)                                                                   \
+    do {                                                                                      \
+        int failures_before_ = test_failures;                                                 \
+        test_case();                                                                          \
+        printf("%s %s\n", (test_failures == failures_before_) ? "PASS" : "FAIL", #test_case); \
+    } while (0)
+
+/** @brief Exit status of a test executable. */
+#define TEST_END() ((test_failures == 0) ? 0 : 1)
+
+#endif /* TEST_HARNESS_H */
@@ -0,0 +1,57 @@
+/**
+ * @file test_aht10_conversion.c
+ * @brief Host tests of the fixed-point conversions of the AHT10/AHT20 measurements.
+ */
+
+#include <math.h>
+#include <stdint.h>
+
+#include "aht10_conversion.h"
+#include "test_harness.h"
+
+#define AHT10_RAW_MAX ((1UL << 20) - 1)  ///< Largest 20-bit raw measurement.
+
+static void test_temperature_range(void) {
+    TEST_ASSERT_EQUAL_INT(-5000, aht10_to_centi_celsius(0));
+    TEST_ASSERT_EQUAL_INT(2500, aht10_to_centi_celsius(393216));
+    TEST_ASSERT_EQUAL_INT(5000, aht10_to_centi_celsius(1UL << 19));
+    TEST_ASSERT_EQUAL_INT(15000, aht10_to_centi_celsius(AHT10_RAW_MAX));
+}
+
+static void test_temperature_rounds_to_nearest(void) {
+    // 26 and 27 counts are 0.496 and 0.515 hundredths above -50 degrees.
+    TEST_ASSERT_EQUAL_INT(-5000, aht10_to_centi_celsius(26));
+    TEST_ASSERT_EQUAL_INT(-4999, aht10_to_centi_celsius(27));
+}
+
+static void test_humidity_range(void) {
+    TEST_ASSERT_EQUAL_INT(0, aht10_to_centi_percent(0));
+    TEST_ASSERT_EQUAL_INT(5000, aht10_to_centi_percent(1UL << 19));
+    TEST_ASSERT_EQUAL_INT(10000, aht10_to_centi_percent(AHT10_RAW_MAX));
+}
+
+static void test_humidity_rounds_to_nearest(void) {
+    // 52 and 53 counts are 0.496 and 0.505 hundredths of a percent.
+    TEST_ASSERT_EQUAL_INT(0, aht10_to_centi_percent(52));
+    TEST_ASSERT_EQUAL_INT(1, aht10_to_centi_percent(53));
+}
+
+static void test_every_raw_value_matches_the_datasheet_formulas(void) {
+    for (uint32_t raw = 0; raw <= AHT10_RAW_MAX; raw++) {
+        long temperature = lround((double)raw * 20000.0 / 1048576.0) - 5000;
+        long humidity    = lround((double)raw * 10000.0 / 1048576.0);
+
+        TEST_ASSERT_EQUAL_INT(temperature, aht10_to_centi_celsius(raw));
+        TEST_ASSERT_EQUAL_INT(humidity, aht10_to_centi_percent(raw));
+    }
+}
+
+int main(void) {
+    RUN_TEST(test_temperature_range);
+    RUN_TEST(test_temperature_rounds_to_nearest);
+    RUN_TEST(test_humidity_range);
+    RUN_TEST(test_humidity_rounds_to_nearest);
+    RUN_TEST(test_every_raw_value_matches_the_datasheet_formulas);
+
+    return TEST_END();
+}
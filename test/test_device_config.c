@@ -0,0 +1,269 @@
+/**
+ * @file test_device_config.c
+ * @brief Host tests of the runtime settings: parsing, validation and persistence.
+ */
+
+#include <string.h>
+
+#include "device_config.h"
+#include "nvs.h"
+#include "test_harness.h"
+
+/**
+ * @brief Load the default settings from an empty NVS.
+ *
+ * @return The default settings.
+ */
+static device_config_st load_defaults(void) {
+    device_config_st config = {0};
+
+    nvs_stub_erase_all();
+    device_config_load(&config);
+
+    return config;
+}
+
+/**
+ * @brief Parse a NUL-terminated document on top of the default settings.
+ *
+ * @param[in]  document Document to parse.
+ * @param[out] config   Settings, left to the defaults if the document is rejected.
+ *
+ * @return Result of `device_config_parse()`.
+ */
+static esp_err_t parse(const char *document, device_config_st *config) {
+    *config = load_defaults();
+
+    return device_config_parse(document, strlen(document), config);
+}
+
+/**
+ * @brief Check that a document is rejected and leaves the settings untouched.
+ *
+ * @param[in] document Document to parse.
+ *
+ * @return true if the document was rejected as a whole.
+ */
+static bool is_rejected(const char *document) {
+    device_config_st defaults = load_defaults();
+    device_config_st config   = defaults;
+
+    return (device_config_parse(document, strlen(document), &config) == ESP_ERR_INVALID_ARG) &&
+           device_config_is_equal(&config, &defaults);
+}
+
+static void test_defaults_without_stored_settings(void) {
+    device_config_st config = load_defaults();
+
+    TEST_ASSERT_EQUAL_INT(250, config.sample_period_ms);
+    TEST_ASSERT_EQUAL_INT(30000, config.window_period_ms);
+    TEST_ASSERT_EQUAL_INT(MQTT_PUBLISH_MODE_BATCH, config.publish_mode);
+    TEST_ASSERT_EQUAL_INT(DEVICE_CONFIG_MAX_BATCH_SIZE, config.batch_size);
+    TEST_ASSERT_EQUAL_INT(TELEMETRY_FORMAT_JSON, config.payload_format);
+    TEST_ASSERT_FALSE(config.is_low_power_enabled);
+    TEST_ASSERT_EQUAL_INT(NETWORK_IP_MODE_DHCP, config.ip_mode);
+    TEST_ASSERT_EQUAL_STRING("mqtt://mqtt.eclipseprojects.io", config.mqtt.broker_uri);
+}
+
+static void test_empty_document_changes_nothing(void) {
+    device_config_st defaults = load_defaults();
+    device_config_st config   = {0};
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, parse(" { } ", &config));
+    TEST_ASSERT_TRUE(device_config_is_equal(&config, &defaults));
+}
+
+static void test_every_setting_is_parsed(void) {
+    device_config_st config = {0};
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, parse("{\"sample_period_ms\": 500, \"window_period_ms\": 60000,\n"
+                                        " \"publish_mode\": \"combined\", \"batch_size\": 16, \"format\": \"binary\",\n"
+                                        " \"temperature_deadband\": 25, \"temperature_deadband_percent\": 10,\n"
+                                        " \"humidity_deadband\": 150, \"humidity_deadband_percent\": 20,\n"
+                                        " \"heartbeat_ms\": 900000, \"low_power\": true, \"ip_mode\": \"static_cached\",\n"
+                                        " \"broker_uri\": \"mqtts://broker.local\", \"outbox_limit\": 8192,\n"
+                                        " \"max_in_flight\": 8, \"qos_raw\": 1, \"qos_aggregate\": 2, \"qos_replay\": 0,\n"
+                                        " \"qos_metrics\": 1}",
+                                        &config));
+
+    TEST_ASSERT_EQUAL_INT(500, config.sample_period_ms);
+    TEST_ASSERT_EQUAL_INT(60000, config.window_period_ms);
+    TEST_ASSERT_EQUAL_INT(MQTT_PUBLISH_MODE_COMBINED, config.publish_mode);
+    TEST_ASSERT_EQUAL_INT(16, config.batch_size);
+    TEST_ASSERT_EQUAL_INT(TELEMETRY_FORMAT_BINARY, config.payload_format);
+    TEST_ASSERT_EQUAL_INT(25, config.deadband.temperature.absolute);
+    TEST_ASSERT_EQUAL_INT(10, config.deadband.temperature.percent);
+    TEST_ASSERT_EQUAL_INT(150, config.deadband.humidity.absolute);
+    TEST_ASSERT_EQUAL_INT(20, config.deadband.humidity.percent);
+    TEST_ASSERT_EQUAL_INT(900000, config.deadband.heartbeat_ms);
+    TEST_ASSERT_TRUE(config.is_low_power_enabled);
+    TEST_ASSERT_EQUAL_INT(NETWORK_IP_MODE_STATIC_CACHED, config.ip_mode);
+    TEST_ASSERT_EQUAL_STRING("mqtts://broker.local", config.mqtt.broker_uri);
+    TEST_ASSERT_EQUAL_INT(8192, config.mqtt.outbox_limit);
+    TEST_ASSERT_EQUAL_INT(8, config.mqtt.max_in_flight);
+    TEST_ASSERT_EQUAL_INT(1, config.mqtt.qos[MQTT_CHANNEL_RAW]);
+    TEST_ASSERT_EQUAL_INT(2, config.mqtt.qos[MQTT_CHANNEL_AGGREGATE]);
+    TEST_ASSERT_EQUAL_INT(0, config.mqtt.qos[MQTT_CHANNEL_REPLAY]);
+    TEST_ASSERT_EQUAL_INT(1, config.mqtt.qos[MQTT_CHANNEL_METRICS]);
+}
+
+static void test_document_needs_no_terminator(void) {
+    static const char PAYLOAD[] = "{\"batch_size\": 8}garbage";
+    device_config_st config     = load_defaults();
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, device_config_parse(PAYLOAD, strlen("{\"batch_size\": 8}"), &config));
+    TEST_ASSERT_EQUAL_INT(8, config.batch_size);
+}
+
+static void test_sample_period_is_bound_by_the_window(void) {
+    device_config_st config = {0};
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, parse("{\"sample_period_ms\": 30000}", &config));
+    TEST_ASSERT_EQUAL_INT(ESP_OK, parse("{\"window_period_ms\": 120000, \"sample_period_ms\": 60000}", &config));
+    TEST_ASSERT_TRUE(is_rejected("{\"sample_period_ms\": 30001}"));
+    TEST_ASSERT_TRUE(is_rejected("{\"window_period_ms\": 1000, \"sample_period_ms\": 2000}"));
+}
+
+static void test_outbox_limit_holds_a_batch(void) {
+    device_config_st config = {0};
+    nvs_handle_t handle     = 0;
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, parse("{\"outbox_limit\": 0}", &config));
+    TEST_ASSERT_EQUAL_INT(ESP_OK, parse("{\"outbox_limit\": 2048}", &config));
+    TEST_ASSERT_TRUE(is_rejected("{\"outbox_limit\": 1}"));
+    TEST_ASSERT_TRUE(is_rejected("{\"outbox_limit\": 2047}"));
+
+    // A limit stored by an earlier firmware falls back to the default.
+    nvs_stub_erase_all();
+    nvs_open("mqtt", NVS_READWRITE, &handle);
+    nvs_set_u32(handle, "outbox_limit", 1024);
+    nvs_close(handle);
+    device_config_load(&config);
+    TEST_ASSERT_EQUAL_INT(16384, config.mqtt.outbox_limit);
+}
+
+static void test_heartbeat_lasts_at_least_one_window(void) {
+    device_config_st config = {0};
+    nvs_handle_t handle     = 0;
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, parse("{\"heartbeat_ms\": 30000}", &config));
+    TEST_ASSERT_EQUAL_INT(ESP_OK, parse("{\"window_period_ms\": 3600000, \"heartbeat_ms\": 3600000}", &config));
+    TEST_ASSERT_TRUE(is_rejected("{\"heartbeat_ms\": 0}"));
+    TEST_ASSERT_TRUE(is_rejected("{\"heartbeat_ms\": 29999}"));
+    TEST_ASSERT_TRUE(is_rejected("{\"window_period_ms\": 3600000}"));
+
+    // A stored heartbeat shorter than the window falls back to the default.
+    nvs_stub_erase_all();
+    nvs_open("device", NVS_READWRITE, &handle);
+    nvs_set_u32(handle, "heartbeat", 0);
+    nvs_close(handle);
+    device_config_load(&config);
+    TEST_ASSERT_EQUAL_INT(900000, config.deadband.heartbeat_ms);
+
+    // A stored window longer than the default heartbeat lengthens the heartbeat.
+    nvs_open("device", NVS_READWRITE, &handle);
+    nvs_set_u32(handle, "window_period", 3600000);
+    nvs_close(handle);
+    device_config_load(&config);
+    TEST_ASSERT_EQUAL_INT(3600000, config.deadband.heartbeat_ms);
+}
+
+static void test_malformed_documents_are_rejected(void) {
+    TEST_ASSERT_TRUE(is_rejected(""));
+    TEST_ASSERT_TRUE(is_rejected("{"));
+    TEST_ASSERT_TRUE(is_rejected("[]"));
+    TEST_ASSERT_TRUE(is_rejected("{\"batch_size\": }"));
+    TEST_ASSERT_TRUE(is_rejected("{\"batch_size\" 8}"));
+    TEST_ASSERT_TRUE(is_rejected("{\"batch_size\": 8 \"format\": \"json\"}"));
+    TEST_ASSERT_TRUE(is_rejected("{\"batch_size\": 8,}"));
+    TEST_ASSERT_TRUE(is_rejected("{\"batch_size\": 8} x"));
+    TEST_ASSERT_TRUE(is_rejected("{\"format\": \"js\\\"on\"}"));
+    TEST_ASSERT_TRUE(is_rejected("{\"heartbeat_ms\": 4294967296}"));
+}
+
+static void test_unknown_settings_are_rejected(void) {
+    TEST_ASSERT_TRUE(is_rejected("{\"batch\": 8}"));
+    TEST_ASSERT_TRUE(is_rejected("{\"batch_size\": 8, \"colour\": \"red\"}"));
+}
+
+static void test_out_of_range_values_are_rejected(void) {
+    TEST_ASSERT_TRUE(is_rejected("{\"sample_period_ms\": 99}"));
+    TEST_ASSERT_TRUE(is_rejected("{\"window_period_ms\": 999}"));
+    TEST_ASSERT_TRUE(is_rejected("{\"window_period_ms\": 3600001}"));
+    TEST_ASSERT_TRUE(is_rejected("{\"batch_size\": 0}"));
+    TEST_ASSERT_TRUE(is_rejected("{\"batch_size\": 33}"));
+    TEST_ASSERT_TRUE(is_rejected("{\"format\": \"xml\"}"));
+    TEST_ASSERT_TRUE(is_rejected("{\"publish_mode\": \"burst\"}"));
+    TEST_ASSERT_TRUE(is_rejected("{\"ip_mode\": \"static\"}"));
+    TEST_ASSERT_TRUE(is_rejected("{\"low_power\": 1}"));
+    TEST_ASSERT_TRUE(is_rejected("{\"temperature_deadband\": 65536}"));
+    TEST_ASSERT_TRUE(is_rejected("{\"max_in_flight\": 0}"));
+    TEST_ASSERT_TRUE(is_rejected("{\"max_in_flight\": 256}"));
+    TEST_ASSERT_TRUE(is_rejected("{\"qos_replay\": 3}"));
+    TEST_ASSERT_TRUE(is_rejected("{\"broker_uri\": \"broker.local\"}"));
+    TEST_ASSERT_TRUE(is_rejected("{\"broker_uri\": \"mqtt://\"}"));
+}
+
+static void test_rejected_document_applies_nothing(void) {
+    TEST_ASSERT_TRUE(is_rejected("{\"batch_size\": 8, \"format\": \"xml\"}"));
+}
+
+static void test_settings_survive_a_save_and_load(void) {
+    device_config_st config = {0};
+    device_config_st loaded = {0};
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, parse("{\"sample_period_ms\": 1000, \"window_period_ms\": 600000, \"format\": \"binary\",\n"
+                                        " \"heartbeat_ms\": 1200000, \"low_power\": true, \"ip_mode\": \"static_cached\",\n"
+                                        " \"broker_uri\": \"mqtts://broker.local:8884\", \"qos_metrics\": 1}",
+                                        &config));
+    TEST_ASSERT_EQUAL_INT(ESP_OK, device_config_save(&config));
+    TEST_ASSERT_EQUAL_INT(ESP_OK, device_config_load(&loaded));
+
+    TEST_ASSERT_TRUE(device_config_is_equal(&config, &loaded));
+}
+
+static void test_invalid_settings_are_not_saved(void) {
+    device_config_st config = load_defaults();
+    device_config_st loaded = {0};
+
+    config.window_period_ms = 100;
+
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, device_config_save(&config));
+    TEST_ASSERT_EQUAL_INT(ESP_OK, device_config_load(&loaded));
+    TEST_ASSERT_EQUAL_INT(30000, loaded.window_period_ms);
+}
+
+static void test_is_equal_compares_every_setting(void) {
+    device_config_st defaults = load_defaults();
+    device_config_st config   = defaults;
+
+    config.window_period_ms++;
+    TEST_ASSERT_FALSE(device_config_is_equal(&config, &defaults));
+
+    config                                = defaults;
+    config.mqtt.qos[MQTT_CHANNEL_METRICS] = 2;
+    TEST_ASSERT_FALSE(device_config_is_equal(&config, &defaults));
+
+    config                    = defaults;
+    config.mqtt.broker_uri[0] = 'x';
+    TEST_ASSERT_FALSE(device_config_is_equal(&config, &defaults));
+}
+
+int main(void) {
+    RUN_TEST(test_defaults_without_stored_settings);
+    RUN_TEST(test_empty_document_changes_nothing);
+    RUN_TEST(test_every_setting_is_parsed);
+    RUN_TEST(test_document_needs_no_terminator);
+    RUN_TEST(test_sample_period_is_bound_by_the_window);
+    RUN_TEST(test_outbox_limit_holds_a_batch);
+    RUN_TEST(test_heartbeat_lasts_at_least_one_window);
+    RUN_TEST(test_malformed_documents_are_rejected);
+    RUN_TEST(test_unknown_settings_are_rejected);
+    RUN_TEST(test_out_of_range_values_are_rejected);
+    RUN_TEST(test_rejected_document_applies_nothing);
+    RUN_TEST(test_settings_survive_a_save_and_load);
+    RUN_TEST(test_invalid_settings_are_not_saved);
+    RUN_TEST(test_is_equal_compares_every_setting);
+
+    return TEST_END();
+}
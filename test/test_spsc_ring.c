@@ -0,0 +1,180 @@
+/**
+ * @file test_spsc_ring.c
+ * @brief Host tests of the single-producer/single-consumer ring.
+ */
+
+#include <stdint.h>
+
+#include "spsc_ring.h"
+#include "test_harness.h"
+
+#define TEST_RING_CAPACITY 4  ///< Capacity of the rings under test, small to wrap around quickly.
+
+static uint32_t storage[TEST_RING_CAPACITY] = {0};  ///< Storage of the ring under test.
+static spsc_ring_st ring                    = {0};  ///< Ring under test, reset by every test case.
+
+/**
+ * @brief Reset the ring under test to an empty state.
+ */
+static void reset_ring(void) {
+    spsc_ring_st empty = SPSC_RING_STATIC_INIT(storage, TEST_RING_CAPACITY);
+
+    ring = empty;
+}
+
+/**
+ * @brief Push consecutive values to the ring under test.
+ *
+ * @param[in] first First value pushed.
+ * @param[in] count Number of values to push.
+ *
+ * @return Number of values pushed before the ring was full.
+ */
+static size_t push_values(uint32_t first, size_t count) {
+    size_t pushed = 0;
+
+    for (uint32_t value = first; pushed < count; value++) {
+        if (!spsc_ring_push(&ring, &value)) {
+            break;
+        }
+        pushed++;
+    }
+
+    return pushed;
+}
+
+static void test_empty_ring_has_nothing_to_peek(void) {
+    const void *elements = &ring;
+
+    reset_ring();
+
+    TEST_ASSERT_EQUAL_INT(0, spsc_ring_count(&ring));
+    TEST_ASSERT_EQUAL_INT(0, spsc_ring_peek(&ring, &elements, TEST_RING_CAPACITY));
+    TEST_ASSERT_NULL(elements);
+}
+
+static void test_push_fails_when_full(void) {
+    uint32_t value = 99;
+
+    reset_ring();
+
+    TEST_ASSERT_EQUAL_INT(TEST_RING_CAPACITY, push_values(0, TEST_RING_CAPACITY));
+    TEST_ASSERT_FALSE(spsc_ring_push(&ring, &value));
+    TEST_ASSERT_EQUAL_INT(TEST_RING_CAPACITY, spsc_ring_count(&ring));
+    TEST_ASSERT_EQUAL_INT(TEST_RING_CAPACITY, spsc_ring_high_water_mark(&ring));
+}
+
+static void test_peek_is_limited_by_max_count(void) {
+    const void *elements = NULL;
+
+    reset_ring();
+    push_values(10, 3);
+
+    TEST_ASSERT_EQUAL_INT(2, spsc_ring_peek(&ring, &elements, 2));
+    TEST_ASSERT_EQUAL_INT(10, ((const uint32_t *)elements)[0]);
+    TEST_ASSERT_EQUAL_INT(11, ((const uint32_t *)elements)[1]);
+    TEST_ASSERT_EQUAL_INT(3, spsc_ring_count(&ring));
+}
+
+static void test_peek_stops_at_the_end_of_the_storage(void) {
+    const void *elements = NULL;
+
+    reset_ring();
+    push_values(0, 3);
+    spsc_ring_consume(&ring, 3);
+    push_values(20, 3);
+
+    // Elements sit in slots 3, 0 and 1: the first span ends with the storage.
+    TEST_ASSERT_EQUAL_INT(1, spsc_ring_peek(&ring, &elements, TEST_RING_CAPACITY));
+    TEST_ASSERT_EQUAL_INT(20, ((const uint32_t *)elements)[0]);
+
+    spsc_ring_consume(&ring, 1);
+    TEST_ASSERT_EQUAL_INT(2, spsc_ring_peek(&ring, &elements, TEST_RING_CAPACITY));
+    TEST_ASSERT_EQUAL_INT(21, ((const uint32_t *)elements)[0]);
+    TEST_ASSERT_EQUAL_INT(22, ((const uint32_t *)elements)[1]);
+}
+
+static void test_peek_at_reaches_past_the_wrap_around(void) {
+    const void *elements = NULL;
+
+    reset_ring();
+    push_values(0, 3);
+    spsc_ring_consume(&ring, 3);
+    push_values(30, 4);
+
+    TEST_ASSERT_EQUAL_INT(1, spsc_ring_peek_at(&ring, 0, &elements, TEST_RING_CAPACITY));
+    TEST_ASSERT_EQUAL_INT(30, ((const uint32_t *)elements)[0]);
+    TEST_ASSERT_EQUAL_INT(3, spsc_ring_peek_at(&ring, 1, &elements, TEST_RING_CAPACITY));
+    TEST_ASSERT_EQUAL_INT(31, ((const uint32_t *)elements)[0]);
+    TEST_ASSERT_EQUAL_INT(33, ((const uint32_t *)elements)[2]);
+    TEST_ASSERT_EQUAL_INT(1, spsc_ring_peek_at(&ring, 3, &elements, 1));
+    TEST_ASSERT_EQUAL_INT(33, ((const uint32_t *)elements)[0]);
+
+    // Nothing is released by looking ahead.
+    TEST_ASSERT_EQUAL_INT(4, spsc_ring_count(&ring));
+}
+
+static void test_peek_at_past_the_pending_elements(void) {
+    const void *elements = &ring;
+
+    reset_ring();
+    push_values(0, 2);
+
+    TEST_ASSERT_EQUAL_INT(0, spsc_ring_peek_at(&ring, 2, &elements, TEST_RING_CAPACITY));
+    TEST_ASSERT_NULL(elements);
+}
+
+static void test_consume_is_capped_to_the_pending_elements(void) {
+    reset_ring();
+    push_values(0, 2);
+
+    spsc_ring_consume(&ring, 5);
+
+    TEST_ASSERT_EQUAL_INT(0, spsc_ring_count(&ring));
+    TEST_ASSERT_EQUAL_INT(TEST_RING_CAPACITY, push_values(40, TEST_RING_CAPACITY));
+}
+
+static void test_order_is_kept_over_many_wrap_arounds(void) {
+    const void *elements = NULL;
+    uint32_t expected    = 0;
+
+    reset_ring();
+
+    for (uint32_t round = 0; round < 10; round++) {
+        push_values(round * 3, 3);
+        while (spsc_ring_count(&ring) > 0) {
+            size_t count = spsc_ring_peek(&ring, &elements, TEST_RING_CAPACITY);
+            for (size_t i = 0; i < count; i++) {
+                TEST_ASSERT_EQUAL_INT(expected, ((const uint32_t *)elements)[i]);
+                expected++;
+            }
+            spsc_ring_consume(&ring, count);
+        }
+    }
+
+    TEST_ASSERT_EQUAL_INT(30, expected);
+    TEST_ASSERT_EQUAL_INT(3, spsc_ring_high_water_mark(&ring));
+}
+
+static void test_null_arguments_are_rejected(void) {
+    const void *elements = NULL;
+    uint32_t value       = 0;
+
+    TEST_ASSERT_FALSE(spsc_ring_push(NULL, &value));
+    TEST_ASSERT_EQUAL_INT(0, spsc_ring_peek(NULL, &elements, 1));
+    TEST_ASSERT_EQUAL_INT(0, spsc_ring_count(NULL));
+}
+
+int main(void) {
+    RUN_TEST(test_empty_ring_has_nothing_to_peek);
+    RUN_TEST(test_push_fails_when_full);
+    RUN_TEST(test_peek_is_limited_by_max_count);
+    RUN_TEST(test_peek_stops_at_the_end_of_the_storage);
+    RUN_TEST(test_peek_at_reaches_past_the_wrap_around);
+    RUN_TEST(test_peek_at_past_the_pending_elements);
+    RUN_TEST(test_consume_is_capped_to_the_pending_elements);
+    RUN_TEST(test_order_is_kept_over_many_wrap_arounds);
+    RUN_TEST(test_null_arguments_are_rejected);
+
+    return TEST_END();
+}
@@ -0,0 +1,184 @@
+/**
+ * @file test_telemetry_deadband.c
+ * @brief Host tests of the report-by-exception filter.
+ */
+
+#include <stdint.h>
+
+#include "telemetry_deadband.h"
+#include "test_harness.h"
+
+static const uint32_t HEARTBEAT_MS = 60000;  ///< Heartbeat of the filter under test.
+
+/** @brief Configuration of the filter under test, absolute deadbands only. */
+static const telemetry_deadband_config_st CONFIG = {
+    .temperature  = {.absolute = 50, .percent = 0},
+    .humidity     = {.absolute = 200, .percent = 0},
+    .heartbeat_ms = HEARTBEAT_MS,
+};
+
+/**
+ * @brief Build a sample without spread.
+ *
+ * @param[in] sensor_id    Sensor of the sample.
+ * @param[in] timestamp_ms Acquisition time, in milliseconds of uptime.
+ * @param[in] temperature  Temperature, in centi-degrees Celsius.
+ * @param[in] humidity     Humidity, in centi-percent.
+ *
+ * @return The sample.
+ */
+static temperature_data_st make_sample(uint8_t sensor_id, int64_t timestamp_ms, int16_t temperature, uint16_t humidity) {
+    temperature_data_st sample = {
+        .timestamp_us    = timestamp_ms * 1000,
+        .sensor_id       = sensor_id,
+        .sample_count    = 1,
+        .temperature     = temperature,
+        .temperature_min = temperature,
+        .temperature_max = temperature,
+        .humidity        = humidity,
+        .humidity_min    = humidity,
+        .humidity_max    = humidity,
+    };
+
+    return sample;
+}
+
+static void test_first_sample_of_a_sensor_is_reported(void) {
+    temperature_data_st sample = make_sample(0, 1000, 2100, 4000);
+
+    telemetry_deadband_init(&CONFIG);
+
+    TEST_ASSERT_TRUE(telemetry_deadband_is_reportable(&sample));
+}
+
+static void test_change_within_the_deadband_is_filtered(void) {
+    temperature_data_st first  = make_sample(0, 1000, 2100, 4000);
+    temperature_data_st inside = make_sample(0, 2000, 2150, 4200);
+    temperature_data_st beyond = make_sample(0, 3000, 2151, 4000);
+
+    telemetry_deadband_init(&CONFIG);
+    telemetry_deadband_mark_reported(&first);
+
+    TEST_ASSERT_FALSE(telemetry_deadband_is_reportable(&first));
+    TEST_ASSERT_FALSE(telemetry_deadband_is_reportable(&inside));
+    TEST_ASSERT_TRUE(telemetry_deadband_is_reportable(&beyond));
+
+    beyond = make_sample(0, 3000, 2100, 3799);
+    TEST_ASSERT_TRUE(telemetry_deadband_is_reportable(&beyond));
+}
+
+static void test_spike_of_the_window_is_reported(void) {
+    temperature_data_st first = make_sample(0, 1000, 2100, 4000);
+    temperature_data_st spike = make_sample(0, 2000, 2100, 4000);
+
+    telemetry_deadband_init(&CONFIG);
+    telemetry_deadband_mark_reported(&first);
+
+    // The mean stayed put but the maximum left the deadband.
+    spike.temperature_max = 2200;
+    TEST_ASSERT_TRUE(telemetry_deadband_is_reportable(&spike));
+
+    spike.temperature_max = 2100;
+    spike.humidity_min    = 3700;
+    TEST_ASSERT_TRUE(telemetry_deadband_is_reportable(&spike));
+}
+
+static void test_heartbeat_uses_the_acquisition_times(void) {
+    temperature_data_st first  = make_sample(0, 1000, 2100, 4000);
+    temperature_data_st before = make_sample(0, 1000 + HEARTBEAT_MS - 1, 2100, 4000);
+    temperature_data_st after  = make_sample(0, 1000 + HEARTBEAT_MS, 2100, 4000);
+
+    telemetry_deadband_init(&CONFIG);
+    telemetry_deadband_mark_reported(&first);
+
+    TEST_ASSERT_FALSE(telemetry_deadband_is_reportable(&before));
+    TEST_ASSERT_TRUE(telemetry_deadband_is_reportable(&after));
+
+    // A reported heartbeat restarts the interval.
+    telemetry_deadband_mark_reported(&after);
+    after.timestamp_us += (int64_t)(HEARTBEAT_MS - 1) * 1000;
+    TEST_ASSERT_FALSE(telemetry_deadband_is_reportable(&after));
+}
+
+static void test_relative_deadband(void) {
+    telemetry_deadband_config_st config = {
+        .temperature  = {.absolute = 0, .percent = 100},
+        .humidity     = {.absolute = 0, .percent = 100},
+        .heartbeat_ms = HEARTBEAT_MS,
+    };
+    temperature_data_st first  = make_sample(0, 1000, 2000, 4000);
+    temperature_data_st inside = make_sample(0, 2000, 2020, 4040);
+    temperature_data_st beyond = make_sample(0, 2000, 1979, 4000);
+
+    telemetry_deadband_init(&config);
+    telemetry_deadband_mark_reported(&first);
+
+    // 1 % of 20.00 degrees is 0.20 degrees.
+    TEST_ASSERT_FALSE(telemetry_deadband_is_reportable(&inside));
+    TEST_ASSERT_TRUE(telemetry_deadband_is_reportable(&beyond));
+}
+
+static void test_disabled_deadband_reports_any_change(void) {
+    telemetry_deadband_config_st config = {.heartbeat_ms = HEARTBEAT_MS};
+    temperature_data_st first           = make_sample(0, 1000, 2000, 4000);
+    temperature_data_st changed         = make_sample(0, 2000, 2001, 4000);
+
+    telemetry_deadband_init(&config);
+    telemetry_deadband_mark_reported(&first);
+
+    TEST_ASSERT_FALSE(telemetry_deadband_is_reportable(&first));
+    TEST_ASSERT_TRUE(telemetry_deadband_is_reportable(&changed));
+}
+
+static void test_sensors_are_tracked_separately(void) {
+    temperature_data_st first     = make_sample(0, 1000, 2100, 4000);
+    temperature_data_st other     = make_sample(1, 1000, 2100, 4000);
+    temperature_data_st untracked = make_sample(TELEMETRY_DEADBAND_MAX_SENSORS, 1000, 2100, 4000);
+
+    telemetry_deadband_init(&CONFIG);
+    telemetry_deadband_mark_reported(&first);
+    telemetry_deadband_mark_reported(&untracked);
+
+    TEST_ASSERT_TRUE(telemetry_deadband_is_reportable(&other));
+    TEST_ASSERT_TRUE(telemetry_deadband_is_reportable(&untracked));
+}
+
+static void test_rollback_forgets_the_reports_since_the_checkpoint(void) {
+    temperature_data_st first  = make_sample(0, 1000, 2100, 4000);
+    temperature_data_st second = make_sample(0, 2000, 2300, 4000);
+
+    telemetry_deadband_init(&CONFIG);
+    telemetry_deadband_mark_reported(&first);
+
+    telemetry_deadband_checkpoint();
+    telemetry_deadband_mark_reported(&second);
+    TEST_ASSERT_FALSE(telemetry_deadband_is_reportable(&second));
+
+    telemetry_deadband_rollback();
+    TEST_ASSERT_TRUE(telemetry_deadband_is_reportable(&second));
+    TEST_ASSERT_FALSE(telemetry_deadband_is_reportable(&first));
+}
+
+static void test_init_forgets_every_report(void) {
+    temperature_data_st first = make_sample(0, 1000, 2100, 4000);
+
+    telemetry_deadband_init(&CONFIG);
+    telemetry_deadband_mark_reported(&first);
+    telemetry_deadband_init(&CONFIG);
+
+    TEST_ASSERT_TRUE(telemetry_deadband_is_reportable(&first));
+}
+
+int main(void) {
+    RUN_TEST(test_first_sample_of_a_sensor_is_reported);
+    RUN_TEST(test_change_within_the_deadband_is_filtered);
+    RUN_TEST(test_spike_of_the_window_is_reported);
+    RUN_TEST(test_heartbeat_uses_the_acquisition_times);
+    RUN_TEST(test_relative_deadband);
+    RUN_TEST(test_disabled_deadband_reports_any_change);
+    RUN_TEST(test_sensors_are_tracked_separately);
+    RUN_TEST(test_rollback_forgets_the_reports_since_the_checkpoint);
+    RUN_TEST(test_init_forgets_every_report);
+
+    return TEST_END();
+}
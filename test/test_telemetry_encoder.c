@@ -0,0 +1,206 @@
+/**
+ * @file test_telemetry_encoder.c
+ * @brief Host tests of the JSON and binary telemetry encoders.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "telemetry_encoder.h"
+#include "test_harness.h"
+
+static const int64_t BATCH_TIMESTAMP_MS = 1700000000123;  ///< 2023-11-14T22:13:20.123Z.
+
+/** @brief JSON document of a batch holding `SAMPLE` only. */
+static const char SAMPLE_JSON[] =
+    "{\"timestamp\": \"2023-11-14T22:13:20.123\", \"samples\": [{\"sensor\": 1, \"seq\": 42, \"offset_ms\": 1500, \"count\": 120, "
+    "\"temperature\": 21.53, \"temperature_min\": 21.40, \"temperature_max\": 21.71, \"temperature_stddev\": 0.06, "
+    "\"humidity\": 40.12, \"humidity_min\": 39.80, \"humidity_max\": 40.35, \"humidity_stddev\": 0.11}]}";
+
+/** @brief Aggregated sample encoded by the test cases. */
+static const temperature_data_st SAMPLE = {
+    .sensor_id          = 1,
+    .sequence           = 42,
+    .sample_count       = 120,
+    .temperature        = 2153,
+    .temperature_min    = 2140,
+    .temperature_max    = 2171,
+    .temperature_stddev = 6,
+    .humidity           = 4012,
+    .humidity_min       = 3980,
+    .humidity_max       = 4035,
+    .humidity_stddev    = 11,
+};
+
+static void test_json_payload_of_one_sample(void) {
+    uint8_t buffer[512]          = {0};
+    telemetry_encoder_st encoder = {0};
+    size_t length                = 0;
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_encoder_begin(&encoder, TELEMETRY_FORMAT_JSON, buffer, sizeof(buffer), BATCH_TIMESTAMP_MS));
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_encoder_append(&encoder, &SAMPLE, BATCH_TIMESTAMP_MS + 1500));
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_encoder_finish(&encoder, &length));
+
+    TEST_ASSERT_EQUAL_INT(strlen(SAMPLE_JSON), length);
+    TEST_ASSERT_EQUAL_STRING(SAMPLE_JSON, (const char *)buffer);
+}
+
+static void test_json_payload_without_samples(void) {
+    uint8_t buffer[128]          = {0};
+    telemetry_encoder_st encoder = {0};
+    size_t length                = 0;
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_encoder_begin(&encoder, TELEMETRY_FORMAT_JSON, buffer, sizeof(buffer), BATCH_TIMESTAMP_MS));
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_encoder_finish(&encoder, &length));
+
+    TEST_ASSERT_EQUAL_STRING("{\"timestamp\": \"2023-11-14T22:13:20.123\", \"samples\": []}", (const char *)buffer);
+}
+
+static void test_json_timestamp_before_the_epoch(void) {
+    uint8_t buffer[128]          = {0};
+    telemetry_encoder_st encoder = {0};
+    size_t length                = 0;
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_encoder_begin(&encoder, TELEMETRY_FORMAT_JSON, buffer, sizeof(buffer), -1));
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_encoder_finish(&encoder, &length));
+    TEST_ASSERT_EQUAL_STRING("{\"timestamp\": \"1969-12-31T23:59:59.999\", \"samples\": []}", (const char *)buffer);
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_encoder_begin(&encoder, TELEMETRY_FORMAT_JSON, buffer, sizeof(buffer), -1000));
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_encoder_finish(&encoder, &length));
+    TEST_ASSERT_EQUAL_STRING("{\"timestamp\": \"1969-12-31T23:59:59.000\", \"samples\": []}", (const char *)buffer);
+}
+
+static void test_json_prints_negative_hundredths(void) {
+    uint8_t buffer[512]          = {0};
+    telemetry_encoder_st encoder = {0};
+    temperature_data_st sample   = SAMPLE;
+    size_t length                = 0;
+
+    sample.temperature     = -305;
+    sample.temperature_min = -5;
+
+    telemetry_encoder_begin(&encoder, TELEMETRY_FORMAT_JSON, buffer, sizeof(buffer), BATCH_TIMESTAMP_MS);
+    telemetry_encoder_append(&encoder, &sample, BATCH_TIMESTAMP_MS - 250);
+    telemetry_encoder_finish(&encoder, &length);
+
+    TEST_ASSERT_NOT_NULL(strstr((const char *)buffer, "\"offset_ms\": -250,"));
+    TEST_ASSERT_NOT_NULL(strstr((const char *)buffer, "\"temperature\": -3.05,"));
+    TEST_ASSERT_NOT_NULL(strstr((const char *)buffer, "\"temperature_min\": -0.05,"));
+}
+
+static void test_json_sample_that_does_not_fit_is_left_out(void) {
+    uint8_t buffer[sizeof(SAMPLE_JSON) + 64] = {0};
+    telemetry_encoder_st encoder             = {0};
+    size_t length                            = 0;
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_encoder_begin(&encoder, TELEMETRY_FORMAT_JSON, buffer, sizeof(buffer), BATCH_TIMESTAMP_MS));
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_encoder_append(&encoder, &SAMPLE, BATCH_TIMESTAMP_MS + 1500));
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_NO_MEM, telemetry_encoder_append(&encoder, &SAMPLE, BATCH_TIMESTAMP_MS + 1500));
+    TEST_ASSERT_EQUAL_INT(1, encoder.sample_count);
+
+    // The payload still completes into a valid document.
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_encoder_finish(&encoder, &length));
+    TEST_ASSERT_EQUAL_STRING(SAMPLE_JSON, (const char *)buffer);
+}
+
+static void test_json_buffer_too_small_for_the_header(void) {
+    uint8_t buffer[32]           = {0};
+    telemetry_encoder_st encoder = {0};
+
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_NO_MEM, telemetry_encoder_begin(&encoder, TELEMETRY_FORMAT_JSON, buffer, sizeof(buffer), BATCH_TIMESTAMP_MS));
+}
+
+static void test_binary_payload_of_one_sample(void) {
+    static const uint8_t EXPECTED[TELEMETRY_BINARY_HEADER_SIZE + TELEMETRY_BINARY_SAMPLE_SIZE] = {
+        // Header: version, reserved, 1 sample, batch timestamp.
+        TELEMETRY_BINARY_VERSION, 0x00, 0x01, 0x00, 0x7B, 0x68, 0xE5, 0xCF, 0x8B, 0x01, 0x00, 0x00,
+        // Sensor 1, reserved, 120 readings, sequence 42, offset 1500 ms.
+        0x01, 0x00, 0x78, 0x00, 0x2A, 0x00, 0x00, 0x00, 0xDC, 0x05, 0x00, 0x00,
+        // Temperature mean, min, max, stddev.
+        0x69, 0x08, 0x5C, 0x08, 0x7B, 0x08, 0x06, 0x00,
+        // Humidity mean, min, max, stddev.
+        0xAC, 0x0F, 0x8C, 0x0F, 0xC3, 0x0F, 0x0B, 0x00,
+    };
+    uint8_t buffer[sizeof(EXPECTED)] = {0};
+    telemetry_encoder_st encoder     = {0};
+    size_t length                    = 0;
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_encoder_begin(&encoder, TELEMETRY_FORMAT_BINARY, buffer, sizeof(buffer), BATCH_TIMESTAMP_MS));
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_encoder_append(&encoder, &SAMPLE, BATCH_TIMESTAMP_MS + 1500));
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_encoder_finish(&encoder, &length));
+
+    TEST_ASSERT_EQUAL_INT(sizeof(EXPECTED), length);
+    TEST_ASSERT_EQUAL_MEMORY(EXPECTED, buffer, sizeof(EXPECTED));
+}
+
+static void test_binary_encodes_negative_values_in_twos_complement(void) {
+    uint8_t buffer[TELEMETRY_BINARY_HEADER_SIZE + TELEMETRY_BINARY_SAMPLE_SIZE] = {0};
+    telemetry_encoder_st encoder                                                = {0};
+    temperature_data_st sample                                                  = SAMPLE;
+    size_t length                                                               = 0;
+
+    sample.temperature = -305;
+
+    telemetry_encoder_begin(&encoder, TELEMETRY_FORMAT_BINARY, buffer, sizeof(buffer), BATCH_TIMESTAMP_MS);
+    telemetry_encoder_append(&encoder, &sample, BATCH_TIMESTAMP_MS - 2);
+    telemetry_encoder_finish(&encoder, &length);
+
+    const uint8_t *record = &buffer[TELEMETRY_BINARY_HEADER_SIZE];
+    TEST_ASSERT_EQUAL_INT(0xFE, record[8]);
+    TEST_ASSERT_EQUAL_INT(0xFF, record[11]);
+    TEST_ASSERT_EQUAL_INT(0xCF, record[12]);
+    TEST_ASSERT_EQUAL_INT(0xFE, record[13]);
+}
+
+static void test_binary_sample_that_does_not_fit_is_left_out(void) {
+    uint8_t buffer[TELEMETRY_BINARY_HEADER_SIZE + TELEMETRY_BINARY_SAMPLE_SIZE + 10] = {0};
+    telemetry_encoder_st encoder                                                     = {0};
+    size_t length                                                                    = 0;
+
+    telemetry_encoder_begin(&encoder, TELEMETRY_FORMAT_BINARY, buffer, sizeof(buffer), BATCH_TIMESTAMP_MS);
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_encoder_append(&encoder, &SAMPLE, BATCH_TIMESTAMP_MS));
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_NO_MEM, telemetry_encoder_append(&encoder, &SAMPLE, BATCH_TIMESTAMP_MS));
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_encoder_finish(&encoder, &length));
+
+    TEST_ASSERT_EQUAL_INT(TELEMETRY_BINARY_HEADER_SIZE + TELEMETRY_BINARY_SAMPLE_SIZE, length);
+    TEST_ASSERT_EQUAL_INT(1, buffer[2]);
+}
+
+static void test_binary_buffer_too_small_for_the_header(void) {
+    uint8_t buffer[TELEMETRY_BINARY_HEADER_SIZE - 1] = {0};
+    telemetry_encoder_st encoder                     = {0};
+
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_NO_MEM, telemetry_encoder_begin(&encoder, TELEMETRY_FORMAT_BINARY, buffer, sizeof(buffer), BATCH_TIMESTAMP_MS));
+}
+
+static void test_offset_out_of_range_is_rejected(void) {
+    uint8_t buffer[128]          = {0};
+    telemetry_encoder_st encoder = {0};
+
+    telemetry_encoder_begin(&encoder, TELEMETRY_FORMAT_BINARY, buffer, sizeof(buffer), BATCH_TIMESTAMP_MS);
+
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, telemetry_encoder_append(&encoder, &SAMPLE, BATCH_TIMESTAMP_MS + INT32_MAX + 1LL));
+    TEST_ASSERT_EQUAL_INT(0, encoder.sample_count);
+}
+
+int main(void) {
+    // The batch timestamp is formatted in local time.
+    setenv("TZ", "UTC0", 1);
+    tzset();
+
+    RUN_TEST(test_json_payload_of_one_sample);
+    RUN_TEST(test_json_payload_without_samples);
+    RUN_TEST(test_json_timestamp_before_the_epoch);
+    RUN_TEST(test_json_prints_negative_hundredths);
+    RUN_TEST(test_json_sample_that_does_not_fit_is_left_out);
+    RUN_TEST(test_json_buffer_too_small_for_the_header);
+    RUN_TEST(test_binary_payload_of_one_sample);
+    RUN_TEST(test_binary_encodes_negative_values_in_twos_complement);
+    RUN_TEST(test_binary_sample_that_does_not_fit_is_left_out);
+    RUN_TEST(test_binary_buffer_too_small_for_the_header);
+    RUN_TEST(test_offset_out_of_range_is_rejected);
+
+    return TEST_END();
+}
@@ -0,0 +1,133 @@
+/**
+ * @file test_telemetry_store.c
+ * @brief Host tests of the flash log buffering samples while offline.
+ *
+ * The log is mounted once over the RAM partition of the stubs and every test
+ * case leaves it empty, so the records of a case are appended to the slots
+ * following those of the previous one.
+ */
+
+#include <stdint.h>
+
+#include "esp_partition.h"
+#include "telemetry_store.h"
+#include "test_harness.h"
+
+#define STORE_HEADER_SIZE 16  ///< Size of a sector header, as laid out by the store.
+#define STORE_RECORD_SIZE 36  ///< Size of a record, as laid out by the store.
+#define PEEK_CAPACITY 8       ///< Largest number of records peeked at once.
+
+static const esp_partition_t *partition = NULL;  ///< Partition holding the log.
+static uint32_t next_slot               = 0;     ///< Slot of the first sector the next appended record goes to.
+
+/**
+ * @brief Append a record whose sequence number identifies it.
+ *
+ * @param[in] sequence Sequence number of the sample.
+ *
+ * @return Slot the record was written to.
+ */
+static uint32_t append_record(uint32_t sequence) {
+    telemetry_store_record_st record = {.timestamp_ms = 1700000000000 + sequence};
+
+    record.sample.sensor_id = 1;
+    record.sample.sequence  = sequence;
+    telemetry_store_append(&record);
+
+    return next_slot++;
+}
+
+/**
+ * @brief Tear a record as a power loss in the middle of its write would.
+ *
+ * @param[in] slot Slot of the record, in the first sector.
+ */
+static void tear_record(uint32_t slot) {
+    static const uint8_t CLEARED[4] = {0};
+
+    // Clear the sequence number, the CRC no longer matches.
+    esp_partition_write(partition, STORE_HEADER_SIZE + (slot * STORE_RECORD_SIZE) + 30, CLEARED, sizeof(CLEARED));
+}
+
+static void test_mount_of_a_blank_partition(void) {
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_store_init());
+    TEST_ASSERT_TRUE(telemetry_store_is_empty());
+}
+
+static void test_records_are_replayed_in_order(void) {
+    telemetry_store_record_st records[PEEK_CAPACITY] = {0};
+    size_t count                                     = 0;
+
+    append_record(11);
+    append_record(12);
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_store_peek(records, PEEK_CAPACITY, &count));
+    TEST_ASSERT_EQUAL_INT(2, count);
+    TEST_ASSERT_EQUAL_INT(11, records[0].sample.sequence);
+    TEST_ASSERT_EQUAL_INT(1700000000011, records[0].timestamp_ms);
+    TEST_ASSERT_EQUAL_INT(12, records[1].sample.sequence);
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_store_consume(count));
+    TEST_ASSERT_TRUE(telemetry_store_is_empty());
+}
+
+static void test_torn_record_in_the_middle_is_skipped(void) {
+    telemetry_store_record_st records[PEEK_CAPACITY] = {0};
+    size_t count                                     = 0;
+
+    append_record(21);
+    tear_record(append_record(22));
+    append_record(23);
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_store_peek(records, PEEK_CAPACITY, &count));
+    TEST_ASSERT_EQUAL_INT(2, count);
+    TEST_ASSERT_EQUAL_INT(21, records[0].sample.sequence);
+    TEST_ASSERT_EQUAL_INT(23, records[1].sample.sequence);
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_store_consume(1));
+    TEST_ASSERT_FALSE(telemetry_store_is_empty());
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_store_peek(records, PEEK_CAPACITY, &count));
+    TEST_ASSERT_EQUAL_INT(1, count);
+    TEST_ASSERT_EQUAL_INT(23, records[0].sample.sequence);
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_store_consume(1));
+    TEST_ASSERT_TRUE(telemetry_store_is_empty());
+}
+
+static void test_torn_records_at_the_end_leave_the_log_empty(void) {
+    telemetry_store_record_st records[PEEK_CAPACITY] = {0};
+    size_t count                                     = 0;
+
+    append_record(31);
+    tear_record(append_record(32));
+    tear_record(append_record(33));
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_store_peek(records, PEEK_CAPACITY, &count));
+    TEST_ASSERT_EQUAL_INT(1, count);
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_store_consume(count));
+    TEST_ASSERT_TRUE(telemetry_store_is_empty());
+    TEST_ASSERT_EQUAL_INT(ESP_OK, telemetry_store_peek(records, PEEK_CAPACITY, &count));
+    TEST_ASSERT_EQUAL_INT(0, count);
+}
+
+static void test_null_arguments_are_rejected(void) {
+    telemetry_store_record_st records[PEEK_CAPACITY] = {0};
+    size_t count                                     = 0;
+
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, telemetry_store_append(NULL));
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, telemetry_store_peek(NULL, PEEK_CAPACITY, &count));
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_ARG, telemetry_store_peek(records, PEEK_CAPACITY, NULL));
+}
+
+int main(void) {
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, 0x40, "telemetry");
+
+    RUN_TEST(test_mount_of_a_blank_partition);
+    RUN_TEST(test_records_are_replayed_in_order);
+    RUN_TEST(test_torn_record_in_the_middle_is_skipped);
+    RUN_TEST(test_torn_records_at_the_end_leave_the_log_empty);
+    RUN_TEST(test_null_arguments_are_rejected);
+
+    return TEST_END();
+}
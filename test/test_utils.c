@@ -0,0 +1,78 @@
+/**
+ * @file test_utils.c
+ * @brief Host tests of the formatting helpers.
+ */
+
+#include <string.h>
+
+#include "test_harness.h"
+#include "utils.h"
+
+static void test_format_centi(void) {
+    char buffer[16] = {0};
+
+    TEST_ASSERT_EQUAL_INT(4, format_centi(buffer, sizeof(buffer), 0));
+    TEST_ASSERT_EQUAL_STRING("0.00", buffer);
+    format_centi(buffer, sizeof(buffer), 5);
+    TEST_ASSERT_EQUAL_STRING("0.05", buffer);
+    format_centi(buffer, sizeof(buffer), -5);
+    TEST_ASSERT_EQUAL_STRING("-0.05", buffer);
+    format_centi(buffer, sizeof(buffer), -305);
+    TEST_ASSERT_EQUAL_STRING("-3.05", buffer);
+    format_centi(buffer, sizeof(buffer), 2150);
+    TEST_ASSERT_EQUAL_STRING("21.50", buffer);
+    format_centi(buffer, sizeof(buffer), 1000000);
+    TEST_ASSERT_EQUAL_STRING("10000.00", buffer);
+}
+
+static void test_format_centi_truncates_like_snprintf(void) {
+    char buffer[4] = {0};
+
+    TEST_ASSERT_EQUAL_INT(5, format_centi(buffer, sizeof(buffer), 2153));
+    TEST_ASSERT_EQUAL_STRING("21.", buffer);
+}
+
+static void test_format_append_builds_a_document(void) {
+    char buffer[32] = {0};
+    size_t length   = 0;
+
+    TEST_ASSERT_TRUE(format_append(buffer, sizeof(buffer), &length, "{\"count\": %d", 3));
+    TEST_ASSERT_TRUE(format_append(buffer, sizeof(buffer), &length, "%s", "}"));
+
+    TEST_ASSERT_EQUAL_STRING("{\"count\": 3}", buffer);
+    TEST_ASSERT_EQUAL_INT(strlen(buffer), length);
+}
+
+static void test_format_append_leaves_out_text_that_does_not_fit(void) {
+    char buffer[8] = {0};
+    size_t length  = 0;
+
+    TEST_ASSERT_TRUE(format_append(buffer, sizeof(buffer), &length, "abc"));
+    TEST_ASSERT_FALSE(format_append(buffer, sizeof(buffer), &length, "defgh"));
+    TEST_ASSERT_EQUAL_STRING("abc", buffer);
+    TEST_ASSERT_EQUAL_INT(3, length);
+
+    // The text may take every byte but the one of the terminator.
+    TEST_ASSERT_TRUE(format_append(buffer, sizeof(buffer), &length, "defg"));
+    TEST_ASSERT_EQUAL_STRING("abcdefg", buffer);
+    TEST_ASSERT_FALSE(format_append(buffer, sizeof(buffer), &length, "h"));
+    TEST_ASSERT_EQUAL_INT(7, length);
+}
+
+static void test_format_append_to_a_full_document(void) {
+    char buffer[4] = {0};
+    size_t length  = sizeof(buffer);
+
+    TEST_ASSERT_FALSE(format_append(buffer, sizeof(buffer), &length, "x"));
+    TEST_ASSERT_EQUAL_INT(sizeof(buffer), length);
+}
+
+int main(void) {
+    RUN_TEST(test_format_centi);
+    RUN_TEST(test_format_centi_truncates_like_snprintf);
+    RUN_TEST(test_format_append_builds_a_document);
+    RUN_TEST(test_format_append_leaves_out_text_that_does_not_fit);
+    RUN_TEST(test_format_append_to_a_full_document);
+
+    return TEST_END();
+}
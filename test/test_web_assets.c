@@ -0,0 +1,56 @@
+/**
+ * @file test_web_assets.c
+ * @brief Host tests of the lookup of the embedded web assets.
+ */
+
+#include "test_harness.h"
+#include "web_assets.h"
+
+/**
+ * @brief Asset table standing in for the one generated by tools/embed_assets.py, sorted by URI.
+ */
+const web_asset_st web_assets[] = {
+    {.uri = "/"},
+    {.uri = "/app.js"},
+    {.uri = "/favicon.ico"},
+    {.uri = "/index.html"},
+    {.uri = "/styles.css"},
+};
+
+const size_t web_assets_count = sizeof(web_assets) / sizeof(web_assets[0]);
+
+static void test_every_asset_is_found(void) {
+    for (size_t i = 0; i < web_assets_count; i++) {
+        TEST_ASSERT_TRUE(web_assets_find(web_assets[i].uri) == &web_assets[i]);
+    }
+}
+
+static void test_query_string_is_ignored(void) {
+    TEST_ASSERT_TRUE(web_assets_find("/index.html?v=3") == &web_assets[3]);
+    TEST_ASSERT_TRUE(web_assets_find("/app.js?") == &web_assets[1]);
+    TEST_ASSERT_TRUE(web_assets_find("/?lang=fr&x=/styles.css") == &web_assets[0]);
+}
+
+static void test_only_whole_paths_match(void) {
+    TEST_ASSERT_NULL(web_assets_find("/index"));
+    TEST_ASSERT_NULL(web_assets_find("/index.html5"));
+    TEST_ASSERT_NULL(web_assets_find("/index.html/"));
+    TEST_ASSERT_NULL(web_assets_find("/index?.html"));
+    TEST_ASSERT_NULL(web_assets_find("/zzz"));
+    TEST_ASSERT_NULL(web_assets_find("/a"));
+}
+
+static void test_empty_path_is_not_found(void) {
+    TEST_ASSERT_NULL(web_assets_find(""));
+    TEST_ASSERT_NULL(web_assets_find("?/"));
+    TEST_ASSERT_NULL(web_assets_find(NULL));
+}
+
+int main(void) {
+    RUN_TEST(test_every_asset_is_found);
+    RUN_TEST(test_query_string_is_ignored);
+    RUN_TEST(test_only_whole_paths_match);
+    RUN_TEST(test_empty_path_is_not_found);
+
+    return TEST_END();
+}
@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+"""Embed the web UI assets in the firmware image.
+
+HTML assets are minified and the local stylesheets, scripts and icons they
+reference are inlined in them, so a page is served in a single response.
+Every asset is then gzip-compressed (unless compression does not make it
+smaller) and written as a C array to a single source file, together with
+its URI, content type and a strong ETag derived from the served bytes. The
+generated file defines the `web_assets` table declared in
+lib/HTTPServer/web_assets.h, sorted by URI so the HTTP server can look
+assets up with a binary search.
+
+usage: embed_assets.py OUTPUT.c ASSET [ASSET...]
+"""
+
+import base64
+import gzip
+import hashlib
+import os
+import re
+import sys
+
+CONTENT_TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "text/javascript",
+    ".ico": "image/x-icon",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+    ".png": "image/png",
+}
+
+INDEX_FILE = "index.html"
+HTML_CACHE_CONTROL = "no-cache"
+ASSET_CACHE_CONTROL = "public, max-age=604800"
+BYTES_PER_LINE = 16
+
+
+def asset_uri(name):
+    return "/" if name == INDEX_FILE else "/" + name
+
+
+def c_identifier(name):
+    return "".join(c if c.isalnum() else "_" for c in name)
+
+
+def c_array(data):
+    lines = []
+    for i in range(0, len(data), BYTES_PER_LINE):
+        chunk = data[i:i + BYTES_PER_LINE]
+        lines.append("    " + ", ".join("0x%02x" % b for b in chunk) + ",")
+    return "\n".join(lines)
+
+
+def minify_css(text):
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    text = re.sub(r"\s+", " ", text)
+    text = re.sub(r"\s*([{}:;,>])\s*", r"\1", text)
+    return text.replace(";}", "}").strip()
+
+
+def minify_js(text):
+    # Only drop indentation and blank lines, line breaks are kept so automatic
+    # semicolon insertion behaves as in the source.
+    lines = (line.strip() for line in text.splitlines())
+    return "\n".join(line for line in lines if line)
+
+
+def minify_html(text):
+    text = re.sub(r"<!--.*?-->", "", text, flags=re.S)
+    text = re.sub(r">\s+<", "><", text)
+    text = re.sub(r"\s*\n\s*", " ", text)
+    return text.strip()
+
+
+def read_local(base_dir, reference):
+    if "://" in reference or reference.startswith("data:"):
+        return None
+    path = os.path.join(base_dir, reference.lstrip("/"))
+    if not os.path.isfile(path):
+        raise SystemExit("embed_assets: %s references missing file %s" % (base_dir, reference))
+    with open(path, "rb") as referenced:
+        return referenced.read()
+
+
+def inline_html(path, raw):
+    base_dir = os.path.dirname(path)
+    html = minify_html(raw.decode("utf-8"))
+
+    def inline_style(match):
+        content = read_local(base_dir, match.group(1))
+        if content is None:
+            return match.group(0)
+        return "<style>%s</style>" % minify_css(content.decode("utf-8"))
+
+    def inline_script(match):
+        content = read_local(base_dir, match.group(1))
+        if content is None:
+            return match.group(0)
+        script = minify_js(content.decode("utf-8"))
+        if "</script" in script.lower():
+            raise SystemExit("embed_assets: %s cannot be inlined" % match.group(1))
+        return "<script>%s</script>" % script
+
+    def inline_icon(match):
+        content = read_local(base_dir, match.group(2))
+        if content is None:
+            return match.group(0)
+        extension = os.path.splitext(match.group(2))[1].lower()
+        return '%s"data:%s;base64,%s"' % (match.group(1), CONTENT_TYPES[extension], base64.b64encode(content).decode())
+
+    html = re.sub(r'<link rel="stylesheet"[^>]*href="([^"]+)"[^>]*>', inline_style, html)
+    html = re.sub(r'<script[^>]*\ssrc="([^"]+)"[^>]*></script>', inline_script, html)
+    html = re.sub(r'(<link rel="icon"[^>]*href=)"([^"]+)"', inline_icon, html)
+
+    return html.encode("utf-8")
+
+
+def load_asset(path):
+    name = os.path.basename(path)
+    extension = os.path.splitext(name)[1].lower()
+    if extension not in CONTENT_TYPES:
+        raise SystemExit("embed_assets: unknown content type for %s" % path)
+
+    with open(path, "rb") as asset_file:
+        raw = asset_file.read()
+
+    if extension == ".html":
+        raw = inline_html(path, raw)
+
+    # A fixed mtime keeps the output, and therefore the ETag, reproducible.
+    compressed = gzip.compress(raw, compresslevel=9, mtime=0)
+    is_gzip = len(compressed) < len(raw)
+    data = compressed if is_gzip else raw
+
+    return {
+        "name": name,
+        "identifier": c_identifier(name),
+        "uri": asset_uri(name),
+        "content_type": CONTENT_TYPES[extension],
+        "cache_control": HTML_CACHE_CONTROL if extension == ".html" else ASSET_CACHE_CONTROL,
+        "etag": '"%s"' % hashlib.sha256(data).hexdigest()[:16],
+        "data": data,
+        "is_gzip": is_gzip,
+        "raw_size": len(raw),
+    }
+
+
+def render(assets):
+    out = [
+        "/**",
+        " * @file web_assets_data.c",
+        " * @brief Web UI assets, generated by tools/embed_assets.py. Do not edit.",
+        " */",
+        "",
+        "#include \"web_assets.h\"",
+        "",
+    ]
+
+    for asset in assets:
+        out.append("/** @brief %s, %d bytes served for %d bytes of source. */" %
+                   (asset["name"], len(asset["data"]), asset["raw_size"]))
+        out.append("static const uint8_t asset_%s[] = {" % asset["identifier"])
+        out.append(c_array(asset["data"]))
+        out.append("};")
+        out.append("")
+
+    out.append("const web_asset_st web_assets[] = {")
+    for asset in assets:
+        out.append("    {")
+        out.append("        .uri           = \"%s\"," % asset["uri"])
+        out.append("        .content_type  = \"%s\"," % asset["content_type"])
+        out.append("        .cache_control = \"%s\"," % asset["cache_control"])
+        out.append("        .etag          = \"%s\"," % asset["etag"].replace('"', '\\"'))
+        out.append("        .data          = asset_%s," % asset["identifier"])
+        out.append("        .length        = sizeof(asset_%s)," % asset["identifier"])
+        out.append("        .is_gzip       = %s," % ("true" if asset["is_gzip"] else "false"))
+        out.append("    },")
+    out.append("};")
+    out.append("")
+    out.append("const size_t web_assets_count = sizeof(web_assets) / sizeof(web_assets[0]);")
+    out.append("")
+
+    return "\n".join(out)
+
+
+def main(argv):
+    if len(argv) < 3:
+        raise SystemExit(__doc__)
+
+    output = argv[1]
+    assets = sorted((load_asset(path) for path in argv[2:]), key=lambda asset: asset["uri"].encode())
+    uris = [asset["uri"] for asset in assets]
+    if len(set(uris)) != len(uris):
+        raise SystemExit("embed_assets: several assets share a URI")
+    content = render(assets)
+
+    # Leave the file untouched when nothing changed to avoid needless rebuilds.
+    if os.path.exists(output):
+        with open(output, "r") as current:
+            if current.read() == content:
+                return
+
+    os.makedirs(os.path.dirname(os.path.abspath(output)), exist_ok=True)
+    with open(output, "w") as generated:
+        generated.write(content)
+
+
+if __name__ == "__main__":
+    main(sys.argv)